@@ -1,9 +1,12 @@
 #include "ast_block.hpp"
+#include "ast_query.hpp"
 #include "ast_token.hpp"
 #include "ast_type.hpp"
 #include "ast_statement.hpp"
 #include "error_table.hpp"
+#include "json_writer.hpp"
 #include "miz_controller.hpp"
+#include "phase_profiler.hpp"
 #include "token_table.hpp"
 #include "py_ast_element.hpp"
 #include "py_ast_token.hpp"
@@ -17,7 +20,15 @@
 #include "py_keyword_token.hpp"
 #include "py_comment_token.hpp"
 
+#include <climits>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <string_view>
+#include <vector>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -31,8 +42,14 @@ using mizcore::IDENTIFIER_TYPE;
 using mizcore::COMMENT_TYPE;
 using mizcore::KEYWORD_TYPE;
 
+using mizcore::ComponentQuery;
+using mizcore::JsonWriter;
 using mizcore::MizController;
+using mizcore::PhaseProfiler;
+using mizcore::PhaseRecord;
 using mizcore::ErrorTable;
+using mizcore::TokenColumns;
+using mizcore::TokenQuery;
 using mizcore::TokenTable;
 
 using mizcore::ASTElement;
@@ -63,6 +80,202 @@ using mizcore::PyCommentToken;
 
 namespace py = pybind11;
 
+namespace {
+
+// A NumPy array viewing values, which owner keeps alive.
+template<class T>
+py::array_t<T> ToNumPyArray(const std::vector<T>& values, const py::capsule& owner)
+{
+  return py::array_t<T>(values.size(), values.data(), owner);
+}
+
+// A NumPy array owning values.
+template<class T>
+py::array_t<T> ToNumPyArray(std::vector<T>&& values)
+{
+  auto* owned_values = new std::vector<T>(std::move(values));
+  py::capsule owner(owned_values, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+  return ToNumPyArray(*owned_values, owner);
+}
+
+// The arrays of TokenColumns, which share one owner, and the concatenated
+// text as bytes.
+py::dict ExportTokenArrays(const TokenTable& token_table)
+{
+  auto columns = std::make_unique<TokenColumns>();
+  token_table.ToColumns(*columns);
+  py::capsule owner(columns.get(), [](void* p) { delete static_cast<TokenColumns*>(p); });
+  const TokenColumns* c = columns.release();
+
+  py::dict arrays;
+  arrays["id"] = ToNumPyArray(c->ids_, owner);
+  arrays["token_type"] = ToNumPyArray(c->token_types_, owner);
+  arrays["sub_type"] = ToNumPyArray(c->sub_types_, owner);
+  arrays["line_number"] = ToNumPyArray(c->line_numbers_, owner);
+  arrays["column_number"] = ToNumPyArray(c->column_numbers_, owner);
+  arrays["offset"] = ToNumPyArray(c->offsets_, owner);
+  arrays["length"] = ToNumPyArray(c->lengths_, owner);
+  arrays["ref_id"] = ToNumPyArray(c->ref_ids_, owner);
+  arrays["text"] = py::bytes(c->text_);
+  return arrays;
+}
+
+// The wrappers of the tokens and the child components are cached in a list in
+// the __dict__ of the wrapper of their owner, so that the repeated accesses
+// return the same objects without converting them again while the owner is
+// alive. pybind11 also returns these live wrappers from the other accessors,
+// e.g. ref_token, parent and query_components.
+py::list GetWrapperCache(const py::object& owner, const char* name, size_t size)
+{
+  if (py::hasattr(owner, name)) {
+    py::list wrappers = owner.attr(name);
+    if (wrappers.size() == size) {
+      return wrappers;
+    }
+  }
+  py::list wrappers;
+  for (size_t i = 0; i < size; ++i) {
+    wrappers.append(py::none());
+  }
+  py::setattr(owner, name, wrappers);
+  return wrappers;
+}
+
+template<class T>
+py::object GetCachedWrapper(const py::list& wrappers, size_t i, T* value)
+{
+  py::object wrapper = wrappers[i];
+  if (wrapper.is_none()) {
+    wrapper = py::cast(value, py::return_value_policy::reference);
+    wrappers[i] = wrapper;
+  }
+  return wrapper;
+}
+
+py::object GetToken(const py::object& token_table_object, size_t i)
+{
+  const auto& token_table = token_table_object.cast<const TokenTable&>();
+  if (i < token_table.GetFirstTokenId() || i >= token_table.GetTokenNum()) {
+    throw py::index_error("token id out of range");
+  }
+  py::list wrappers = GetWrapperCache(token_table_object, "_token_wrappers", token_table.GetTokenNum());
+  return GetCachedWrapper(wrappers, i, token_table.GetToken(i));
+}
+
+py::object GetChildComponent(const py::object& block_object, size_t i)
+{
+  const auto& block = block_object.cast<const ASTBlock&>();
+  if (i >= block.GetChildComponentNum()) {
+    throw py::index_error("child component index out of range");
+  }
+  py::list wrappers = GetWrapperCache(block_object, "_child_component_wrappers", block.GetChildComponentNum());
+  return GetCachedWrapper(wrappers, i, block.GetChildComponent(i));
+}
+
+// The wrapper of a table of the result is kept in the __dict__ of the wrapper
+// of the controller, so that the wrappers cached in it outlive the accesses.
+// It is replaced when the controller executes another article.
+template<class T>
+py::object GetResultWrapper(const py::object& controller_object, const char* name,
+                            const std::shared_ptr<T>& value)
+{
+  if (py::hasattr(controller_object, name)) {
+    py::object wrapper = controller_object.attr(name);
+    if (!wrapper.is_none() && wrapper.cast<T*>() == value.get()) {
+      return wrapper;
+    }
+  }
+  py::object wrapper = py::cast(value);
+  py::setattr(controller_object, name, wrapper);
+  return wrapper;
+}
+
+std::vector<ASTComponent*> QueryComponents(const ASTBlock& block,
+                                           ELEMENT_TYPE element_type,
+                                           std::optional<BLOCK_TYPE> block_type,
+                                           std::optional<STATEMENT_TYPE> statement_type,
+                                           int first_line_number,
+                                           int last_line_number)
+{
+  ComponentQuery query;
+  query.element_type_ = element_type;
+  query.block_type_ = block_type;
+  query.statement_type_ = statement_type;
+  query.first_line_number_ = first_line_number;
+  query.last_line_number_ = last_line_number;
+  py::gil_scoped_release release;
+  return mizcore::QueryComponents(&block, query);
+}
+
+py::array_t<uint32_t> QueryTokenIds(const TokenTable& token_table,
+                                    std::optional<TOKEN_TYPE> token_type,
+                                    std::optional<IDENTIFIER_TYPE> identifier_type,
+                                    std::optional<KEYWORD_TYPE> keyword_type,
+                                    int first_line_number,
+                                    int last_line_number)
+{
+  TokenQuery query;
+  query.token_type_ = token_type;
+  query.identifier_type_ = identifier_type;
+  query.keyword_type_ = keyword_type;
+  query.first_line_number_ = first_line_number;
+  query.last_line_number_ = last_line_number;
+  std::vector<uint32_t> ids;
+  {
+    py::gil_scoped_release release;
+    ids = mizcore::QueryTokenIds(token_table, query);
+  }
+  return ToNumPyArray(std::move(ids));
+}
+
+void ExecBufferInPlace(MizController& miz_controller, const py::buffer& buffer, const char* vctpath)
+{
+  py::buffer_info info = buffer.request();
+  if (info.ndim > 1 || (info.ndim == 1 && info.strides[0] != info.itemsize)) {
+    throw std::invalid_argument("exec_buffer requires a contiguous buffer");
+  }
+  std::string_view text(static_cast<const char*>(info.ptr), info.size * info.itemsize);
+  py::gil_scoped_release release;
+  miz_controller.ExecBuffer(text, vctpath);
+}
+
+// The state of a pickled MizController is the parse result in the format of
+// ParseResultWriter and the ABS mode. The unpickled controller recreates the
+// symbols of the tokens, so that no vocabulary is needed to receive the result
+// of a worker process.
+py::tuple GetControllerState(const MizController& miz_controller)
+{
+  std::string data;
+  {
+    py::gil_scoped_release release;
+    if (!miz_controller.WriteResult(data)) {
+      throw std::runtime_error("MizController has no parse result to pickle");
+    }
+  }
+  return py::make_tuple(py::bytes(data), miz_controller.IsABSMode());
+}
+
+std::shared_ptr<MizController> SetControllerState(const py::tuple& state)
+{
+  if (state.size() != 2) {
+    throw std::runtime_error("Invalid MizController state");
+  }
+  auto miz_controller = std::make_shared<MizController>();
+  miz_controller->SetABSMode(state[1].cast<bool>());
+  std::string_view data = state[0].cast<std::string_view>();
+  bool is_restored = false;
+  {
+    py::gil_scoped_release release;
+    is_restored = miz_controller->ReadResult(data);
+  }
+  if (!is_restored) {
+    throw std::runtime_error("Invalid MizController state");
+  }
+  return miz_controller;
+}
+
+} // namespace
+
 PYBIND11_MODULE(py_miz_controller, m)
 {
   py::enum_<TOKEN_TYPE>(m, "TokenType", py::arithmetic())
@@ -341,7 +554,12 @@ PYBIND11_MODULE(py_miz_controller, m)
     .export_values();
 
   py::class_<ASTElement, PyASTElement, std::shared_ptr<ASTElement>>(m, "ASTElement")
-    .def_property_readonly("element_type", &ASTElement::GetElementType);
+    .def_property_readonly("element_type", &ASTElement::GetElementType)
+    // The wrappers of the same native element are equal, even if they are
+    // different objects.
+    .def("__eq__", [](const ASTElement& self, const ASTElement& other) { return &self == &other; },
+         py::is_operator())
+    .def("__hash__", [](const ASTElement& self) { return std::hash<const ASTElement*>()(&self); });
 
   py::class_<ASTComponent, ASTElement, PyASTComponent, std::shared_ptr<ASTComponent>>(m, "ASTComponent")
     .def_property_readonly("parent", &ASTComponent::GetParent, py::return_value_policy::reference)
@@ -352,15 +570,21 @@ PYBIND11_MODULE(py_miz_controller, m)
   py::class_<ASTStatement, ASTComponent, PyASTStatement, std::shared_ptr<ASTStatement>>(m, "ASTStatement")
     .def_property_readonly("statement_type", &ASTStatement::GetStatementType);
 
-  py::class_<ASTBlock, ASTComponent, PyASTBlock, std::shared_ptr<ASTBlock>>(m, "ASTBlock")
+  py::class_<ASTBlock, ASTComponent, PyASTBlock, std::shared_ptr<ASTBlock>>(m, "ASTBlock", py::dynamic_attr())
     .def_property_readonly("block_type", &ASTBlock::GetBlockType)
     .def_property_readonly("first_token", &ASTBlock::GetFirstToken, py::return_value_policy::reference)
     .def_property_readonly("last_token", &ASTBlock::GetLastToken, py::return_value_policy::reference)
     .def_property_readonly("semicolon_token", &ASTBlock::GetSemicolonToken, py::return_value_policy::reference)
     .def_property_readonly("child_component_num", &ASTBlock::GetChildComponentNum)
-    .def("child_component", &ASTBlock::GetChildComponent, py::return_value_policy::reference)
+    .def("child_component", &GetChildComponent)
     .def("child_block", &ASTBlock::GetChildBlock, py::return_value_policy::reference)
-    .def("child_statement", &ASTBlock::GetChildStatement, py::return_value_policy::reference);
+    .def("child_statement", &ASTBlock::GetChildStatement, py::return_value_policy::reference)
+    // The blocks and the statements of the subtree in pre-order, filtered in
+    // C++ (see mizcore::ComponentQuery).
+    .def("query_components", &QueryComponents, py::arg("element_type") = ELEMENT_TYPE::UNKNOWN,
+         py::arg("block_type") = std::nullopt, py::arg("statement_type") = std::nullopt,
+         py::arg("first_line") = 0, py::arg("last_line") = INT_MAX,
+         py::return_value_policy::reference);
 
   py::class_<ASTToken, ASTElement, PyASTToken, std::shared_ptr<ASTToken>>(m, "ASTToken")
     .def_property_readonly("id", &ASTToken::GetId)
@@ -390,21 +614,78 @@ PYBIND11_MODULE(py_miz_controller, m)
   py::class_<KeywordToken, ASTToken, PyKeywordToken, std::shared_ptr<KeywordToken>>(m, "KeywordToken")
     .def_property_readonly("keyword_type", &KeywordToken::GetKeywordType);
 
-  py::class_<TokenTable, std::shared_ptr<TokenTable>>(m, "TokenTable")
-    .def("token", &TokenTable::GetToken, py::return_value_policy::reference)
+  py::class_<TokenTable, std::shared_ptr<TokenTable>>(m, "TokenTable", py::dynamic_attr())
+    .def("token", &GetToken)
     .def_property_readonly("token_num", &TokenTable::GetTokenNum)
-    .def_property_readonly("last_token", &TokenTable::GetLastToken);
+    .def_property_readonly("last_token", &TokenTable::GetLastToken)
+    // A dict of NumPy arrays, one element per token: "id", "token_type",
+    // "sub_type", "line_number", "column_number", "offset", "length" and
+    // "ref_id" (-1 if none), and "text", the bytes of the texts of the tokens
+    // concatenated, where text[offset:offset + length] is the text of a token.
+    .def("export_arrays", &ExportTokenArrays)
+    // A NumPy array of the ids of the matching tokens (see mizcore::TokenQuery).
+    .def("query_token_ids", &QueryTokenIds, py::arg("token_type") = std::nullopt,
+         py::arg("identifier_type") = std::nullopt, py::arg("keyword_type") = std::nullopt,
+         py::arg("first_line") = 0, py::arg("last_line") = INT_MAX);
 
   py::class_<ErrorTable, std::shared_ptr<ErrorTable>>(m, "ErrorTable")
     .def("log_errors", &ErrorTable::LogErrors);
 
-  py::class_<MizController, std::shared_ptr<MizController>>(m, "MizController")
+  py::class_<PhaseRecord>(m, "PhaseRecord")
+    .def_readonly("name", &PhaseRecord::name_)
+    .def_readonly("thread_index", &PhaseRecord::thread_index_)
+    .def_readonly("start_ns", &PhaseRecord::start_ns_)
+    .def_readonly("duration_ns", &PhaseRecord::duration_ns_)
+    .def_readonly("token_num", &PhaseRecord::token_num_)
+    .def_readonly("block_num", &PhaseRecord::block_num_)
+    .def_readonly("statement_num", &PhaseRecord::statement_num_)
+    .def_readonly("allocation_num", &PhaseRecord::allocation_num_)
+    .def_readonly("allocated_bytes", &PhaseRecord::allocated_bytes_);
+
+  py::class_<PhaseProfiler, std::shared_ptr<PhaseProfiler>>(m, "PhaseProfiler")
+    .def_property_readonly("phase_records", &PhaseProfiler::GetPhaseRecords)
+    .def("chrome_trace", [](const PhaseProfiler& profiler) {
+      std::string trace;
+      {
+        JsonWriter writer(trace);
+        profiler.WriteChromeTrace(writer);
+      }
+      return trace;
+    });
+
+  py::class_<MizController, std::shared_ptr<MizController>>(m, "MizController", py::dynamic_attr())
     .def(py::init<>())
-    .def("exec_file", &MizController::ExecFile)
-    .def("exec_buffer", &MizController::ExecBuffer)
+    // The parsing runs without the GIL, so that Python threads parse in
+    // parallel.
+    .def("exec_file", &MizController::ExecFile, py::call_guard<py::gil_scoped_release>())
+    // A bytes-like object (bytes, bytearray, memoryview, ...) is scanned in
+    // place, and held only during the call.
+    .def("exec_buffer", &ExecBufferInPlace)
+    .def("exec_buffer", py::overload_cast<const char*, const char*>(&MizController::ExecBuffer),
+         py::call_guard<py::gil_scoped_release>())
+    .def_static("exec_many", &MizController::ExecFiles, py::arg("paths"), py::arg("vctpath"),
+                py::arg("threads") = 0, py::call_guard<py::gil_scoped_release>())
     .def("is_abs_mode", &MizController::IsABSMode)
-    .def_property_readonly("token_table", &MizController::GetTokenTable)
-    .def_property_readonly("ast_root", &MizController::GetASTRoot)
-    .def_property_readonly("error_table", &MizController::GetErrorTable)
-    .def("is_separable_tokens", &MizController::CheckIsSeparableTokens);
+    .def_property_readonly("token_table",
+                           [](const py::object& self) {
+                             return GetResultWrapper(self, "_token_table_wrapper",
+                                                     self.cast<const MizController&>().GetTokenTable());
+                           })
+    .def_property_readonly("ast_root",
+                           [](const py::object& self) {
+                             return GetResultWrapper(self, "_ast_root_wrapper",
+                                                     self.cast<const MizController&>().GetASTRoot());
+                           })
+    .def_property_readonly("error_table",
+                           [](const py::object& self) {
+                             return GetResultWrapper(self, "_error_table_wrapper",
+                                                     self.cast<const MizController&>().GetErrorTable());
+                           })
+    .def("is_separable_tokens", &MizController::CheckIsSeparableTokens)
+    .def("is_profiling_mode", &MizController::IsProfilingMode)
+    .def("set_profiling_mode", &MizController::SetProfilingMode)
+    .def_property_readonly("phase_profiler", &MizController::GetPhaseProfiler)
+    // The token table, the AST and the error table refer to each other, and
+    // are pickled together with the controller.
+    .def(py::pickle(&GetControllerState, &SetControllerState));
 }
\ No newline at end of file
@@ -140,6 +140,6 @@ setup(
     ext_modules=[CMakeExtension("mizcore")],
     cmdclass={"build_ext": CMakeBuild},
     zip_safe=False,
-    extras_require={"test": ["pytest>=6.0"]},
+    extras_require={"test": ["pytest>=6.0"], "numpy": ["numpy"]},
     python_requires=">=3.6",
 )
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "article_generator.hpp"
+
+using mizcore::ARTICLE_SHAPE;
+
+namespace {
+
+constexpr std::array<std::pair<ARTICLE_SHAPE, std::string_view>, 6>
+  SHAPE_TEXTS = { { { ARTICLE_SHAPE::MIXED, "mixed" },
+                    { ARTICLE_SHAPE::LABELS, "labels" },
+                    { ARTICLE_SHAPE::NESTED_PROOFS, "nested_proofs" },
+                    { ARTICLE_SHAPE::SYMBOL_RUNS, "symbol_runs" },
+                    { ARTICLE_SHAPE::COMMENTS, "comments" },
+                    { ARTICLE_SHAPE::WHERE_CLAUSES, "where_clauses" } } };
+
+// The indentation is capped so that the size of the text stays linear.
+constexpr size_t MAX_INDENT_LEVEL = 32;
+// The comment lines between the theorems of COMMENTS.
+constexpr size_t COMMENT_BLOCK_SIZE = 64;
+// The variables per line of WHERE_CLAUSES.
+constexpr size_t VARIABLES_PER_LINE = 8;
+
+void
+Indent(std::string& text, size_t level)
+{
+    text.append(2 * std::min(level, MAX_INDENT_LEVEL), ' ');
+}
+
+void
+Label(std::string& text, const char* prefix, size_t i)
+{
+    text += prefix;
+    text += std::to_string(i);
+}
+
+void
+GenerateMixed(std::string& text, size_t size)
+{
+    for (size_t i = 1; i <= size; ++i) {
+        text += ":: Unit " + std::to_string(i) + "\n";
+        text += "theorem ";
+        Label(text, "Th", i);
+        text += ":\n"
+                "  x in { y where y is object : y = x } implies x = x\n"
+                "proof\n"
+                "  A1: x = x;\n"
+                "  thus thesis by A1";
+        if (i > 1) {
+            text += ", ";
+            Label(text, "Th", i - 1);
+        }
+        text += ";\nend;\n\n";
+    }
+}
+
+void
+GenerateLabels(std::string& text, size_t size)
+{
+    text += "theorem Th1:\n"
+            "  x = x\n"
+            "proof\n";
+    for (size_t i = 1; i <= size; ++i) {
+        text += "  ";
+        Label(text, "A", i);
+        text += ": x = x";
+        if (i > 1) {
+            text += " by ";
+            Label(text, "A", i - 1);
+            text += ", A1";
+        }
+        text += ";\n";
+    }
+    text += "  thus thesis by ";
+    Label(text, "A", size);
+    text += ";\nend;\n";
+}
+
+void
+GenerateNestedProofs(std::string& text, size_t size)
+{
+    text += "theorem Th1:\n"
+            "  x = x\n"
+            "proof\n";
+    for (size_t i = 1; i <= size; ++i) {
+        Indent(text, i);
+        Label(text, "A", i);
+        text += ": x = x\n";
+        Indent(text, i);
+        text += "proof\n";
+    }
+    Indent(text, size + 1);
+    text += "thus thesis;\n";
+    for (size_t i = size; i >= 1; --i) {
+        Indent(text, i);
+        text += "end;\n";
+        Indent(text, i);
+        text += "thus thesis by ";
+        Label(text, "A", i);
+        text += ";\n";
+    }
+    text += "end;\n";
+}
+
+void
+GenerateSymbolRuns(std::string& text, size_t size)
+{
+    static constexpr std::array<std::string_view, 4> ATOMS = {
+        "x = y", "y <> z", "z in x", "(x=z)"
+    };
+    text += "theorem Th1:\n  ";
+    for (size_t i = 0; i < size; ++i) {
+        if (i > 0) {
+            text += " & ";
+        }
+        text += ATOMS[i % ATOMS.size()];
+    }
+    text += "\n  implies x = x;\n";
+}
+
+void
+GenerateComments(std::string& text, size_t size)
+{
+    for (size_t i = 1; i <= size; ++i) {
+        text += ":: Comment line " + std::to_string(i) +
+                " of a long block: x = y & y in z implies (z = x)\n";
+        if (i % COMMENT_BLOCK_SIZE == 0 || i == size) {
+            text += "theorem\n  x = x;\n\n";
+        }
+    }
+}
+
+void
+GenerateWhereClauses(std::string& text, size_t size)
+{
+    text += "theorem Th1:\n"
+            "  x in { x1 where ";
+    for (size_t i = 1; i <= size; ++i) {
+        if (i > 1) {
+            text += ",";
+            text += i % VARIABLES_PER_LINE == 1 ? "\n    " : " ";
+        }
+        Label(text, "x", i);
+    }
+    text += " is object :\n    ";
+    for (size_t i = 1; i < size; ++i) {
+        if (i > 1) {
+            text += " &";
+            text += i % VARIABLES_PER_LINE == 1 ? "\n    " : " ";
+        }
+        Label(text, "x", i);
+        text += " = ";
+        Label(text, "x", i + 1);
+    }
+    if (size <= 1) {
+        text += "x1 = x1";
+    }
+    text += " }\n  implies x = x;\n";
+}
+
+} // namespace
+
+ARTICLE_SHAPE
+mizcore::QueryArticleShape(std::string_view text)
+{
+    for (const auto& [shape, shape_text] : SHAPE_TEXTS) {
+        if (shape_text == text) {
+            return shape;
+        }
+    }
+    return ARTICLE_SHAPE::UNKNOWN;
+}
+
+std::string_view
+mizcore::QueryArticleShapeText(ARTICLE_SHAPE shape)
+{
+    for (const auto& [known_shape, shape_text] : SHAPE_TEXTS) {
+        if (known_shape == shape) {
+            return shape_text;
+        }
+    }
+    return "unknown";
+}
+
+std::string
+mizcore::GenerateArticle(ARTICLE_SHAPE shape, size_t size)
+{
+    size = std::max<size_t>(size, 1);
+    std::string text = ":: Synthetic article: ";
+    text += QueryArticleShapeText(shape);
+    text += ", size " + std::to_string(size) +
+            "\n\n"
+            "environ\n\n"
+            "begin\n\n"
+            "reserve x, y, z for object;\n\n";
+    switch (shape) {
+        case ARTICLE_SHAPE::MIXED:
+            GenerateMixed(text, size);
+            break;
+        case ARTICLE_SHAPE::LABELS:
+            GenerateLabels(text, size);
+            break;
+        case ARTICLE_SHAPE::NESTED_PROOFS:
+            GenerateNestedProofs(text, size);
+            break;
+        case ARTICLE_SHAPE::SYMBOL_RUNS:
+            GenerateSymbolRuns(text, size);
+            break;
+        case ARTICLE_SHAPE::COMMENTS:
+            GenerateComments(text, size);
+            break;
+        case ARTICLE_SHAPE::WHERE_CLAUSES:
+            GenerateWhereClauses(text, size);
+            break;
+        case ARTICLE_SHAPE::UNKNOWN:
+            break;
+    }
+    return text;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace mizcore {
+
+// The shapes of the synthetic articles. Each of them repeats a unit, which
+// stresses a part of the lexer or the parser as the size grows.
+enum class ARTICLE_SHAPE
+{
+    UNKNOWN,
+    // Theorems referring to the preceding theorems by the root labels.
+    MIXED,
+    // A proof of many local labels, each referring to the previous ones.
+    LABELS,
+    // Proofs nested as deep as the size.
+    NESTED_PROOFS,
+    // A formula of many symbols on one line.
+    SYMBOL_RUNS,
+    // Comment blocks of many lines.
+    COMMENTS,
+    // A Fraenkel term with many variables in its "where" clause.
+    WHERE_CLAUSES,
+};
+
+ARTICLE_SHAPE
+QueryArticleShape(std::string_view text);
+std::string_view
+QueryArticleShapeText(ARTICLE_SHAPE shape);
+
+// Generates an article of shape with size units. The article uses the symbols
+// of HIDDEN only, and is parsed by MizBlockParser without errors.
+std::string
+GenerateArticle(ARTICLE_SHAPE shape, size_t size);
+
+} // namespace mizcore
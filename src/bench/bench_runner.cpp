@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+
+#include "bench_runner.hpp"
+
+using mizcore::BenchResult;
+using mizcore::BenchRunner;
+
+const BenchResult*
+BenchRunner::Run(const std::string& name,
+                 size_t token_num,
+                 const Function& body,
+                 const Function& setup)
+{
+    if (name.find(filter_) == std::string::npos) {
+        return nullptr;
+    }
+
+    // The first iteration warms up the caches and calibrates the number of
+    // iterations per sample.
+    double first_seconds = MeasureIteration(body, setup);
+    size_t iteration_num = 1;
+    if (first_seconds < min_sample_seconds_) {
+        iteration_num = static_cast<size_t>(
+          min_sample_seconds_ / std::max(first_seconds, 1e-9));
+        iteration_num = std::max<size_t>(iteration_num, 1);
+    }
+
+    std::vector<double> samples;
+    for (size_t i = 0; i < sample_num_; ++i) {
+        double seconds = 0.0;
+        for (size_t j = 0; j < iteration_num; ++j) {
+            seconds += MeasureIteration(body, setup);
+        }
+        samples.push_back(seconds / iteration_num);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name_ = name;
+    result.token_num_ = token_num;
+    result.iteration_num_ = iteration_num * sample_num_;
+    result.seconds_ = samples.empty() ? first_seconds
+                                      : samples[samples.size() / 2];
+    results_.push_back(result);
+    return &results_.back();
+}
+
+void
+BenchRunner::Print(std::ostream& os) const
+{
+    char line[256];
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-40s %12s %10s %14s\n",
+                  "benchmark",
+                  "us/iter",
+                  "iters",
+                  "tokens/s");
+    os << line;
+    for (const auto& result : results_) {
+        std::snprintf(line,
+                      sizeof(line),
+                      "%-40s %12.2f %10zu %14.0f\n",
+                      result.name_.c_str(),
+                      result.seconds_ * 1e6,
+                      result.iteration_num_,
+                      result.GetTokensPerSecond());
+        os << line;
+    }
+}
+
+void
+BenchRunner::ToJson(nlohmann::json& json) const
+{
+    json = nlohmann::json::array();
+    for (const auto& result : results_) {
+        json.push_back({ { "name", result.name_ },
+                         { "token_num", result.token_num_ },
+                         { "iteration_num", result.iteration_num_ },
+                         { "seconds", result.seconds_ },
+                         { "tokens_per_second",
+                           result.GetTokensPerSecond() } });
+    }
+}
+
+std::optional<size_t>
+BenchRunner::CompareWithBaseline(const std::string& baseline_path,
+                                 double threshold,
+                                 std::ostream& os) const
+{
+    std::ifstream ifs(baseline_path);
+    if (!ifs) {
+        os << "Failed to open the baseline: " << baseline_path << "\n";
+        return std::nullopt;
+    }
+    std::map<std::string, double> name2seconds;
+    try {
+        nlohmann::json baseline_json;
+        ifs >> baseline_json;
+        if (!baseline_json.is_array()) {
+            throw std::runtime_error("not an array of the results");
+        }
+        for (const auto& result_json : baseline_json) {
+            name2seconds[result_json.at("name").get<std::string>()] =
+              result_json.at("seconds").get<double>();
+        }
+    } catch (const std::exception& e) {
+        os << "Failed to read the baseline: " << baseline_path << ": "
+           << e.what() << "\n";
+        return std::nullopt;
+    }
+
+    size_t regression_num = 0;
+    char line[256];
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-40s %12s %12s %8s\n",
+                  "benchmark",
+                  "base us",
+                  "us",
+                  "ratio");
+    os << line;
+    for (const auto& result : results_) {
+        auto it = name2seconds.find(result.name_);
+        if (it == name2seconds.end() || it->second <= 0.0) {
+            continue;
+        }
+        double ratio = result.seconds_ / it->second;
+        bool is_regression = ratio > 1.0 + threshold;
+        if (is_regression) {
+            ++regression_num;
+        }
+        std::snprintf(line,
+                      sizeof(line),
+                      "%-40s %12.2f %12.2f %8.3f%s\n",
+                      result.name_.c_str(),
+                      it->second * 1e6,
+                      result.seconds_ * 1e6,
+                      ratio,
+                      is_regression ? "  SLOWER" : "");
+        os << line;
+    }
+    return regression_num;
+}
+
+double
+BenchRunner::MeasureIteration(const Function& body, const Function& setup)
+{
+    if (setup) {
+        setup();
+    }
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> duration =
+      std::chrono::steady_clock::now() - start;
+    return duration.count();
+}
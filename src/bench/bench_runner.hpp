@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+namespace mizcore {
+
+struct BenchResult
+{
+    std::string name_;
+    // The number of tokens processed by an iteration, or zero if the
+    // benchmark does not process tokens.
+    size_t token_num_ = 0;
+    size_t iteration_num_ = 0;
+    // The median over the samples of the seconds per iteration.
+    double seconds_ = 0.0;
+
+    double GetTokensPerSecond() const
+    {
+        return seconds_ > 0.0 ? token_num_ / seconds_ : 0.0;
+    }
+};
+
+// Minimal timing harness of the benchmarks. Each benchmark is run in
+// sample_num samples of as many iterations as fill min_sample_seconds, and
+// the median of the samples is reported. The results are saved as JSON and
+// compared with the saved results of another run.
+class BenchRunner
+{
+  public:
+    // ctor, dtor
+    explicit BenchRunner(size_t sample_num = 5,
+                         double min_sample_seconds = 0.05)
+      : sample_num_(sample_num)
+      , min_sample_seconds_(min_sample_seconds)
+    {}
+    virtual ~BenchRunner() = default;
+    BenchRunner(BenchRunner const&) = delete;
+    BenchRunner(BenchRunner&&) = delete;
+    BenchRunner& operator=(BenchRunner const&) = delete;
+    BenchRunner& operator=(BenchRunner&&) = delete;
+
+    // attributes
+    const std::vector<BenchResult>& GetResults() const { return results_; }
+
+    // operations
+    // Runs setup before each iteration outside of the measurement, and then
+    // measures body. Only the benchmarks whose names contain the filter are
+    // run, and nullptr is returned for the others.
+    using Function = std::function<void()>;
+    const BenchResult* Run(const std::string& name,
+                           size_t token_num,
+                           const Function& body,
+                           const Function& setup = nullptr);
+    void SetFilter(std::string filter) { filter_ = std::move(filter); }
+
+    void Print(std::ostream& os) const;
+    void ToJson(nlohmann::json& json) const;
+    // Prints the ratios of the seconds to the baseline saved from ToJson(),
+    // and returns the number of the benchmarks slower than the baseline by
+    // more than threshold (0.1 for 10%), or std::nullopt if the baseline can
+    // not be read.
+    std::optional<size_t> CompareWithBaseline(const std::string& baseline_path,
+                                              double threshold,
+                                              std::ostream& os) const;
+
+  private:
+    // implementation
+    static double MeasureIteration(const Function& body,
+                                   const Function& setup);
+
+    size_t sample_num_;
+    double min_sample_seconds_;
+    std::string filter_;
+    std::vector<BenchResult> results_;
+};
+
+} // namespace mizcore
@@ -0,0 +1,34 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "article_generator.hpp"
+
+using mizcore::ARTICLE_SHAPE;
+
+// Writes a synthetic article to OUTPUT, or to the standard output without it.
+//
+// Usage: miz_generate SHAPE SIZE [OUTPUT]
+//   SHAPE : mixed, labels, nested_proofs, symbol_runs, comments or
+//           where_clauses
+int
+main(int argc, char* argv[])
+{
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: miz_generate SHAPE SIZE [OUTPUT]\n";
+        return 1;
+    }
+    ARTICLE_SHAPE shape = mizcore::QueryArticleShape(argv[1]);
+    if (shape == ARTICLE_SHAPE::UNKNOWN) {
+        std::cerr << "Unknown shape: " << argv[1] << "\n";
+        return 1;
+    }
+    std::string text = mizcore::GenerateArticle(shape, std::stoul(argv[2]));
+    if (argc == 4) {
+        std::ofstream ofs(argv[3]);
+        ofs << text;
+    } else {
+        std::cout << text;
+    }
+    return 0;
+}
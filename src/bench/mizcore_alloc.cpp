@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "miz_controller.hpp"
+#include "nlohmann/json.hpp"
+#include "phase_profiler.hpp"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+
+#ifndef MIZCORE_BENCH_DATA_DIR
+#define MIZCORE_BENCH_DATA_DIR "tests/parser/data"
+#endif
+
+using mizcore::AllocationCounter;
+using mizcore::MizController;
+using mizcore::PhaseRecord;
+using mizcore::SymbolTable;
+namespace fs = std::filesystem;
+
+// Counts the allocations of each phase of MizController over the articles of
+// the test corpus, and checks them against the budgets. The allocations of a
+// phase exclude those of the phases nested in it, e.g. "lex" excludes
+// "build_query_map". The budget of a phase is "fixed" + "per_token" * tokens
+// of the article:
+//
+//   { "lex": { "fixed": 1024, "per_token": 4.0 }, ... }
+//
+// The phases without budgets are only reported. -w writes the budgets which
+// the current allocations just fit, increased by MARGIN, so that the budgets
+// are tightened after the allocations are reduced.
+//
+// Usage: mizcore_alloc [-d DATA_DIR] [-b BUDGET] [-w NEW_BUDGET] [-m MARGIN]
+//                      [-o RESULT]
+//   DATA_DIR : the directory of mml.vct and *.miz (tests/parser/data)
+//   MARGIN   : the ratio added to the budgets written by -w (0.1)
+
+namespace {
+
+struct PhaseAllocation
+{
+    std::string article_name_;
+    std::string phase_name_;
+    size_t token_num_ = 0;
+    uint64_t allocation_num_ = 0;
+    uint64_t allocated_bytes_ = 0;
+};
+
+struct Budget
+{
+    double fixed_ = 0.0;
+    double per_token_ = 0.0;
+
+    double GetLimit(size_t token_num) const
+    {
+        return fixed_ + per_token_ * token_num;
+    }
+};
+
+bool
+IsNested(const PhaseRecord& inner, const PhaseRecord& outer)
+{
+    return &inner != &outer && inner.thread_index_ == outer.thread_index_ &&
+           inner.start_ns_ >= outer.start_ns_ &&
+           inner.start_ns_ + inner.duration_ns_ <=
+             outer.start_ns_ + outer.duration_ns_;
+}
+
+// Sums the allocations of the records by the phase names, excluding those of
+// the directly nested records.
+void
+CollectPhaseAllocations(const std::string& article_name,
+                        size_t token_num,
+                        const std::vector<PhaseRecord>& records,
+                        std::vector<PhaseAllocation>& phase_allocations)
+{
+    std::map<std::string, PhaseAllocation> name2allocation;
+    std::vector<std::string> names;
+    for (const auto& record : records) {
+        uint64_t allocation_num = record.allocation_num_;
+        uint64_t allocated_bytes = record.allocated_bytes_;
+        for (const auto& child : records) {
+            if (!IsNested(child, record)) {
+                continue;
+            }
+            bool is_direct = std::none_of(
+              records.begin(), records.end(), [&](const PhaseRecord& middle) {
+                  return IsNested(child, middle) && IsNested(middle, record);
+              });
+            if (is_direct) {
+                allocation_num -=
+                  std::min(allocation_num, child.allocation_num_);
+                allocated_bytes -=
+                  std::min(allocated_bytes, child.allocated_bytes_);
+            }
+        }
+
+        auto& phase_allocation = name2allocation[record.name_];
+        if (phase_allocation.phase_name_.empty()) {
+            phase_allocation.article_name_ = article_name;
+            phase_allocation.phase_name_ = record.name_;
+            phase_allocation.token_num_ = token_num;
+            names.push_back(record.name_);
+        }
+        phase_allocation.allocation_num_ += allocation_num;
+        phase_allocation.allocated_bytes_ += allocated_bytes;
+    }
+    for (const auto& name : names) {
+        phase_allocations.push_back(name2allocation[name]);
+    }
+}
+
+std::map<std::string, Budget>
+LoadBudgets(const std::string& budget_path)
+{
+    std::map<std::string, Budget> name2budget;
+    std::ifstream ifs(budget_path);
+    if (!ifs) {
+        std::cerr << "Failed to open the budget: " << budget_path << "\n";
+        return name2budget;
+    }
+    nlohmann::json budget_json;
+    ifs >> budget_json;
+    for (const auto& [name, json] : budget_json.items()) {
+        Budget& budget = name2budget[name];
+        budget.fixed_ = json.value("fixed", 0.0);
+        budget.per_token_ = json.value("per_token", 0.0);
+    }
+    return name2budget;
+}
+
+// The budgets which the allocations just fit: the per token budget is the
+// least rate of the articles, and the fixed budget covers the rest.
+nlohmann::json
+FitBudgets(const std::vector<PhaseAllocation>& phase_allocations,
+           double margin)
+{
+    std::map<std::string, Budget> name2budget;
+    for (const auto& allocation : phase_allocations) {
+        if (allocation.token_num_ == 0) {
+            continue;
+        }
+        double per_token = static_cast<double>(allocation.allocation_num_) /
+                           allocation.token_num_;
+        auto [it, is_new] = name2budget.try_emplace(allocation.phase_name_);
+        if (is_new || per_token < it->second.per_token_) {
+            it->second.per_token_ = per_token;
+        }
+    }
+    for (const auto& allocation : phase_allocations) {
+        auto& budget = name2budget[allocation.phase_name_];
+        double rest = allocation.allocation_num_ -
+                      budget.per_token_ * allocation.token_num_;
+        budget.fixed_ = std::max(budget.fixed_, rest);
+    }
+
+    nlohmann::json budget_json = nlohmann::json::object();
+    for (const auto& [name, budget] : name2budget) {
+        budget_json[name] = {
+            { "fixed", std::ceil(budget.fixed_ * (1.0 + margin)) },
+            { "per_token",
+              std::ceil(budget.per_token_ * (1.0 + margin) * 100.0) / 100.0 }
+        };
+    }
+    return budget_json;
+}
+
+// Parses a non-negative number of the command line.
+bool
+ParseRatio(const std::string& text, double& ratio)
+{
+    size_t length = 0;
+    try {
+        ratio = std::stod(text, &length);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return length == text.size() && ratio >= 0.0;
+}
+
+int
+PrintUsage()
+{
+    std::cerr << "Usage: mizcore_alloc [-d DATA_DIR] [-b BUDGET] "
+                 "[-w NEW_BUDGET] [-m MARGIN] [-o RESULT]\n";
+    return 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    fs::path data_dir = MIZCORE_BENCH_DATA_DIR;
+    std::string budget_path;
+    std::string new_budget_path;
+    double margin = 0.1;
+    std::string result_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help" || i + 1 >= argc) {
+            return PrintUsage();
+        }
+        std::string value = argv[++i];
+        if (argument == "-d") {
+            data_dir = value;
+        } else if (argument == "-b") {
+            budget_path = value;
+        } else if (argument == "-w") {
+            new_budget_path = value;
+        } else if (argument == "-m") {
+            if (!ParseRatio(value, margin)) {
+                return PrintUsage();
+            }
+        } else if (argument == "-o") {
+            result_path = value;
+        } else {
+            return PrintUsage();
+        }
+    }
+
+    if (!AllocationCounter::IsHooked()) {
+        std::cerr << "mizcore::allocation_hook is not linked\n";
+        return 1;
+    }
+    std::vector<fs::path> mizpaths;
+    for (const auto& entry : fs::directory_iterator(data_dir)) {
+        if (entry.path().extension() == ".miz") {
+            mizpaths.push_back(entry.path());
+        }
+    }
+    std::sort(mizpaths.begin(), mizpaths.end());
+    fs::path vctpath = data_dir / "mml.vct";
+    if (!fs::is_regular_file(vctpath) || mizpaths.empty()) {
+        std::cerr << "No mml.vct or articles in " << data_dir << "\n";
+        return 1;
+    }
+
+    // The vocabulary is loaded once, as the batch tools do, so that the
+    // allocations of the articles do not include it.
+    std::shared_ptr<const SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.string().c_str());
+    std::vector<PhaseAllocation> phase_allocations;
+    for (const auto& mizpath : mizpaths) {
+        std::string article_name = mizpath.stem().string();
+        MizController miz_controller;
+        miz_controller.SetVocabulary(vocabulary);
+        miz_controller.SetProfilingMode(true);
+        miz_controller.SetABSMode(
+          article_name.size() >= 4 &&
+          article_name.compare(article_name.size() - 4, 4, "_abs") == 0);
+        miz_controller.ExecFile(mizpath.string().c_str(),
+                                vctpath.string().c_str());
+        CollectPhaseAllocations(
+          article_name,
+          miz_controller.GetTokenTable()->GetTokenNum(),
+          miz_controller.GetPhaseProfiler()->GetPhaseRecords(),
+          phase_allocations);
+    }
+
+    std::map<std::string, Budget> name2budget;
+    if (!budget_path.empty()) {
+        name2budget = LoadBudgets(budget_path);
+        if (name2budget.empty()) {
+            return 1;
+        }
+    }
+    size_t over_budget_num = 0;
+    nlohmann::json result_json = nlohmann::json::array();
+    char line[256];
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-16s %-20s %8s %10s %12s %10s %10s\n",
+                  "article",
+                  "phase",
+                  "tokens",
+                  "allocs",
+                  "bytes",
+                  "allocs/tok",
+                  "budget");
+    std::cout << line;
+    for (const auto& allocation : phase_allocations) {
+        double per_token =
+          allocation.token_num_ > 0
+            ? static_cast<double>(allocation.allocation_num_) /
+                allocation.token_num_
+            : 0.0;
+        auto it = name2budget.find(allocation.phase_name_);
+        double limit = it != name2budget.end()
+                         ? it->second.GetLimit(allocation.token_num_)
+                         : -1.0;
+        bool is_over_budget =
+          limit >= 0.0 && allocation.allocation_num_ > limit;
+        if (is_over_budget) {
+            ++over_budget_num;
+        }
+        std::snprintf(line,
+                      sizeof(line),
+                      "%-16s %-20s %8zu %10llu %12llu %10.3f %10.0f%s\n",
+                      allocation.article_name_.c_str(),
+                      allocation.phase_name_.c_str(),
+                      allocation.token_num_,
+                      static_cast<unsigned long long>(
+                        allocation.allocation_num_),
+                      static_cast<unsigned long long>(
+                        allocation.allocated_bytes_),
+                      per_token,
+                      limit,
+                      is_over_budget ? "  OVER" : "");
+        std::cout << line;
+        result_json.push_back(
+          { { "article", allocation.article_name_ },
+            { "phase", allocation.phase_name_ },
+            { "token_num", allocation.token_num_ },
+            { "allocation_num", allocation.allocation_num_ },
+            { "allocated_bytes", allocation.allocated_bytes_ },
+            { "allocations_per_token", per_token },
+            { "is_over_budget", is_over_budget } });
+    }
+
+    if (!result_path.empty()) {
+        std::ofstream ofs(result_path);
+        ofs << result_json.dump(4) << std::endl;
+    }
+    if (!new_budget_path.empty()) {
+        std::ofstream ofs(new_budget_path);
+        ofs << FitBudgets(phase_allocations, margin).dump(4) << std::endl;
+    }
+    if (over_budget_num > 0) {
+        std::cout << over_budget_num << " phases are over the budgets\n";
+        return 1;
+    }
+    return 0;
+}
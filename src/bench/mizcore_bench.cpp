@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ast_block.hpp"
+#include "ast_token.hpp"
+#include "bench_runner.hpp"
+#include "error_table.hpp"
+#include "json_writer.hpp"
+#include "miz_block_parser.hpp"
+#include "miz_controller.hpp"
+#include "miz_lexer_handler.hpp"
+#include "miz_pattern_parser.hpp"
+#include "nlohmann/json.hpp"
+#include "pattern_table.hpp"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+
+#ifndef MIZCORE_BENCH_DATA_DIR
+#define MIZCORE_BENCH_DATA_DIR "tests/parser/data"
+#endif
+
+using mizcore::ASTBlock;
+using mizcore::BenchRunner;
+using mizcore::ErrorTable;
+using mizcore::JsonWriter;
+using mizcore::MizBlockParser;
+using mizcore::MizController;
+using mizcore::MizLexerHandler;
+using mizcore::MizPatternParser;
+using mizcore::SymbolTable;
+using mizcore::TOKEN_TYPE;
+using mizcore::TokenTable;
+namespace fs = std::filesystem;
+
+// Microbenchmarks of the phases over the articles of the test corpus:
+// vct loading, query map building, longest match queries, lexing, block
+// parsing, pattern parsing and JSON export. The results are printed in
+// microseconds per iteration and tokens per second, and are saved with -o so
+// that a later run compares with them by -b.
+//
+// Usage: mizcore_bench [-d DATA_DIR] [-n SAMPLES] [-f FILTER] [-o RESULT]
+//                      [-b BASELINE] [-t THRESHOLD]
+//   DATA_DIR  : the directory of mml.vct and *.miz (tests/parser/data)
+//   FILTER    : run only the benchmarks whose names contain it
+//   THRESHOLD : the ratio of the slowdown to the baseline which fails (0.1)
+
+namespace {
+
+// Keeps the results of the benchmarks from being optimized away.
+volatile size_t sink = 0;
+
+struct Article
+{
+    std::string name_;
+    std::string text_;
+    bool is_abs_mode_ = false;
+};
+
+std::shared_ptr<TokenTable>
+Lex(const Article& article,
+    const std::shared_ptr<const SymbolTable>& vocabulary,
+    std::shared_ptr<SymbolTable>* symbol_table = nullptr)
+{
+    auto fork = std::make_shared<SymbolTable>(vocabulary);
+    std::istringstream iss(article.text_);
+    MizLexerHandler miz_handler(&iss, fork);
+    miz_handler.yylex();
+    if (symbol_table != nullptr) {
+        *symbol_table = fork;
+    }
+    return miz_handler.GetTokenTable();
+}
+
+std::shared_ptr<ASTBlock>
+Parse(const Article& article,
+      const std::shared_ptr<TokenTable>& token_table,
+      const std::shared_ptr<ErrorTable>& error_table)
+{
+    MizBlockParser miz_block_parser(token_table, error_table);
+    miz_block_parser.SetABSMode(article.is_abs_mode_);
+    miz_block_parser.Parse();
+    return miz_block_parser.GetASTRoot();
+}
+
+// The texts from the symbol tokens to the ends of their lines, which are the
+// queries of the lexer.
+std::vector<std::string_view>
+CollectSymbolQueries(const Article& article, const TokenTable& token_table)
+{
+    std::vector<std::string_view> lines;
+    std::string_view text = article.text_;
+    for (size_t begin = 0; begin <= text.size();) {
+        size_t end = text.find('\n', begin);
+        end = end == std::string_view::npos ? text.size() : end;
+        lines.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    std::vector<std::string_view> queries;
+    for (size_t i = 0; i < token_table.GetTokenNum(); ++i) {
+        auto* token = token_table.GetToken(i);
+        if (token->GetTokenType() != TOKEN_TYPE::SYMBOL ||
+            static_cast<size_t>(token->GetLineNumber()) > lines.size()) {
+            continue;
+        }
+        auto line = lines[token->GetLineNumber() - 1];
+        size_t column = token->GetColumnNumber() - 1;
+        if (column < line.size()) {
+            queries.push_back(line.substr(column));
+        }
+    }
+    return queries;
+}
+
+void
+RunArticleBenchmarks(BenchRunner& runner,
+                     const Article& article,
+                     const std::shared_ptr<const SymbolTable>& vocabulary)
+{
+    std::shared_ptr<SymbolTable> symbol_table;
+    auto token_table = Lex(article, vocabulary, &symbol_table);
+    size_t token_num = token_table->GetTokenNum();
+    const auto& filenames = symbol_table->GetValidFileNames();
+    const std::string suffix = "/" + article.name_;
+
+    runner.Run("build_query_map" + suffix, 0, [&] {
+        auto fork = std::make_shared<SymbolTable>(vocabulary);
+        for (const auto& filename : filenames) {
+            fork->AddValidFileName(filename);
+        }
+        fork->BuildQueryMap();
+    });
+
+    auto queries = CollectSymbolQueries(article, *token_table);
+    runner.Run("query_longest_match" + suffix, queries.size(), [&] {
+        for (auto query : queries) {
+            sink = sink + (symbol_table->QueryLongestMatchSymbol(query) !=
+                           nullptr);
+        }
+    });
+
+    runner.Run("lex" + suffix, token_num, [&] {
+        sink = sink + Lex(article, vocabulary)->GetTokenNum();
+    });
+
+    // The parsers modify the tokens, which are lexed again for each
+    // iteration outside of the measurement.
+    std::shared_ptr<TokenTable> fresh_token_table;
+    std::shared_ptr<ErrorTable> error_table;
+    std::shared_ptr<ASTBlock> ast_root;
+    runner.Run(
+      "parse" + suffix,
+      token_num,
+      [&] { ast_root = Parse(article, fresh_token_table, error_table); },
+      [&] {
+          fresh_token_table = Lex(article, vocabulary);
+          error_table = std::make_shared<ErrorTable>();
+      });
+
+    std::string filename = article.name_;
+    for (auto& c : filename) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    runner.Run(
+      "pattern" + suffix,
+      token_num,
+      [&] {
+          MizPatternParser miz_pattern_parser(error_table);
+          miz_pattern_parser.ParseBlock(
+            ast_root.get(), fresh_token_table, filename);
+      },
+      [&] {
+          fresh_token_table = Lex(article, vocabulary);
+          error_table = std::make_shared<ErrorTable>();
+          ast_root = Parse(article, fresh_token_table, error_table);
+      });
+
+    error_table = std::make_shared<ErrorTable>();
+    ast_root = Parse(article, token_table, error_table);
+    runner.Run("json_dom" + suffix, token_num, [&] {
+        nlohmann::json tokens_json;
+        token_table->ToJson(tokens_json);
+        nlohmann::json blocks_json;
+        ast_root->ToJson(blocks_json);
+        sink = sink + tokens_json.dump(4).size() + blocks_json.dump(4).size();
+    });
+    runner.Run("json_stream" + suffix, token_num, [&] {
+        std::string tokens_json;
+        std::string blocks_json;
+        {
+            JsonWriter tokens_writer(tokens_json, 4);
+            token_table->WriteJson(tokens_writer);
+            JsonWriter blocks_writer(blocks_json, 4);
+            ast_root->WriteJson(blocks_writer);
+        }
+        sink = sink + tokens_json.size() + blocks_json.size();
+    });
+}
+
+// Parses a count of the command line, which must be a decimal number.
+bool
+ParseCount(const std::string& text, size_t& count)
+{
+    if (text.empty() ||
+        !std::all_of(text.begin(), text.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        })) {
+        return false;
+    }
+    try {
+        count = std::stoul(text);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+// Parses a non-negative number of the command line.
+bool
+ParseRatio(const std::string& text, double& ratio)
+{
+    size_t length = 0;
+    try {
+        ratio = std::stod(text, &length);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return length == text.size() && ratio >= 0.0;
+}
+
+int
+PrintUsage()
+{
+    std::cerr << "Usage: mizcore_bench [-d DATA_DIR] [-n SAMPLES] [-f FILTER] "
+                 "[-o RESULT] [-b BASELINE] [-t THRESHOLD]\n";
+    return 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    fs::path data_dir = MIZCORE_BENCH_DATA_DIR;
+    size_t sample_num = 5;
+    std::string filter;
+    std::string result_path;
+    std::string baseline_path;
+    double threshold = 0.1;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help" || i + 1 >= argc) {
+            return PrintUsage();
+        }
+        std::string value = argv[++i];
+        if (argument == "-d") {
+            data_dir = value;
+        } else if (argument == "-n") {
+            if (!ParseCount(value, sample_num)) {
+                return PrintUsage();
+            }
+        } else if (argument == "-f") {
+            filter = value;
+        } else if (argument == "-o") {
+            result_path = value;
+        } else if (argument == "-b") {
+            baseline_path = value;
+        } else if (argument == "-t") {
+            if (!ParseRatio(value, threshold)) {
+                return PrintUsage();
+            }
+        } else {
+            return PrintUsage();
+        }
+    }
+
+    std::vector<Article> articles;
+    for (const auto& entry : fs::directory_iterator(data_dir)) {
+        const auto& path = entry.path();
+        if (path.extension() != ".miz") {
+            continue;
+        }
+        std::ifstream ifs(path);
+        Article article;
+        article.name_ = path.stem().string();
+        article.text_.assign(std::istreambuf_iterator<char>(ifs),
+                             std::istreambuf_iterator<char>());
+        article.is_abs_mode_ = article.name_.size() >= 4 &&
+                               article.name_.compare(
+                                 article.name_.size() - 4, 4, "_abs") == 0;
+        articles.push_back(std::move(article));
+    }
+    std::sort(articles.begin(),
+              articles.end(),
+              [](const Article& lhs, const Article& rhs) {
+                  return lhs.name_ < rhs.name_;
+              });
+    fs::path vctpath = data_dir / "mml.vct";
+    if (!fs::is_regular_file(vctpath) || articles.empty()) {
+        std::cerr << "No mml.vct or articles in " << data_dir << "\n";
+        return 1;
+    }
+
+    BenchRunner runner(sample_num);
+    runner.SetFilter(filter);
+    runner.Run("load_vocabulary", 0, [&] {
+        sink = sink + (MizController::LoadVocabulary(vctpath.string().c_str())
+                         ->GetValidFileNames()
+                         .size());
+    });
+    std::shared_ptr<const SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.string().c_str());
+    for (const auto& article : articles) {
+        RunArticleBenchmarks(runner, article, vocabulary);
+    }
+    runner.Print(std::cout);
+
+    if (!result_path.empty()) {
+        nlohmann::json json;
+        runner.ToJson(json);
+        std::ofstream ofs(result_path);
+        ofs << json.dump(4) << std::endl;
+    }
+    if (!baseline_path.empty()) {
+        std::cout << "\n";
+        auto regression_num =
+          runner.CompareWithBaseline(baseline_path, threshold, std::cout);
+        if (!regression_num) {
+            return 1;
+        }
+        if (*regression_num > 0) {
+            std::cout << *regression_num
+                      << " benchmarks are slower than the baseline\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "article_generator.hpp"
+#include "ast_block.hpp"
+#include "bench_runner.hpp"
+#include "error_table.hpp"
+#include "miz_block_parser.hpp"
+#include "miz_controller.hpp"
+#include "miz_lexer_handler.hpp"
+#include "nlohmann/json.hpp"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+
+#ifndef MIZCORE_BENCH_DATA_DIR
+#define MIZCORE_BENCH_DATA_DIR "tests/parser/data"
+#endif
+
+using mizcore::ARTICLE_SHAPE;
+using mizcore::BenchResult;
+using mizcore::BenchRunner;
+using mizcore::ErrorTable;
+using mizcore::MizBlockParser;
+using mizcore::MizController;
+using mizcore::MizLexerHandler;
+using mizcore::SymbolTable;
+using mizcore::TokenTable;
+namespace fs = std::filesystem;
+
+// Scaling benchmark over the synthetic articles. For each shape, the lexer and
+// the block parser are measured over the articles of a geometric series of
+// sizes, and the exponent of the time to the number of tokens is fitted by
+// the least squares on the log-log scale. The phases whose exponents exceed
+// the maximum, i.e. which are worse than linear, are flagged and fail.
+//
+// Usage: mizcore_scaling [-d DATA_DIR] [-s SHAPE] [-m MIN_SIZE] [-k STEPS]
+//                        [-n SAMPLES] [-e MAX_EXPONENT] [-o RESULT]
+//   DATA_DIR     : the directory of mml.vct (tests/parser/data)
+//   SHAPE        : run only the shape, e.g. nested_proofs (all the shapes)
+//   MIN_SIZE     : the size of the smallest article (256)
+//   STEPS        : the number of the sizes, each double the previous one (5)
+//   MAX_EXPONENT : the exponent above which a phase is flagged (1.3)
+
+namespace {
+
+constexpr ARTICLE_SHAPE SHAPES[] = {
+    ARTICLE_SHAPE::MIXED,         ARTICLE_SHAPE::LABELS,
+    ARTICLE_SHAPE::NESTED_PROOFS, ARTICLE_SHAPE::SYMBOL_RUNS,
+    ARTICLE_SHAPE::COMMENTS,      ARTICLE_SHAPE::WHERE_CLAUSES,
+};
+
+constexpr const char* PHASES[] = { "lex", "parse" };
+
+// Keeps the results of the benchmarks from being optimized away.
+volatile size_t sink = 0;
+
+std::shared_ptr<TokenTable>
+Lex(const std::string& text,
+    const std::shared_ptr<const SymbolTable>& vocabulary)
+{
+    auto symbol_table = std::make_shared<SymbolTable>(vocabulary);
+    std::istringstream iss(text);
+    MizLexerHandler miz_handler(&iss, symbol_table);
+    miz_handler.yylex();
+    return miz_handler.GetTokenTable();
+}
+
+// The slope of the least squares line of log(seconds) to log(token_num).
+double
+FitExponent(const std::vector<std::pair<double, double>>& points)
+{
+    double n = 0.0;
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double sum_xx = 0.0;
+    double sum_xy = 0.0;
+    for (const auto& [token_num, seconds] : points) {
+        if (token_num <= 0.0 || seconds <= 0.0) {
+            continue;
+        }
+        double x = std::log(token_num);
+        double y = std::log(seconds);
+        n += 1.0;
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+    }
+    double denominator = n * sum_xx - sum_x * sum_x;
+    if (n < 2.0 || denominator <= 0.0) {
+        return 0.0;
+    }
+    return (n * sum_xy - sum_x * sum_y) / denominator;
+}
+
+int
+PrintUsage()
+{
+    std::cerr << "Usage: mizcore_scaling [-d DATA_DIR] [-s SHAPE] "
+                 "[-m MIN_SIZE] [-k STEPS] [-n SAMPLES] [-e MAX_EXPONENT] "
+                 "[-o RESULT]\n";
+    return 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    fs::path data_dir = MIZCORE_BENCH_DATA_DIR;
+    ARTICLE_SHAPE only_shape = ARTICLE_SHAPE::UNKNOWN;
+    size_t min_size = 256;
+    size_t step_num = 5;
+    size_t sample_num = 3;
+    double max_exponent = 1.3;
+    std::string result_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "-h" || argument == "--help" || i + 1 >= argc) {
+            return PrintUsage();
+        }
+        std::string value = argv[++i];
+        if (argument == "-d") {
+            data_dir = value;
+        } else if (argument == "-s") {
+            only_shape = mizcore::QueryArticleShape(value);
+            if (only_shape == ARTICLE_SHAPE::UNKNOWN) {
+                std::cerr << "Unknown shape: " << value << "\n";
+                return 1;
+            }
+        } else if (argument == "-m") {
+            min_size = std::stoul(value);
+        } else if (argument == "-k") {
+            step_num = std::stoul(value);
+        } else if (argument == "-n") {
+            sample_num = std::stoul(value);
+        } else if (argument == "-e") {
+            max_exponent = std::stod(value);
+        } else if (argument == "-o") {
+            result_path = value;
+        } else {
+            return PrintUsage();
+        }
+    }
+
+    if (min_size == 0 || step_num < 2) {
+        std::cerr << "The sizes must be positive and at least two\n";
+        return 1;
+    }
+    fs::path vctpath = data_dir / "mml.vct";
+    if (!fs::is_regular_file(vctpath)) {
+        std::cerr << "No mml.vct in " << data_dir << "\n";
+        return 1;
+    }
+    std::shared_ptr<const SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.string().c_str());
+
+    BenchRunner runner(sample_num);
+    nlohmann::json result_json = nlohmann::json::array();
+    size_t superlinear_num = 0;
+    char line[256];
+    std::snprintf(line,
+                  sizeof(line),
+                  "%-16s %-8s %10s %10s %10s\n",
+                  "shape",
+                  "phase",
+                  "tokens",
+                  "us",
+                  "exponent");
+    std::string summary = line;
+
+    for (auto shape : SHAPES) {
+        if (only_shape != ARTICLE_SHAPE::UNKNOWN && shape != only_shape) {
+            continue;
+        }
+        std::string shape_text(mizcore::QueryArticleShapeText(shape));
+        std::vector<std::pair<double, double>> phase_points[2];
+        for (size_t step = 0, size = min_size; step < step_num;
+             ++step, size *= 2) {
+            std::string text = mizcore::GenerateArticle(shape, size);
+            size_t token_num = Lex(text, vocabulary)->GetTokenNum();
+            std::string suffix =
+              "/" + shape_text + "/" + std::to_string(size);
+
+            const BenchResult* result =
+              runner.Run(PHASES[0] + suffix, token_num, [&] {
+                  sink = sink + Lex(text, vocabulary)->GetTokenNum();
+              });
+            phase_points[0].emplace_back(token_num, result->seconds_);
+
+            // The parser modifies the tokens, which are lexed again for each
+            // iteration outside of the measurement.
+            std::shared_ptr<TokenTable> token_table;
+            result = runner.Run(
+              PHASES[1] + suffix,
+              token_num,
+              [&] {
+                  MizBlockParser miz_block_parser(
+                    token_table, std::make_shared<ErrorTable>());
+                  miz_block_parser.Parse();
+                  sink = sink +
+                         miz_block_parser.GetASTRoot()->GetChildComponentNum();
+              },
+              [&] { token_table = Lex(text, vocabulary); });
+            phase_points[1].emplace_back(token_num, result->seconds_);
+        }
+
+        for (size_t i = 0; i < 2; ++i) {
+            const auto& points = phase_points[i];
+            double exponent = FitExponent(points);
+            bool is_superlinear = exponent > max_exponent;
+            if (is_superlinear) {
+                ++superlinear_num;
+            }
+            std::snprintf(line,
+                          sizeof(line),
+                          "%-16s %-8s %10.0f %10.2f %10.3f%s\n",
+                          shape_text.c_str(),
+                          PHASES[i],
+                          points.back().first,
+                          points.back().second * 1e6,
+                          exponent,
+                          is_superlinear ? "  SUPERLINEAR" : "");
+            summary += line;
+            result_json.push_back({ { "shape", shape_text },
+                                    { "phase", PHASES[i] },
+                                    { "exponent", exponent },
+                                    { "is_superlinear", is_superlinear } });
+        }
+    }
+    runner.Print(std::cout);
+    std::cout << "\n" << summary;
+
+    if (!result_path.empty()) {
+        nlohmann::json json;
+        runner.ToJson(json);
+        std::ofstream ofs(result_path);
+        ofs << nlohmann::json{ { "results", json },
+                               { "exponents", result_json } }
+                 .dump(4)
+            << std::endl;
+    }
+    if (superlinear_num > 0) {
+        std::cout << superlinear_num
+                  << " phases scale worse than linear (exponent > "
+                  << max_exponent << ")\n";
+        return 1;
+    }
+    return 0;
+}
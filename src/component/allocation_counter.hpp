@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mizcore {
+
+// Counts the allocations by the global operator new on all threads. The
+// counters stay zero unless the executable links mizcore::allocation_hook,
+// which replaces operator new, so that the library costs nothing otherwise.
+class AllocationCounter
+{
+  public:
+    // attributes
+    static bool IsHooked()
+    {
+        return is_hooked_.load(std::memory_order_relaxed);
+    }
+    static uint64_t GetAllocationNum()
+    {
+        return allocation_num_.load(std::memory_order_relaxed);
+    }
+    static uint64_t GetAllocatedBytes()
+    {
+        return allocated_bytes_.load(std::memory_order_relaxed);
+    }
+
+    // operations
+    // Called by the hook.
+    static void SetHooked() { is_hooked_.store(true); }
+    static void Add(size_t size)
+    {
+        allocation_num_.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+  private:
+    inline static std::atomic<bool> is_hooked_{ false };
+    inline static std::atomic<uint64_t> allocation_num_{ 0 };
+    inline static std::atomic<uint64_t> allocated_bytes_{ 0 };
+};
+
+} // namespace mizcore
@@ -0,0 +1,93 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.hpp"
+
+using mizcore::AllocationCounter;
+
+// Replacements of the global operator new and delete, which count the
+// allocations in AllocationCounter. This file is built as an object library
+// so that the replacements are linked only into the executables which ask for
+// them. The aligned variants are left to the standard library.
+
+namespace {
+
+void*
+Allocate(size_t size)
+{
+    AllocationCounter::Add(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+[[maybe_unused]] const bool IS_HOOKED =
+  (AllocationCounter::SetHooked(), true);
+
+} // namespace
+
+void*
+operator new(size_t size)
+{
+    void* p = Allocate(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void*
+operator new[](size_t size)
+{
+    void* p = Allocate(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void*
+operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void*
+operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return Allocate(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
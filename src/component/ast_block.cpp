@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 
 #include "ast_block.hpp"
 #include "ast_statement.hpp"
@@ -26,11 +28,39 @@ ASTBlock::GetChildStatement(size_t i) const
              : nullptr;
 }
 
+void
+ASTBlock::ReleaseChildComponents(size_t end)
+{
+    assert(end <= child_components_.size());
+    for (size_t i = released_child_component_num_; i < end; ++i) {
+        child_components_[i].reset();
+    }
+    released_child_component_num_ =
+      std::max(released_child_component_num_, end);
+}
+
+void
+ASTBlock::DetachChildComponents(
+  size_t begin,
+  std::vector<std::unique_ptr<ASTComponent>>& components)
+{
+    assert(released_child_component_num_ <= begin);
+    assert(begin <= child_components_.size());
+    std::move(child_components_.begin() + begin,
+              child_components_.end(),
+              std::back_inserter(components));
+    child_components_.erase(child_components_.begin() + begin,
+                            child_components_.end());
+}
+
 void
 ASTBlock::ToJson(nlohmann::json& json) const
 {
     ASTComponent::ToJson(json);
     for (const auto& child_component : child_components_) {
+        if (!child_component) {
+            continue;
+        }
         nlohmann::json child_json;
         child_component->ToJson(child_json);
         json["children"].push_back(child_json);
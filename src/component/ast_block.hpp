@@ -58,6 +58,18 @@ class ASTBlock : public ASTComponent
         child_components_.push_back(std::move(component));
     }
     void PopBackChildComponent() { child_components_.pop_back(); }
+    // Delete the child components [0, end). GetChildComponent() returns
+    // nullptr for them afterwards.
+    void ReleaseChildComponents(size_t end);
+    size_t GetReleasedChildComponentNum() const
+    {
+        return released_child_component_num_;
+    }
+    // Remove the child components [begin, GetChildComponentNum()) and append
+    // them to components in order.
+    void DetachChildComponents(
+      size_t begin,
+      std::vector<std::unique_ptr<ASTComponent>>& components);
 
     // operations
     void ToJson(nlohmann::json& json) const override;
@@ -68,6 +80,7 @@ class ASTBlock : public ASTComponent
     ASTToken* last_token_ = nullptr;
     ASTToken* semicolon_token_ = nullptr;
     std::vector<std::unique_ptr<ASTComponent>> child_components_;
+    size_t released_child_component_num_ = 0;
 };
 
 } // namespace mizcore
@@ -1,7 +1,28 @@
+#include "ast_block.hpp"
 #include "ast_component.hpp"
+#include "ast_statement.hpp"
 #include "ast_token.hpp"
+#include "json_writer.hpp"
 
+using mizcore::ASTBlock;
 using mizcore::ASTComponent;
+using mizcore::ASTStatement;
+using mizcore::ASTToken;
+using mizcore::ELEMENT_TYPE;
+using mizcore::JsonWriter;
+
+namespace {
+
+void
+WritePosition(const ASTToken* token, JsonWriter& writer)
+{
+    writer.BeginArray();
+    writer.Int(token->GetLineNumber());
+    writer.Int(token->GetColumnNumber());
+    writer.EndArray();
+}
+
+} // namespace
 
 void
 ASTComponent::ToJson(nlohmann::json& json) const
@@ -31,3 +52,64 @@ ASTComponent::ToJson(nlohmann::json& json) const
         }
     }
 }
+
+void
+ASTComponent::WriteJson(JsonWriter& writer) const
+{
+    // The keys are in the order of nlohmann::json.
+    writer.BeginObject();
+    auto element_type = GetElementType();
+    if (element_type == ELEMENT_TYPE::BLOCK) {
+        const auto* block = static_cast<const ASTBlock*>(this);
+        bool has_children = false;
+        for (size_t i = block->GetReleasedChildComponentNum();
+             i < block->GetChildComponentNum();
+             ++i) {
+            if (!has_children) {
+                writer.Key("children");
+                writer.BeginArray();
+                has_children = true;
+            }
+            block->GetChildComponent(i)->WriteJson(writer);
+        }
+        if (has_children) {
+            writer.EndArray();
+        }
+    }
+
+    const auto* first_token = GetRangeFirstToken();
+    const auto* last_token = GetRangeLastToken();
+    bool has_range = first_token != nullptr && last_token != nullptr &&
+                     first_token->GetId() != SIZE_MAX &&
+                     last_token->GetId() != SIZE_MAX;
+    if (has_range) {
+        writer.Key("pos");
+        if (first_token->GetId() == last_token->GetId()) {
+            WritePosition(first_token, writer);
+        } else {
+            writer.BeginArray();
+            WritePosition(first_token, writer);
+            WritePosition(last_token, writer);
+            writer.EndArray();
+        }
+    }
+    if (element_type == ELEMENT_TYPE::STATEMENT) {
+        writer.Key("statement_type");
+        writer.String(QueryStatementTypeText(
+          static_cast<const ASTStatement*>(this)->GetStatementType()));
+    }
+    if (has_range) {
+        writer.Key("token_id");
+        if (first_token->GetId() == last_token->GetId()) {
+            writer.UInt(first_token->GetId());
+        } else {
+            writer.BeginArray();
+            writer.UInt(first_token->GetId());
+            writer.UInt(last_token->GetId());
+            writer.EndArray();
+        }
+    }
+    writer.Key("type");
+    writer.String(QueryElementTypeText(element_type));
+    writer.EndObject();
+}
@@ -9,6 +9,7 @@ namespace mizcore {
 
 class ASTBlock;
 class ASTToken;
+class JsonWriter;
 
 class ASTComponent : public ASTElement
 {
@@ -34,6 +35,8 @@ class ASTComponent : public ASTElement
 
     // operations
     void ToJson(nlohmann::json& json) const override = 0;
+    // Writes the same JSON as ToJson() of the blocks and the statements.
+    void WriteJson(JsonWriter& writer) const;
 
   private:
     ASTBlock* parent_ = nullptr;
@@ -0,0 +1,135 @@
+#include "ast_block.hpp"
+#include "ast_query.hpp"
+#include "ast_statement.hpp"
+#include "ast_token.hpp"
+#include "token_table.hpp"
+
+using mizcore::ASTBlock;
+using mizcore::ASTComponent;
+using mizcore::ASTStatement;
+using mizcore::ASTToken;
+using mizcore::ComponentQuery;
+using mizcore::ELEMENT_TYPE;
+using mizcore::IdentifierToken;
+using mizcore::KeywordToken;
+using mizcore::TOKEN_TYPE;
+using mizcore::TokenQuery;
+using mizcore::TokenTable;
+
+namespace {
+
+// A missing token leaves the range open on its side.
+bool
+IsOverlapping(const ASTComponent* component, const ComponentQuery& query)
+{
+    const ASTToken* first_token = component->GetRangeFirstToken();
+    const ASTToken* last_token = component->GetRangeLastToken();
+    return (first_token == nullptr ||
+            first_token->GetLineNumber() <= query.last_line_number_) &&
+           (last_token == nullptr ||
+            last_token->GetLineNumber() >= query.first_line_number_);
+}
+
+bool
+IsMatching(const ASTComponent* component, const ComponentQuery& query)
+{
+    auto element_type = component->GetElementType();
+    if (query.element_type_ != ELEMENT_TYPE::UNKNOWN &&
+        query.element_type_ != element_type) {
+        return false;
+    }
+    if (element_type == ELEMENT_TYPE::BLOCK) {
+        return !query.block_type_ ||
+               *query.block_type_ ==
+                 static_cast<const ASTBlock*>(component)->GetBlockType();
+    }
+    return !query.statement_type_ ||
+           *query.statement_type_ ==
+             static_cast<const ASTStatement*>(component)->GetStatementType();
+}
+
+void
+CollectComponents(const ASTComponent* component,
+                  const ComponentQuery& query,
+                  std::vector<ASTComponent*>& components)
+{
+    if (!IsOverlapping(component, query)) {
+        return;
+    }
+    if (IsMatching(component, query)) {
+        components.push_back(const_cast<ASTComponent*>(component));
+    }
+    if (component->GetElementType() != ELEMENT_TYPE::BLOCK) {
+        return;
+    }
+    const auto* block = static_cast<const ASTBlock*>(component);
+    for (size_t i = block->GetReleasedChildComponentNum();
+         i < block->GetChildComponentNum();
+         ++i) {
+        CollectComponents(block->GetChildComponent(i), query, components);
+    }
+}
+
+bool
+IsMatching(const ASTToken* token, const TokenQuery& query)
+{
+    auto token_type = token->GetTokenType();
+    if (query.token_type_ && *query.token_type_ != token_type) {
+        return false;
+    }
+    if (query.identifier_type_ &&
+        (token_type != TOKEN_TYPE::IDENTIFIER ||
+         *query.identifier_type_ !=
+           static_cast<const IdentifierToken*>(token)->GetIdentifierType())) {
+        return false;
+    }
+    if (query.keyword_type_ &&
+        (token_type != TOKEN_TYPE::KEYWORD ||
+         *query.keyword_type_ !=
+           static_cast<const KeywordToken*>(token)->GetKeywordType())) {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<ASTComponent*>
+mizcore::QueryComponents(const ASTBlock* root, const ComponentQuery& query)
+{
+    std::vector<ASTComponent*> components;
+    if (root != nullptr) {
+        CollectComponents(root, query, components);
+    }
+    return components;
+}
+
+std::vector<uint32_t>
+mizcore::QueryTokenIds(const TokenTable& token_table, const TokenQuery& query)
+{
+    // The tokens are in the order of their positions, so that the first
+    // token of the line range is found by binary search.
+    size_t begin = token_table.GetFirstTokenId();
+    size_t end = token_table.GetTokenNum();
+    for (size_t last = end; begin < last;) {
+        size_t middle = begin + (last - begin) / 2;
+        if (token_table.GetToken(middle)->GetLineNumber() <
+            query.first_line_number_) {
+            begin = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    std::vector<uint32_t> ids;
+    for (size_t id = begin; id < end; ++id) {
+        const ASTToken* token = token_table.GetToken(id);
+        if (token->GetLineNumber() > query.last_line_number_) {
+            break;
+        }
+        if (IsMatching(token, query)) {
+            ids.push_back(static_cast<uint32_t>(id));
+        }
+    }
+    return ids;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "ast_type.hpp"
+
+namespace mizcore {
+
+class ASTBlock;
+class ASTComponent;
+class TokenTable;
+
+// Conditions of QueryComponents(). The unset ones match all the components.
+struct ComponentQuery
+{
+    // UNKNOWN matches both the blocks and the statements.
+    ELEMENT_TYPE element_type_ = ELEMENT_TYPE::UNKNOWN;
+    // Applied to the blocks and the statements respectively.
+    std::optional<BLOCK_TYPE> block_type_;
+    std::optional<STATEMENT_TYPE> statement_type_;
+    // The components whose token ranges overlap the lines [first, last].
+    int first_line_number_ = 0;
+    int last_line_number_ = INT_MAX;
+};
+
+// Conditions of QueryTokenIds(). The unset ones match all the tokens.
+struct TokenQuery
+{
+    std::optional<TOKEN_TYPE> token_type_;
+    // Applied to the identifiers and the keywords respectively, and the other
+    // tokens never match them.
+    std::optional<IDENTIFIER_TYPE> identifier_type_;
+    std::optional<KEYWORD_TYPE> keyword_type_;
+    // The tokens on the lines [first, last].
+    int first_line_number_ = 0;
+    int last_line_number_ = INT_MAX;
+};
+
+// The components of the subtree of root, including root, in pre-order. The
+// blocks out of the line range are skipped with their subtrees.
+std::vector<ASTComponent*>
+QueryComponents(const ASTBlock* root, const ComponentQuery& query);
+
+// The ids of the tokens of token_table in ascending order.
+std::vector<uint32_t>
+QueryTokenIds(const TokenTable& token_table, const TokenQuery& query);
+
+} // namespace mizcore
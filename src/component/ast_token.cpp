@@ -1,4 +1,5 @@
 #include "ast_token.hpp"
+#include "json_writer.hpp"
 #include "symbol.hpp"
 
 using std::string;
@@ -9,8 +10,13 @@ using mizcore::SPECIAL_SYMBOL_TYPE;
 using mizcore::SYMBOL_TYPE;
 
 using mizcore::ASTToken;
+using mizcore::CommentToken;
 using mizcore::IdentifierToken;
+using mizcore::JsonWriter;
+using mizcore::KeywordToken;
+using mizcore::Symbol;
 using mizcore::SymbolToken;
+using mizcore::TOKEN_TYPE;
 
 void
 ASTToken::ToJson(nlohmann::json& json) const
@@ -22,6 +28,76 @@ ASTToken::ToJson(nlohmann::json& json) const
              { "text", string(GetText()) } };
 }
 
+void
+ASTToken::WriteJson(JsonWriter& writer) const
+{
+    // The keys are in the order of nlohmann::json.
+    auto token_type = GetTokenType();
+    const Symbol* symbol =
+      token_type == TOKEN_TYPE::SYMBOL
+        ? static_cast<const SymbolToken*>(this)->GetSymbol()
+        : nullptr;
+    const IdentifierToken* identifier_token =
+      token_type == TOKEN_TYPE::IDENTIFIER
+        ? static_cast<const IdentifierToken*>(this)
+        : nullptr;
+
+    writer.BeginObject();
+    writer.Key("id");
+    writer.UInt(GetId());
+    if (identifier_token != nullptr) {
+        writer.Key("identifier_type");
+        writer.String(
+          QueryIdentifierTypeText(identifier_token->GetIdentifierType()));
+    }
+    writer.Key("length");
+    writer.UInt(GetText().size());
+    writer.Key("pos");
+    writer.BeginArray();
+    writer.UInt(line_number_);
+    writer.UInt(column_number_);
+    writer.EndArray();
+    if (symbol != nullptr) {
+        writer.Key("priority");
+        writer.Int(symbol->GetPriority());
+    }
+    if (identifier_token != nullptr &&
+        identifier_token->GetRefToken() != nullptr) {
+        writer.Key("ref_id");
+        writer.UInt(identifier_token->GetRefToken()->GetId());
+    }
+    if (symbol != nullptr) {
+        writer.Key("symbol_type");
+        writer.String(symbol->GetTypeString());
+    }
+    writer.Key("text");
+    writer.String(GetText());
+    writer.Key("type");
+    writer.String(QueryTokenTypeText(token_type));
+    writer.EndObject();
+}
+
+uint8_t
+ASTToken::GetSubType() const
+{
+    switch (GetTokenType()) {
+        case TOKEN_TYPE::KEYWORD:
+            return static_cast<uint8_t>(
+              static_cast<const KeywordToken*>(this)->GetKeywordType());
+        case TOKEN_TYPE::IDENTIFIER:
+            return static_cast<uint8_t>(
+              static_cast<const IdentifierToken*>(this)->GetIdentifierType());
+        case TOKEN_TYPE::COMMENT:
+            return static_cast<uint8_t>(
+              static_cast<const CommentToken*>(this)->GetCommentType());
+        case TOKEN_TYPE::SYMBOL:
+            return static_cast<uint8_t>(
+              static_cast<const SymbolToken*>(this)->GetSymbolType());
+        default:
+            return 0;
+    }
+}
+
 std::string_view
 SymbolToken::GetText() const
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -12,6 +13,7 @@ namespace mizcore {
 
 class Symbol;
 class IdentifierToken;
+class JsonWriter;
 
 class ASTToken : public ASTElement
 {
@@ -33,15 +35,21 @@ class ASTToken : public ASTElement
     size_t GetId() const { return id_; }
     void SetId(size_t id) { id_ = id; }
     int GetLineNumber() const { return line_number_; }
+    void SetLineNumber(size_t line_number) { line_number_ = line_number; }
     int GetColumnNumber() const { return column_number_; }
     virtual std::string_view GetText() const = 0;
     virtual TOKEN_TYPE GetTokenType() const = 0;
     virtual IdentifierToken* GetRefToken() const = 0;
+    // KEYWORD_TYPE, IDENTIFIER_TYPE, COMMENT_TYPE or SYMBOL_TYPE according to
+    // the token type, or zero for the others.
+    uint8_t GetSubType() const;
     void SetFormattedText(std::string_view text) { formatted_text_ = text; }
     std::string_view GetFormattedText() const { return formatted_text_; };
 
     // operations
     void ToJson(nlohmann::json& json) const override;
+    // Writes the same JSON as ToJson() of every token type.
+    void WriteJson(JsonWriter& writer) const;
 
   private:
     size_t id_ = SIZE_MAX;
@@ -103,6 +111,7 @@ class SymbolToken : public ASTToken
     // attributes
     std::string_view GetText() const override;
     TOKEN_TYPE GetTokenType() const override { return TOKEN_TYPE::SYMBOL; }
+    Symbol* GetSymbol() const { return symbol_; }
     SYMBOL_TYPE GetSymbolType() const;
     SPECIAL_SYMBOL_TYPE GetSpecialSymbolType() const;
     IdentifierToken* GetRefToken() const override { return nullptr; }
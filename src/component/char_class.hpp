@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace mizcore {
+
+// Locale independent character classes.
+// Only ASCII characters are classified. Bytes >= 0x80 belong to no class, which
+// matches the behavior of <cctype> functions in the "C" locale.
+enum class CHAR_CLASS : uint8_t
+{
+    NONE = 0,
+    ALPHA = 1U << 0U,
+    DIGIT = 1U << 1U,
+    UNDERSCORE = 1U << 2U,
+    APOSTROPHE = 1U << 3U,
+    GRAPH = 1U << 4U,
+    SPACE = 1U << 5U,
+
+    ALNUM = ALPHA | DIGIT,
+    // [[:alnum:]_] : characters which glue a symbol to its neighbors
+    WORD = ALNUM | UNDERSCORE,
+    // [[:alnum:]_'] : characters of IDENTIFIER in yy_miz_flex_lexer.l
+    IDENTIFIER = WORD | APOSTROPHE,
+};
+
+constexpr CHAR_CLASS
+operator|(CHAR_CLASS lhs, CHAR_CLASS rhs)
+{
+    return static_cast<CHAR_CLASS>(static_cast<uint8_t>(lhs) |
+                                   static_cast<uint8_t>(rhs));
+}
+
+namespace detail {
+
+constexpr std::array<uint8_t, 256>
+BuildCharClassTable()
+{
+    std::array<uint8_t, 256> table = {};
+    for (size_t c = 0; c < table.size(); ++c) {
+        uint8_t bits = 0;
+        if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')) {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::ALPHA);
+        }
+        if ('0' <= c && c <= '9') {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::DIGIT);
+        }
+        if (c == '_') {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::UNDERSCORE);
+        }
+        if (c == '\'') {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::APOSTROPHE);
+        }
+        if (0x21 <= c && c <= 0x7e) {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::GRAPH);
+        }
+        if (c == ' ' || ('\t' <= c && c <= '\r')) {
+            bits |= static_cast<uint8_t>(CHAR_CLASS::SPACE);
+        }
+        table[c] = bits;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 256> CHAR_CLASS_TABLE =
+  BuildCharClassTable();
+
+} // namespace detail
+
+constexpr bool
+HasCharClass(char c, CHAR_CLASS char_class)
+{
+    return (detail::CHAR_CLASS_TABLE[static_cast<uint8_t>(c)] &
+            static_cast<uint8_t>(char_class)) != 0;
+}
+
+constexpr bool
+IsAlphaChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::ALPHA);
+}
+
+constexpr bool
+IsAlnumChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::ALNUM);
+}
+
+constexpr bool
+IsWordChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::WORD);
+}
+
+constexpr bool
+IsIdentifierChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::IDENTIFIER);
+}
+
+constexpr bool
+IsGraphChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::GRAPH);
+}
+
+constexpr bool
+IsSpaceChar(char c)
+{
+    return HasCharClass(c, CHAR_CLASS::SPACE);
+}
+
+// Returns the end position of the run of characters belonging to
+// char_class which starts at pos. Returns pos if text[pos] is not in the class.
+inline size_t
+ScanCharClassRun(std::string_view text, size_t pos, CHAR_CLASS char_class)
+{
+    const auto mask = static_cast<uint8_t>(char_class);
+    const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t n = text.size();
+
+    // Test 8 bytes per iteration without branching on each byte.
+    while (pos + 8 <= n) {
+        const auto& table = detail::CHAR_CLASS_TABLE;
+        const uint8_t* q = p + pos;
+        uint8_t all = static_cast<uint8_t>(table[q[0]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[1]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[2]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[3]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[4]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[5]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[6]] & mask ? 1U : 0U) &
+                      static_cast<uint8_t>(table[q[7]] & mask ? 1U : 0U);
+        if (all == 0) {
+            break;
+        }
+        pos += 8;
+    }
+
+    while (pos < n && (detail::CHAR_CLASS_TABLE[p[pos]] & mask) != 0) {
+        ++pos;
+    }
+    return pos;
+}
+
+} // namespace mizcore
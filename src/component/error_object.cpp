@@ -2,8 +2,10 @@
 
 #include "ast_token.hpp"
 #include "error_object.hpp"
+#include "json_writer.hpp"
 
 using mizcore::ErrorObject;
+using mizcore::JsonWriter;
 
 std::string
 ErrorObject::GetMessage() const
@@ -25,3 +27,38 @@ ErrorObject::GetMessage() const
 
     return oss.str();
 }
+
+void
+ErrorObject::ToJson(nlohmann::json& json) const
+{
+    auto error_level = mizcore::GetErrorLevel(error_type_);
+    json = { { "code", mizcore::GetErrorCode(error_type_) },
+             { "level", std::string(mizcore::GetErrorLevelText(error_level)) },
+             { "message", std::string(mizcore::GetErrorMessage(error_type_)) } };
+    if (ast_token_ != nullptr) {
+        json["pos"] = { ast_token_->GetLineNumber(),
+                        ast_token_->GetColumnNumber() };
+    }
+}
+
+void
+ErrorObject::WriteJson(JsonWriter& writer) const
+{
+    // The keys are in the order of nlohmann::json.
+    auto error_level = mizcore::GetErrorLevel(error_type_);
+    writer.BeginObject();
+    writer.Key("code");
+    writer.Int(mizcore::GetErrorCode(error_type_));
+    writer.Key("level");
+    writer.String(mizcore::GetErrorLevelText(error_level));
+    writer.Key("message");
+    writer.String(mizcore::GetErrorMessage(error_type_));
+    if (ast_token_ != nullptr) {
+        writer.Key("pos");
+        writer.BeginArray();
+        writer.Int(ast_token_->GetLineNumber());
+        writer.Int(ast_token_->GetColumnNumber());
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "error_def.hpp"
+#include "nlohmann/json.hpp"
 
 namespace mizcore {
 
 class ASTElement;
 class ASTToken;
+class JsonWriter;
 
 class ErrorObject
 {
@@ -26,6 +28,11 @@ class ErrorObject
     ASTToken* GetASTToken() const { return ast_token_; }
     std::string GetMessage() const;
 
+    // operations
+    void ToJson(nlohmann::json& json) const;
+    // Writes the same JSON as ToJson().
+    void WriteJson(JsonWriter& writer) const;
+
   private:
     ERROR_TYPE error_type_ = ERROR_TYPE::UNKNOWN;
     ASTToken* ast_token_ = nullptr;
@@ -4,11 +4,13 @@
 #include "ast_token.hpp"
 #include "error_object.hpp"
 #include "error_table.hpp"
+#include "json_writer.hpp"
 #include "spdlog/spdlog.h"
 
 using mizcore::ASTToken;
 using mizcore::ErrorObject;
 using mizcore::ErrorTable;
+using mizcore::JsonWriter;
 
 void
 ErrorTable::AddError(ErrorObject* error)
@@ -26,6 +28,27 @@ ErrorTable::LogErrors()
     }
 }
 
+void
+ErrorTable::ToJson(nlohmann::json& json) const
+{
+    json = nlohmann::json::array();
+    for (const auto& error : errors_) {
+        nlohmann::json j;
+        error->ToJson(j);
+        json.push_back(j);
+    }
+}
+
+void
+ErrorTable::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginArray();
+    for (const auto& error : errors_) {
+        error->WriteJson(writer);
+    }
+    writer.EndArray();
+}
+
 void
 ErrorTable::SortErrors()
 {
@@ -20,9 +20,15 @@ class ErrorTable
 
     // attributes
     void AddError(ErrorObject* error);
+    size_t GetErrorNum() const { return errors_.size(); }
+    ErrorObject* GetError(size_t i) const { return errors_[i].get(); }
+    void Clear() { errors_.clear(); }
 
     // operation
     void LogErrors();
+    void ToJson(nlohmann::json& json) const;
+    // Writes the same JSON as ToJson().
+    void WriteJson(JsonWriter& writer) const;
 
     // implementation
   private:
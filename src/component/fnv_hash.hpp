@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace mizcore {
+
+// 64-bit FNV-1a hash. A hash of concatenated data is computed by passing the
+// hash of the preceding data as the initial value.
+constexpr uint64_t FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV1A_PRIME = 0x100000001b3ULL;
+
+inline uint64_t
+Fnv1aHash(std::string_view data, uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t
+Fnv1aHash(uint64_t value, uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+    for (int i = 0; i < 8; ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+} // namespace mizcore
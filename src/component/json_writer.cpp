@@ -0,0 +1,171 @@
+#include <charconv>
+
+#include "json_writer.hpp"
+
+using mizcore::JsonWriter;
+
+namespace {
+
+// The output to a stream is written in chunks of this size.
+constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+} // namespace
+
+void
+JsonWriter::Key(std::string_view key)
+{
+    BeginValue();
+    WriteEscaped(key);
+    buffer_ += indent_ < 0 ? ":" : ": ";
+    is_after_key_ = true;
+}
+
+void
+JsonWriter::String(std::string_view value)
+{
+    BeginValue();
+    WriteEscaped(value);
+    FlushIfFull();
+}
+
+void
+JsonWriter::Int(int64_t value)
+{
+    BeginValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer_.append(digits, result.ptr);
+}
+
+void
+JsonWriter::UInt(uint64_t value)
+{
+    BeginValue();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer_.append(digits, result.ptr);
+}
+
+void
+JsonWriter::Bool(bool value)
+{
+    BeginValue();
+    buffer_ += value ? "true" : "false";
+}
+
+void
+JsonWriter::Null()
+{
+    BeginValue();
+    buffer_ += "null";
+}
+
+void
+JsonWriter::Flush()
+{
+    if (os_ != nullptr && !buffer_.empty()) {
+        os_->write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+}
+
+void
+JsonWriter::BeginValue()
+{
+    if (is_after_key_) {
+        is_after_key_ = false;
+        return;
+    }
+    if (has_element_stack_.empty()) {
+        return;
+    }
+    if (has_element_stack_.back()) {
+        buffer_ += ',';
+    }
+    has_element_stack_.back() = true;
+    NewLine(has_element_stack_.size());
+}
+
+void
+JsonWriter::BeginContainer(char bracket)
+{
+    BeginValue();
+    buffer_ += bracket;
+    has_element_stack_.push_back(false);
+}
+
+void
+JsonWriter::EndContainer(char bracket)
+{
+    bool has_element = has_element_stack_.back();
+    has_element_stack_.pop_back();
+    if (has_element) {
+        NewLine(has_element_stack_.size());
+    }
+    buffer_ += bracket;
+    FlushIfFull();
+}
+
+void
+JsonWriter::NewLine(size_t depth)
+{
+    if (indent_ < 0) {
+        return;
+    }
+    buffer_ += '\n';
+    buffer_.append(depth * indent_, ' ');
+}
+
+void
+JsonWriter::WriteEscaped(std::string_view text)
+{
+    static const char* hex_digits = "0123456789abcdef";
+    buffer_ += '"';
+    size_t begin = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        buffer_.append(text.data() + begin, i - begin);
+        begin = i + 1;
+        switch (c) {
+            case '"':
+                buffer_ += "\\\"";
+                break;
+            case '\\':
+                buffer_ += "\\\\";
+                break;
+            case '\b':
+                buffer_ += "\\b";
+                break;
+            case '\f':
+                buffer_ += "\\f";
+                break;
+            case '\n':
+                buffer_ += "\\n";
+                break;
+            case '\r':
+                buffer_ += "\\r";
+                break;
+            case '\t':
+                buffer_ += "\\t";
+                break;
+            default:
+                buffer_ += "\\u00";
+                buffer_ += hex_digits[c >> 4];
+                buffer_ += hex_digits[c & 0xf];
+                break;
+        }
+    }
+    buffer_.append(text.data() + begin, text.size() - begin);
+    buffer_ += '"';
+}
+
+void
+JsonWriter::FlushIfFull()
+{
+    if (buffer_.size() >= FLUSH_SIZE) {
+        Flush();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mizcore {
+
+// Streaming JSON writer which produces the same bytes as
+// nlohmann::json::dump(indent) of the equivalent DOM, without building it.
+// Since nlohmann::json sorts the keys of an object, the keys must be written
+// in lexicographical order. The strings are written as they are except for the
+// escaped characters, while nlohmann::json throws on invalid UTF-8.
+class JsonWriter
+{
+  public:
+    // ctor, dtor
+    // The output is appended to buffer, or written to os in large chunks.
+    // indent < 0 means the compact form as dump().
+    explicit JsonWriter(std::string& buffer, int indent = -1)
+      : buffer_(buffer)
+      , indent_(indent)
+    {}
+    explicit JsonWriter(std::ostream& os, int indent = -1)
+      : buffer_(own_buffer_)
+      , os_(&os)
+      , indent_(indent)
+    {}
+    virtual ~JsonWriter() { Flush(); }
+    JsonWriter(JsonWriter const&) = delete;
+    JsonWriter(JsonWriter&&) = delete;
+    JsonWriter& operator=(JsonWriter const&) = delete;
+    JsonWriter& operator=(JsonWriter&&) = delete;
+
+    // operations
+    void BeginObject() { BeginContainer('{'); }
+    void EndObject() { EndContainer('}'); }
+    void BeginArray() { BeginContainer('['); }
+    void EndArray() { EndContainer(']'); }
+    void Key(std::string_view key);
+    void String(std::string_view value);
+    void Int(int64_t value);
+    void UInt(uint64_t value);
+    void Bool(bool value);
+    void Null();
+    // Writes the output to the stream, if any.
+    void Flush();
+
+  private:
+    // implementation
+    void BeginValue();
+    void BeginContainer(char bracket);
+    void EndContainer(char bracket);
+    void NewLine(size_t depth);
+    void WriteEscaped(std::string_view text);
+    void FlushIfFull();
+
+    std::string own_buffer_;
+    std::string& buffer_;
+    std::ostream* os_ = nullptr;
+    int indent_;
+    // Whether each open container has an element.
+    std::vector<bool> has_element_stack_;
+    bool is_after_key_ = false;
+};
+
+} // namespace mizcore
@@ -0,0 +1,64 @@
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.hpp"
+
+using mizcore::MappedFile;
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool
+MappedFile::Open(const std::string& path)
+{
+    Close();
+#ifdef _WIN32
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return false;
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(ifs),
+                   std::istreambuf_iterator<char>());
+    data_ = buffer_;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st = {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    address_ = address;
+    data_ = std::string_view(static_cast<const char*>(address), st.st_size);
+#endif
+    return !data_.empty();
+}
+
+void
+MappedFile::Close()
+{
+#ifndef _WIN32
+    if (address_ != nullptr) {
+        munmap(address_, data_.size());
+        address_ = nullptr;
+    }
+#endif
+    buffer_.clear();
+    data_ = std::string_view();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace mizcore {
+
+// Read-only mapping of a whole file. The pages are shared with the other
+// processes which map the same file, e.g. a file under /dev/shm. On the
+// platforms without mmap, the file is read into a buffer instead.
+class MappedFile
+{
+  public:
+    // ctor, dtor
+    MappedFile() = default;
+    virtual ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    // attributes
+    bool IsOpen() const { return !data_.empty(); }
+    // Aligned to the page, or to the allocation of std::string.
+    std::string_view GetData() const { return data_; }
+
+    // operations
+    // Returns false if the file cannot be mapped or is empty.
+    bool Open(const std::string& path);
+    void Close();
+
+  private:
+    std::string_view data_;
+    void* address_ = nullptr;
+    // Used instead of a mapping on the platforms without mmap.
+    std::string buffer_;
+};
+
+} // namespace mizcore
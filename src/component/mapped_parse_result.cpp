@@ -0,0 +1,250 @@
+#include "mapped_parse_result.hpp"
+
+using mizcore::BLOCK_TYPE;
+using mizcore::COMMENT_TYPE;
+using mizcore::ComponentRecord;
+using mizcore::ELEMENT_TYPE;
+using mizcore::ERROR_TYPE;
+using mizcore::IDENTIFIER_TYPE;
+using mizcore::KEYWORD_TYPE;
+using mizcore::MappedComponent;
+using mizcore::MappedError;
+using mizcore::MappedParseResult;
+using mizcore::MappedToken;
+using mizcore::ParseResultSections;
+using mizcore::STATEMENT_TYPE;
+using mizcore::SYMBOL_TYPE;
+using mizcore::TOKEN_TYPE;
+using mizcore::TokenRecord;
+
+std::string_view
+MappedToken::GetText() const
+{
+    const auto& record = GetRecord();
+    if (GetTokenType() == TOKEN_TYPE::KEYWORD) {
+        return QueryKeywordText(static_cast<KEYWORD_TYPE>(record.sub_type_));
+    }
+    return result_->GetSections().string_pool_.substr(record.text_.offset_,
+                                                      record.text_.length_);
+}
+
+std::optional<MappedToken>
+MappedToken::GetRefToken() const
+{
+    uint32_t ref_token_id = GetRecord().ref_token_id_;
+    if (ref_token_id == mizcore::PARSE_RESULT_NO_ID) {
+        return std::nullopt;
+    }
+    return MappedToken(result_, ref_token_id);
+}
+
+IDENTIFIER_TYPE
+MappedToken::GetIdentifierType() const
+{
+    return GetTokenType() == TOKEN_TYPE::IDENTIFIER
+             ? static_cast<IDENTIFIER_TYPE>(GetRecord().sub_type_)
+             : IDENTIFIER_TYPE::UNKNOWN;
+}
+
+KEYWORD_TYPE
+MappedToken::GetKeywordType() const
+{
+    return GetTokenType() == TOKEN_TYPE::KEYWORD
+             ? static_cast<KEYWORD_TYPE>(GetRecord().sub_type_)
+             : KEYWORD_TYPE::UNKNOWN;
+}
+
+COMMENT_TYPE
+MappedToken::GetCommentType() const
+{
+    return GetTokenType() == TOKEN_TYPE::COMMENT
+             ? static_cast<COMMENT_TYPE>(GetRecord().sub_type_)
+             : COMMENT_TYPE::UNKNOWN;
+}
+
+SYMBOL_TYPE
+MappedToken::GetSymbolType() const
+{
+    if (GetTokenType() != TOKEN_TYPE::SYMBOL) {
+        return SYMBOL_TYPE::UNKNOWN;
+    }
+    return static_cast<SYMBOL_TYPE>(static_cast<char>(GetRecord().sub_type_));
+}
+
+const TokenRecord&
+MappedToken::GetRecord() const
+{
+    return result_->GetSections().token_records_[id_];
+}
+
+BLOCK_TYPE
+MappedComponent::GetBlockType() const
+{
+    return GetElementType() == ELEMENT_TYPE::BLOCK
+             ? static_cast<BLOCK_TYPE>(GetRecord().component_type_)
+             : BLOCK_TYPE::UNKNOWN;
+}
+
+STATEMENT_TYPE
+MappedComponent::GetStatementType() const
+{
+    return GetElementType() == ELEMENT_TYPE::STATEMENT
+             ? static_cast<STATEMENT_TYPE>(GetRecord().component_type_)
+             : STATEMENT_TYPE::UNKNOWN;
+}
+
+std::optional<MappedComponent>
+MappedComponent::GetParent() const
+{
+    uint32_t parent_id = GetRecord().parent_id_;
+    if (parent_id == mizcore::PARSE_RESULT_NO_ID) {
+        return std::nullopt;
+    }
+    return MappedComponent(result_, parent_id);
+}
+
+std::optional<MappedToken>
+MappedComponent::GetFirstToken() const
+{
+    return GetToken(GetRecord().first_token_id_);
+}
+
+std::optional<MappedToken>
+MappedComponent::GetLastToken() const
+{
+    return GetToken(GetRecord().last_token_id_);
+}
+
+std::optional<MappedToken>
+MappedComponent::GetSemicolonToken() const
+{
+    return GetToken(GetRecord().semicolon_token_id_);
+}
+
+std::optional<MappedToken>
+MappedComponent::GetRangeFirstToken() const
+{
+    return GetFirstToken();
+}
+
+std::optional<MappedToken>
+MappedComponent::GetRangeLastToken() const
+{
+    auto semicolon_token = GetSemicolonToken();
+    return semicolon_token ? semicolon_token : GetLastToken();
+}
+
+size_t
+MappedComponent::GetChildComponentNum() const
+{
+    size_t n = 0;
+    for (auto child = GetFirstChildComponent(); child;
+         child = child->GetNextSiblingComponent()) {
+        ++n;
+    }
+    return n;
+}
+
+MappedComponent
+MappedComponent::GetChildComponent(size_t i) const
+{
+    auto child = GetFirstChildComponent();
+    for (; i > 0; --i) {
+        child = child->GetNextSiblingComponent();
+    }
+    return *child;
+}
+
+std::optional<MappedComponent>
+MappedComponent::GetFirstChildComponent() const
+{
+    if (GetRecord().end_id_ == id_ + 1) {
+        return std::nullopt;
+    }
+    return MappedComponent(result_, id_ + 1);
+}
+
+std::optional<MappedComponent>
+MappedComponent::GetNextSiblingComponent() const
+{
+    const auto& record = GetRecord();
+    if (record.parent_id_ == mizcore::PARSE_RESULT_NO_ID) {
+        return std::nullopt;
+    }
+    const auto* records = result_->GetSections().component_records_;
+    if (record.end_id_ == records[record.parent_id_].end_id_) {
+        return std::nullopt;
+    }
+    return MappedComponent(result_, record.end_id_);
+}
+
+const ComponentRecord&
+MappedComponent::GetRecord() const
+{
+    return result_->GetSections().component_records_[id_];
+}
+
+std::optional<MappedToken>
+MappedComponent::GetToken(uint32_t token_id) const
+{
+    if (token_id == mizcore::PARSE_RESULT_NO_ID) {
+        return std::nullopt;
+    }
+    return MappedToken(result_, token_id);
+}
+
+ERROR_TYPE
+MappedError::GetErrorType() const
+{
+    return static_cast<ERROR_TYPE>(
+      result_->GetSections().error_records_[id_].error_type_);
+}
+
+std::optional<MappedToken>
+MappedError::GetASTToken() const
+{
+    uint32_t token_id = result_->GetSections().error_records_[id_].token_id_;
+    if (token_id == mizcore::PARSE_RESULT_NO_ID) {
+        return std::nullopt;
+    }
+    return MappedToken(result_, token_id);
+}
+
+MappedParseResult::~MappedParseResult()
+{
+    Close();
+}
+
+std::vector<std::string_view>
+MappedParseResult::GetFileNames() const
+{
+    std::vector<std::string_view> filenames;
+    for (uint32_t i = 0; i < sections_.header_->filename_num_; ++i) {
+        const auto& record = sections_.filename_records_[i];
+        filenames.push_back(
+          sections_.string_pool_.substr(record.offset_, record.length_));
+    }
+    return filenames;
+}
+
+bool
+MappedParseResult::Open(const std::string& path)
+{
+    Close();
+    if (!file_.Open(path)) {
+        return false;
+    }
+    if (!mizcore::LocateParseResultSections(file_.GetData(), sections_) ||
+        !mizcore::ValidateParseResultSections(sections_)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void
+MappedParseResult::Close()
+{
+    file_.Close();
+    sections_ = ParseResultSections();
+}
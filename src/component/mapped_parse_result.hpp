@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast_type.hpp"
+#include "error_def.hpp"
+#include "mapped_file.hpp"
+#include "parse_result_format.hpp"
+
+namespace mizcore {
+
+class MappedParseResult;
+
+// Views of the records of a MappedParseResult. They mirror the query methods
+// of ASTToken, ASTBlock/ASTStatement and ErrorObject, and are valid while the
+// file is mapped.
+class MappedToken
+{
+  public:
+    // ctor, dtor
+    MappedToken(const MappedParseResult* result, uint32_t id)
+      : result_(result)
+      , id_(id)
+    {}
+
+    // attributes
+    size_t GetId() const { return id_; }
+    int GetLineNumber() const { return GetRecord().line_number_; }
+    int GetColumnNumber() const { return GetRecord().column_number_; }
+    std::string_view GetText() const;
+    TOKEN_TYPE GetTokenType() const
+    {
+        return static_cast<TOKEN_TYPE>(GetRecord().token_type_);
+    }
+    std::optional<MappedToken> GetRefToken() const;
+    // The following return UNKNOWN for the tokens of the other types.
+    IDENTIFIER_TYPE GetIdentifierType() const;
+    KEYWORD_TYPE GetKeywordType() const;
+    COMMENT_TYPE GetCommentType() const;
+    SYMBOL_TYPE GetSymbolType() const;
+    uint8_t GetSymbolPriority() const { return GetRecord().symbol_priority_; }
+
+  private:
+    const TokenRecord& GetRecord() const;
+
+    const MappedParseResult* result_;
+    uint32_t id_;
+};
+
+class MappedComponent
+{
+  public:
+    // ctor, dtor
+    MappedComponent(const MappedParseResult* result, uint32_t id)
+      : result_(result)
+      , id_(id)
+    {}
+
+    // attributes
+    size_t GetId() const { return id_; }
+    ELEMENT_TYPE GetElementType() const
+    {
+        return static_cast<ELEMENT_TYPE>(GetRecord().element_type_);
+    }
+    // UNKNOWN for a statement.
+    BLOCK_TYPE GetBlockType() const;
+    // UNKNOWN for a block.
+    STATEMENT_TYPE GetStatementType() const;
+    bool IsError() const { return GetRecord().is_error_ != 0; }
+    std::optional<MappedComponent> GetParent() const;
+
+    std::optional<MappedToken> GetFirstToken() const;
+    std::optional<MappedToken> GetLastToken() const;
+    std::optional<MappedToken> GetSemicolonToken() const;
+    std::optional<MappedToken> GetRangeFirstToken() const;
+    std::optional<MappedToken> GetRangeLastToken() const;
+
+    // The children are laid out after their parent, and each child is
+    // followed by its next sibling after its own subtree. Use
+    // GetFirstChildComponent() and GetNextSiblingComponent() to visit the
+    // children in O(1) each; GetChildComponent(i) takes O(i).
+    size_t GetChildComponentNum() const;
+    MappedComponent GetChildComponent(size_t i) const;
+    std::optional<MappedComponent> GetFirstChildComponent() const;
+    std::optional<MappedComponent> GetNextSiblingComponent() const;
+
+  private:
+    const ComponentRecord& GetRecord() const;
+    std::optional<MappedToken> GetToken(uint32_t token_id) const;
+
+    const MappedParseResult* result_;
+    uint32_t id_;
+};
+
+class MappedError
+{
+  public:
+    // ctor, dtor
+    MappedError(const MappedParseResult* result, uint32_t id)
+      : result_(result)
+      , id_(id)
+    {}
+
+    // attributes
+    ERROR_TYPE GetErrorType() const;
+    std::optional<MappedToken> GetASTToken() const;
+
+  private:
+    const MappedParseResult* result_;
+    uint32_t id_;
+};
+
+// Read-only view of a file written by ParseResultWriter. The file is mapped
+// into memory and queried in place, without restoring the token table and the
+// AST.
+class MappedParseResult
+{
+  public:
+    // ctor, dtor
+    MappedParseResult() = default;
+    virtual ~MappedParseResult();
+    MappedParseResult(MappedParseResult const&) = delete;
+    MappedParseResult(MappedParseResult&&) = delete;
+    MappedParseResult& operator=(MappedParseResult const&) = delete;
+    MappedParseResult& operator=(MappedParseResult&&) = delete;
+
+    // attributes
+    bool IsOpen() const { return sections_.header_ != nullptr; }
+    std::string_view GetData() const { return file_.GetData(); }
+    const ParseResultSections& GetSections() const { return sections_; }
+    uint64_t GetKey() const { return sections_.header_->key_; }
+    std::vector<std::string_view> GetFileNames() const;
+
+    size_t GetTokenNum() const { return sections_.header_->token_num_; }
+    MappedToken GetToken(size_t i) const
+    {
+        return { this, static_cast<uint32_t>(i) };
+    }
+    size_t GetComponentNum() const
+    {
+        return sections_.header_->component_num_;
+    }
+    MappedComponent GetComponent(size_t i) const
+    {
+        return { this, static_cast<uint32_t>(i) };
+    }
+    MappedComponent GetASTRoot() const { return { this, 0 }; }
+    size_t GetErrorNum() const { return sections_.header_->error_num_; }
+    MappedError GetError(size_t i) const
+    {
+        return { this, static_cast<uint32_t>(i) };
+    }
+
+    // operations
+    // Returns false if the file cannot be mapped or is not valid (see
+    // ValidateParseResultSections).
+    bool Open(const std::string& path);
+    void Close();
+
+  private:
+    MappedFile file_;
+    ParseResultSections sections_;
+};
+
+} // namespace mizcore
@@ -0,0 +1,235 @@
+#include <cstring>
+#include <vector>
+
+#include "ast_type.hpp"
+#include "error_def.hpp"
+#include "parse_result_format.hpp"
+
+using mizcore::BLOCK_TYPE;
+using mizcore::COMMENT_TYPE;
+using mizcore::ComponentRecord;
+using mizcore::ELEMENT_TYPE;
+using mizcore::ERROR_TYPE;
+using mizcore::IDENTIFIER_TYPE;
+using mizcore::KEYWORD_TYPE;
+using mizcore::STATEMENT_TYPE;
+using mizcore::TOKEN_TYPE;
+using mizcore::ErrorRecord;
+using mizcore::ParseResultHeader;
+using mizcore::ParseResultSections;
+using mizcore::StringRecord;
+using mizcore::TokenRecord;
+
+namespace {
+
+template<class T>
+bool
+IsInEnumRange(uint32_t value, T last)
+{
+    return value <= static_cast<uint32_t>(last);
+}
+
+bool
+IsInStringPool(const StringRecord& record, std::string_view string_pool)
+{
+    return uint64_t(record.offset_) + record.length_ <= string_pool.size();
+}
+
+bool
+IsValidTokenRecord(const TokenRecord& record,
+                   const ParseResultSections& sections)
+{
+    if (!IsInStringPool(record.text_, sections.string_pool_)) {
+        return false;
+    }
+    switch (static_cast<TOKEN_TYPE>(record.token_type_)) {
+        case TOKEN_TYPE::UNKNOWN:
+        case TOKEN_TYPE::NUMERAL:
+        case TOKEN_TYPE::SYMBOL:
+            break;
+        case TOKEN_TYPE::IDENTIFIER:
+            if (!IsInEnumRange(record.sub_type_, IDENTIFIER_TYPE::RESERVED)) {
+                return false;
+            }
+            break;
+        case TOKEN_TYPE::KEYWORD:
+            if (!IsInEnumRange(record.sub_type_, KEYWORD_TYPE::WRT)) {
+                return false;
+            }
+            break;
+        case TOKEN_TYPE::COMMENT:
+            if (!IsInEnumRange(record.sub_type_, COMMENT_TYPE::TRIPLE)) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    uint32_t ref_token_id = record.ref_token_id_;
+    if (ref_token_id == mizcore::PARSE_RESULT_NO_ID) {
+        return true;
+    }
+    auto identifier_type = static_cast<uint8_t>(TOKEN_TYPE::IDENTIFIER);
+    return record.token_type_ == identifier_type &&
+           ref_token_id < sections.header_->token_num_ &&
+           sections.token_records_[ref_token_id].token_type_ ==
+             identifier_type;
+}
+
+bool
+IsValidTokenId(uint32_t id, const ParseResultSections& sections)
+{
+    return id == mizcore::PARSE_RESULT_NO_ID ||
+           id < sections.header_->token_num_;
+}
+
+bool
+IsValidComponentRecord(const ComponentRecord& record,
+                       const ParseResultSections& sections)
+{
+    if (!IsValidTokenId(record.first_token_id_, sections) ||
+        !IsValidTokenId(record.last_token_id_, sections) ||
+        !IsValidTokenId(record.semicolon_token_id_, sections)) {
+        return false;
+    }
+    switch (static_cast<ELEMENT_TYPE>(record.element_type_)) {
+        case ELEMENT_TYPE::BLOCK:
+            return IsInEnumRange(record.component_type_, BLOCK_TYPE::PROOF);
+        case ELEMENT_TYPE::STATEMENT:
+            return IsInEnumRange(record.component_type_,
+                                 STATEMENT_TYPE::VOCABULARIES);
+        default:
+            return false;
+    }
+}
+
+bool
+IsValidErrorRecord(const ErrorRecord& record,
+                   const ParseResultSections& sections)
+{
+    // Every error has a token.
+    if (record.token_id_ >= sections.header_->token_num_) {
+        return false;
+    }
+    return record.error_type_ >= static_cast<uint32_t>(ERROR_TYPE::UNKNOWN) &&
+           IsInEnumRange(record.error_type_, ERROR_TYPE::TOKEN_IS_UNKNOWN);
+}
+
+// The subtree of each component must be the components [id, end_id_) which
+// follow it, and its parent must be the innermost block whose subtree
+// contains it.
+bool
+IsValidComponentTree(const ParseResultSections& sections)
+{
+    const auto* records = sections.component_records_;
+    uint32_t component_num = sections.header_->component_num_;
+    auto block_type = static_cast<uint8_t>(ELEMENT_TYPE::BLOCK);
+    if (records[0].parent_id_ != mizcore::PARSE_RESULT_NO_ID ||
+        records[0].end_id_ != component_num ||
+        records[0].element_type_ != block_type) {
+        return false;
+    }
+
+    std::vector<uint32_t> ancestors = { 0 };
+    for (uint32_t i = 1; i < component_num; ++i) {
+        while (!ancestors.empty() && records[ancestors.back()].end_id_ == i) {
+            ancestors.pop_back();
+        }
+        if (ancestors.empty()) {
+            return false;
+        }
+        uint32_t parent_id = ancestors.back();
+        const auto& record = records[i];
+        if (record.parent_id_ != parent_id ||
+            records[parent_id].element_type_ != block_type ||
+            record.end_id_ <= i ||
+            record.end_id_ > records[parent_id].end_id_) {
+            return false;
+        }
+        ancestors.push_back(i);
+    }
+    return true;
+}
+
+} // namespace
+
+bool
+mizcore::LocateParseResultSections(std::string_view data,
+                                   ParseResultSections& sections)
+{
+    sections = ParseResultSections();
+    const auto* header =
+      reinterpret_cast<const ParseResultHeader*>(data.data());
+    if (data.size() < sizeof(*header) ||
+        reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0 ||
+        std::memcmp(
+          header->magic_, PARSE_RESULT_MAGIC, sizeof(header->magic_)) != 0 ||
+        header->format_version_ != PARSE_RESULT_FORMAT_VERSION ||
+        header->byte_order_mark_ != PARSE_RESULT_BYTE_ORDER_MARK) {
+        return false;
+    }
+
+    uint64_t filename_offset = sizeof(*header);
+    uint64_t token_offset =
+      filename_offset + uint64_t(header->filename_num_) * sizeof(StringRecord);
+    uint64_t component_offset =
+      token_offset + uint64_t(header->token_num_) * sizeof(TokenRecord);
+    uint64_t error_offset =
+      component_offset +
+      uint64_t(header->component_num_) * sizeof(ComponentRecord);
+    uint64_t string_pool_offset =
+      error_offset + uint64_t(header->error_num_) * sizeof(ErrorRecord);
+    if (string_pool_offset > data.size() ||
+        header->string_pool_size_ != data.size() - string_pool_offset) {
+        return false;
+    }
+
+    const char* base = data.data();
+    sections.header_ = header;
+    sections.filename_records_ =
+      reinterpret_cast<const StringRecord*>(base + filename_offset);
+    sections.token_records_ =
+      reinterpret_cast<const TokenRecord*>(base + token_offset);
+    sections.component_records_ =
+      reinterpret_cast<const ComponentRecord*>(base + component_offset);
+    sections.error_records_ =
+      reinterpret_cast<const ErrorRecord*>(base + error_offset);
+    sections.string_pool_ = data.substr(string_pool_offset);
+    return true;
+}
+
+bool
+mizcore::ValidateParseResultSections(const ParseResultSections& sections)
+{
+    const auto* header = sections.header_;
+    if (header == nullptr || header->component_num_ == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header->filename_num_; ++i) {
+        if (!IsInStringPool(sections.filename_records_[i],
+                            sections.string_pool_)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->token_num_; ++i) {
+        if (!IsValidTokenRecord(sections.token_records_[i], sections)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->component_num_; ++i) {
+        if (!IsValidComponentRecord(sections.component_records_[i],
+                                    sections)) {
+            return false;
+        }
+    }
+    if (!IsValidComponentTree(sections)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header->error_num_; ++i) {
+        if (!IsValidErrorRecord(sections.error_records_[i], sections)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace mizcore {
+
+// Binary format of the token table, the AST and the error table of an
+// article. The file consists of fixed size records followed by a string pool:
+//
+//   ParseResultHeader
+//   StringRecord[filename_num]     vocabulary file names of the article
+//   TokenRecord[token_num]         in the order of the token ids
+//   ComponentRecord[component_num] blocks and statements in pre-order,
+//                                  the root block first
+//   ErrorRecord[error_num]
+//   char[string_pool_size]
+//
+// The records are written in the byte order of the host, and the readers
+// reject a file of the other byte order. PARSE_RESULT_FORMAT_VERSION must be
+// increased whenever the records or the output of the lexer and the parser
+// change.
+constexpr char PARSE_RESULT_MAGIC[4] = { 'M', 'Z', 'P', 'R' };
+constexpr uint32_t PARSE_RESULT_FORMAT_VERSION = 1;
+constexpr uint32_t PARSE_RESULT_BYTE_ORDER_MARK = 0x01020304;
+constexpr uint32_t PARSE_RESULT_NO_ID = UINT32_MAX;
+
+struct ParseResultHeader
+{
+    char magic_[4];
+    uint32_t format_version_;
+    uint32_t byte_order_mark_;
+    uint32_t filename_num_;
+    uint64_t key_;
+    uint32_t token_num_;
+    uint32_t component_num_;
+    uint32_t error_num_;
+    uint32_t reserved_;
+    uint64_t string_pool_size_;
+};
+
+// A range of the string pool.
+struct StringRecord
+{
+    uint32_t offset_;
+    uint32_t length_;
+};
+
+struct TokenRecord
+{
+    uint32_t line_number_;
+    uint32_t column_number_;
+    // Empty for the keywords, whose text is determined by the keyword type.
+    StringRecord text_;
+    // Id of the referred token of an identifier, or PARSE_RESULT_NO_ID.
+    uint32_t ref_token_id_;
+    uint8_t token_type_;
+    // KEYWORD_TYPE, IDENTIFIER_TYPE, COMMENT_TYPE or SYMBOL_TYPE according to
+    // token_type_.
+    uint8_t sub_type_;
+    uint8_t symbol_priority_;
+    uint8_t reserved_;
+};
+
+struct ComponentRecord
+{
+    // Index of the parent block, or PARSE_RESULT_NO_ID for the root.
+    uint32_t parent_id_;
+    // One past the index of the last component of the subtree.
+    uint32_t end_id_;
+    // Range tokens of a statement, or first/last/semicolon tokens of a block.
+    uint32_t first_token_id_;
+    uint32_t last_token_id_;
+    uint32_t semicolon_token_id_;
+    uint8_t element_type_;
+    uint8_t is_error_;
+    // BLOCK_TYPE or STATEMENT_TYPE according to element_type_.
+    uint16_t component_type_;
+};
+
+struct ErrorRecord
+{
+    // ERROR_TYPE other than SUCCESS.
+    uint32_t error_type_;
+    // Never PARSE_RESULT_NO_ID.
+    uint32_t token_id_;
+};
+
+// Pointers to the sections of the data of a parse result.
+struct ParseResultSections
+{
+    const ParseResultHeader* header_ = nullptr;
+    const StringRecord* filename_records_ = nullptr;
+    const TokenRecord* token_records_ = nullptr;
+    const ComponentRecord* component_records_ = nullptr;
+    const ErrorRecord* error_records_ = nullptr;
+    std::string_view string_pool_;
+};
+
+// Returns false if data is not of PARSE_RESULT_FORMAT_VERSION and the byte
+// order of the host, or the sizes of the sections are inconsistent. The
+// records themselves are not validated.
+bool
+LocateParseResultSections(std::string_view data,
+                          ParseResultSections& sections);
+
+// Returns false if a record has an id, a string or an enum value out of range,
+// or the components do not form a tree in pre-order.
+bool
+ValidateParseResultSections(const ParseResultSections& sections);
+
+static_assert(sizeof(ParseResultHeader) == 48);
+static_assert(sizeof(StringRecord) == 8);
+static_assert(sizeof(TokenRecord) == 24);
+static_assert(sizeof(ComponentRecord) == 24);
+static_assert(sizeof(ErrorRecord) == 8);
+
+} // namespace mizcore
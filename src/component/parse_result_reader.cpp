@@ -0,0 +1,184 @@
+
+#include "ast_block.hpp"
+#include "ast_statement.hpp"
+#include "ast_token.hpp"
+#include "error_table.hpp"
+#include "parse_result_reader.hpp"
+#include "token_table.hpp"
+
+using mizcore::ASTBlock;
+using mizcore::ASTComponent;
+using mizcore::ASTStatement;
+using mizcore::ASTToken;
+using mizcore::BLOCK_TYPE;
+using mizcore::COMMENT_TYPE;
+using mizcore::CommentToken;
+using mizcore::ComponentRecord;
+using mizcore::ELEMENT_TYPE;
+using mizcore::ErrorTable;
+using mizcore::IDENTIFIER_TYPE;
+using mizcore::IdentifierToken;
+using mizcore::KEYWORD_TYPE;
+using mizcore::KeywordToken;
+using mizcore::NumeralToken;
+using mizcore::ParseResultReader;
+using mizcore::ParseResultSections;
+using mizcore::STATEMENT_TYPE;
+using mizcore::Symbol;
+using mizcore::SYMBOL_TYPE;
+using mizcore::SymbolToken;
+using mizcore::TOKEN_TYPE;
+using mizcore::TokenRecord;
+using mizcore::TokenTable;
+using mizcore::UnknownToken;
+
+ParseResultReader::ParseResultReader(std::string_view data)
+{
+    if (!mizcore::LocateParseResultSections(data, sections_) ||
+        !mizcore::ValidateParseResultSections(sections_)) {
+        sections_ = ParseResultSections();
+    }
+}
+
+std::vector<std::string_view>
+ParseResultReader::GetFileNames() const
+{
+    std::vector<std::string_view> filenames;
+    for (uint32_t i = 0; i < sections_.header_->filename_num_; ++i) {
+        filenames.push_back(GetString(sections_.filename_records_[i]));
+    }
+    return filenames;
+}
+
+bool
+ParseResultReader::Restore(const SymbolResolver& resolver)
+{
+    token_table_.reset();
+    ast_root_.reset();
+    error_table_.reset();
+    if (!IsValid()) {
+        return false;
+    }
+    if (!RestoreTokens(resolver)) {
+        token_table_.reset();
+        return false;
+    }
+    RestoreComponents();
+    RestoreErrors();
+    return true;
+}
+
+bool
+ParseResultReader::RestoreTokens(const SymbolResolver& resolver)
+{
+    token_table_ = std::make_shared<TokenTable>();
+    uint32_t token_num = sections_.header_->token_num_;
+    for (uint32_t i = 0; i < token_num; ++i) {
+        const TokenRecord& record = sections_.token_records_[i];
+        std::string_view text = GetString(record.text_);
+        ASTToken* token = nullptr;
+        size_t line = record.line_number_;
+        size_t column = record.column_number_;
+        switch (static_cast<TOKEN_TYPE>(record.token_type_)) {
+            case TOKEN_TYPE::NUMERAL:
+                token = new NumeralToken(line, column, text);
+                break;
+            case TOKEN_TYPE::SYMBOL: {
+                auto symbol_type =
+                  static_cast<SYMBOL_TYPE>(static_cast<char>(record.sub_type_));
+                Symbol* symbol =
+                  resolver(text, symbol_type, record.symbol_priority_);
+                if (symbol == nullptr) {
+                    return false;
+                }
+                token = new SymbolToken(line, column, symbol);
+                break;
+            }
+            case TOKEN_TYPE::IDENTIFIER:
+                token = new IdentifierToken(
+                  line,
+                  column,
+                  text,
+                  static_cast<IDENTIFIER_TYPE>(record.sub_type_));
+                break;
+            case TOKEN_TYPE::KEYWORD:
+                token = new KeywordToken(
+                  line, column, static_cast<KEYWORD_TYPE>(record.sub_type_));
+                break;
+            case TOKEN_TYPE::COMMENT:
+                token = new CommentToken(
+                  line,
+                  column,
+                  text,
+                  static_cast<COMMENT_TYPE>(record.sub_type_));
+                break;
+            default:
+                token = new UnknownToken(line, column, text);
+                break;
+        }
+        token_table_->AddToken(token);
+    }
+
+    // The referred tokens may follow the referring ones.
+    for (uint32_t i = 0; i < token_num; ++i) {
+        uint32_t ref_token_id = sections_.token_records_[i].ref_token_id_;
+        if (ref_token_id != mizcore::PARSE_RESULT_NO_ID) {
+            static_cast<IdentifierToken*>(token_table_->GetToken(i))
+              ->SetRefToken(static_cast<IdentifierToken*>(
+                token_table_->GetToken(ref_token_id)));
+        }
+    }
+    return true;
+}
+
+void
+ParseResultReader::RestoreComponents()
+{
+    auto get_token = [this](uint32_t id) -> ASTToken* {
+        return id == mizcore::PARSE_RESULT_NO_ID ? nullptr
+                                                 : token_table_->GetToken(id);
+    };
+
+    uint32_t component_num = sections_.header_->component_num_;
+    std::vector<ASTBlock*> blocks(component_num, nullptr);
+    for (uint32_t i = 0; i < component_num; ++i) {
+        const ComponentRecord& record = sections_.component_records_[i];
+        std::unique_ptr<ASTComponent> component;
+        if (static_cast<ELEMENT_TYPE>(record.element_type_) ==
+            ELEMENT_TYPE::BLOCK) {
+            auto block = std::make_unique<ASTBlock>(
+              static_cast<BLOCK_TYPE>(record.component_type_));
+            block->SetFirstToken(get_token(record.first_token_id_));
+            block->SetLastToken(get_token(record.last_token_id_));
+            block->SetSemicolonToken(get_token(record.semicolon_token_id_));
+            blocks[i] = block.get();
+            component = std::move(block);
+        } else {
+            auto statement = std::make_unique<ASTStatement>(
+              static_cast<STATEMENT_TYPE>(record.component_type_));
+            statement->SetRangeFirstToken(get_token(record.first_token_id_));
+            statement->SetRangeLastToken(get_token(record.last_token_id_));
+            component = std::move(statement);
+        }
+        component->SetError(record.is_error_ != 0);
+
+        if (i == 0) {
+            ast_root_.reset(blocks[0]);
+            component.release();
+        } else {
+            blocks[record.parent_id_]->AddChildComponent(std::move(component));
+        }
+    }
+}
+
+void
+ParseResultReader::RestoreErrors()
+{
+    error_table_ = std::make_shared<ErrorTable>();
+    for (uint32_t i = 0; i < sections_.header_->error_num_; ++i) {
+        const auto& record = sections_.error_records_[i];
+        error_table_->AddError(new mizcore::ErrorObject(
+          static_cast<mizcore::ERROR_TYPE>(record.error_type_),
+          token_table_->GetToken(record.token_id_)));
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "ast_type.hpp"
+#include "parse_result_format.hpp"
+
+namespace mizcore {
+
+class ASTBlock;
+class ErrorTable;
+class Symbol;
+class TokenTable;
+
+// Restores the token table, the AST and the error table from the data written
+// by ParseResultWriter. Malformed data is rejected rather than trusted, since
+// it may come from a truncated or stale cache file.
+class ParseResultReader
+{
+  public:
+    // Returns the symbol of the given text, type and priority, or nullptr if
+    // the vocabulary has no such symbol.
+    using SymbolResolver = std::function<
+      Symbol*(std::string_view text, SYMBOL_TYPE type, uint8_t priority)>;
+
+    // ctor, dtor
+    // data must outlive the reader.
+    explicit ParseResultReader(std::string_view data);
+    virtual ~ParseResultReader() = default;
+    ParseResultReader(ParseResultReader const&) = delete;
+    ParseResultReader(ParseResultReader&&) = delete;
+    ParseResultReader& operator=(ParseResultReader const&) = delete;
+    ParseResultReader& operator=(ParseResultReader&&) = delete;
+
+    // attributes
+    // Whether the data is of this format version and its records are
+    // consistent (see ValidateParseResultSections).
+    bool IsValid() const { return sections_.header_ != nullptr; }
+    uint64_t GetKey() const { return sections_.header_->key_; }
+    std::vector<std::string_view> GetFileNames() const;
+
+    std::shared_ptr<TokenTable> GetTokenTable() const { return token_table_; }
+    std::shared_ptr<ASTBlock> GetASTRoot() const { return ast_root_; }
+    std::shared_ptr<ErrorTable> GetErrorTable() const { return error_table_; }
+
+    // operations
+    // Returns false if the data is invalid or a symbol cannot be resolved.
+    bool Restore(const SymbolResolver& resolver);
+
+  private:
+    // implementation
+    std::string_view GetString(const StringRecord& record) const
+    {
+        return sections_.string_pool_.substr(record.offset_, record.length_);
+    }
+    bool RestoreTokens(const SymbolResolver& resolver);
+    void RestoreComponents();
+    void RestoreErrors();
+
+    ParseResultSections sections_;
+
+    std::shared_ptr<TokenTable> token_table_;
+    std::shared_ptr<ASTBlock> ast_root_;
+    std::shared_ptr<ErrorTable> error_table_;
+};
+
+} // namespace mizcore
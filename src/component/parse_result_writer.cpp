@@ -0,0 +1,204 @@
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "ast_block.hpp"
+#include "ast_statement.hpp"
+#include "ast_token.hpp"
+#include "error_table.hpp"
+#include "parse_result_format.hpp"
+#include "parse_result_writer.hpp"
+#include "symbol.hpp"
+#include "token_table.hpp"
+
+using mizcore::ASTBlock;
+using mizcore::ASTComponent;
+using mizcore::ASTStatement;
+using mizcore::ASTToken;
+using mizcore::ComponentRecord;
+using mizcore::ParseResultWriter;
+using mizcore::StringRecord;
+using mizcore::TokenRecord;
+
+namespace {
+
+class StringPool
+{
+  public:
+    StringRecord Add(std::string_view text)
+    {
+        StringRecord record{ static_cast<uint32_t>(pool_.size()),
+                             static_cast<uint32_t>(text.size()) };
+        pool_ += text;
+        return record;
+    }
+    const std::string& GetPool() const { return pool_; }
+
+  private:
+    std::string pool_;
+};
+
+uint32_t
+GetTokenId(const ASTToken* token)
+{
+    return token == nullptr ? mizcore::PARSE_RESULT_NO_ID
+                            : static_cast<uint32_t>(token->GetId());
+}
+
+TokenRecord
+MakeTokenRecord(const ASTToken* token, StringPool& string_pool)
+{
+    TokenRecord record = {};
+    record.line_number_ = token->GetLineNumber();
+    record.column_number_ = token->GetColumnNumber();
+    record.ref_token_id_ = GetTokenId(token->GetRefToken());
+    record.token_type_ = static_cast<uint8_t>(token->GetTokenType());
+    record.sub_type_ = token->GetSubType();
+    if (token->GetTokenType() == mizcore::TOKEN_TYPE::KEYWORD) {
+        return record;
+    }
+    if (token->GetTokenType() == mizcore::TOKEN_TYPE::SYMBOL) {
+        record.symbol_priority_ =
+          static_cast<const mizcore::SymbolToken*>(token)
+            ->GetSymbol()
+            ->GetPriority();
+    }
+    record.text_ = string_pool.Add(token->GetText());
+    return record;
+}
+
+void
+AddComponentRecords(const ASTComponent* component,
+                    uint32_t parent_id,
+                    std::vector<ComponentRecord>& records)
+{
+    size_t id = records.size();
+    ComponentRecord record = {};
+    record.parent_id_ = parent_id;
+    record.element_type_ = static_cast<uint8_t>(component->GetElementType());
+    record.is_error_ = component->IsError() ? 1 : 0;
+    record.semicolon_token_id_ = mizcore::PARSE_RESULT_NO_ID;
+    if (component->GetElementType() == mizcore::ELEMENT_TYPE::BLOCK) {
+        const auto* block = static_cast<const ASTBlock*>(component);
+        record.component_type_ = static_cast<uint16_t>(block->GetBlockType());
+        record.first_token_id_ = GetTokenId(block->GetFirstToken());
+        record.last_token_id_ = GetTokenId(block->GetLastToken());
+        record.semicolon_token_id_ = GetTokenId(block->GetSemicolonToken());
+        records.push_back(record);
+        for (size_t i = 0; i < block->GetChildComponentNum(); ++i) {
+            AddComponentRecords(block->GetChildComponent(i),
+                                static_cast<uint32_t>(id),
+                                records);
+        }
+    } else {
+        const auto* statement = static_cast<const ASTStatement*>(component);
+        record.component_type_ =
+          static_cast<uint16_t>(statement->GetStatementType());
+        record.first_token_id_ = GetTokenId(statement->GetRangeFirstToken());
+        record.last_token_id_ = GetTokenId(statement->GetRangeLastToken());
+        records.push_back(record);
+    }
+    records[id].end_id_ = static_cast<uint32_t>(records.size());
+}
+
+template<class T>
+void
+AppendRecords(const std::vector<T>& records, std::string& buffer)
+{
+    buffer.append(reinterpret_cast<const char*>(records.data()),
+                  records.size() * sizeof(T));
+}
+
+} // namespace
+
+void
+ParseResultWriter::Write(std::string& buffer) const
+{
+    assert(token_table_->GetFirstTokenId() == 0);
+    assert(ast_root_->GetReleasedChildComponentNum() == 0);
+
+    StringPool string_pool;
+    std::vector<StringRecord> filename_records;
+    filename_records.reserve(filenames_.size());
+    for (const auto& filename : filenames_) {
+        filename_records.push_back(string_pool.Add(filename));
+    }
+
+    size_t token_num = token_table_->GetTokenNum();
+    std::vector<TokenRecord> token_records;
+    token_records.reserve(token_num);
+    for (size_t i = 0; i < token_num; ++i) {
+        token_records.push_back(
+          MakeTokenRecord(token_table_->GetToken(i), string_pool));
+    }
+
+    std::vector<ComponentRecord> component_records;
+    AddComponentRecords(
+      ast_root_.get(), mizcore::PARSE_RESULT_NO_ID, component_records);
+
+    std::vector<mizcore::ErrorRecord> error_records;
+    error_records.reserve(error_table_->GetErrorNum());
+    for (size_t i = 0; i < error_table_->GetErrorNum(); ++i) {
+        const auto* error = error_table_->GetError(i);
+        error_records.push_back(
+          { static_cast<uint32_t>(error->GetErrorType()),
+            GetTokenId(error->GetASTToken()) });
+    }
+
+    mizcore::ParseResultHeader header = {};
+    std::memcpy(header.magic_,
+                mizcore::PARSE_RESULT_MAGIC,
+                sizeof(header.magic_));
+    header.format_version_ = mizcore::PARSE_RESULT_FORMAT_VERSION;
+    header.byte_order_mark_ = mizcore::PARSE_RESULT_BYTE_ORDER_MARK;
+    header.filename_num_ = static_cast<uint32_t>(filename_records.size());
+    header.key_ = key_;
+    header.token_num_ = static_cast<uint32_t>(token_records.size());
+    header.component_num_ = static_cast<uint32_t>(component_records.size());
+    header.error_num_ = static_cast<uint32_t>(error_records.size());
+    header.string_pool_size_ = string_pool.GetPool().size();
+
+    buffer.clear();
+    buffer.reserve(sizeof(header) +
+                   filename_records.size() * sizeof(StringRecord) +
+                   token_records.size() * sizeof(TokenRecord) +
+                   component_records.size() * sizeof(ComponentRecord) +
+                   error_records.size() * sizeof(mizcore::ErrorRecord) +
+                   string_pool.GetPool().size());
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    AppendRecords(filename_records, buffer);
+    AppendRecords(token_records, buffer);
+    AppendRecords(component_records, buffer);
+    AppendRecords(error_records, buffer);
+    buffer += string_pool.GetPool();
+}
+
+bool
+ParseResultWriter::WriteFile(const std::string& path) const
+{
+    std::string buffer;
+    Write(buffer);
+
+    // The file is renamed after it is completely written, so that concurrent
+    // readers and writers of the same path never see a partial file.
+    std::random_device random_device;
+    std::string temporary_path =
+      path + ".tmp" + std::to_string(random_device());
+    {
+        std::ofstream ofs(temporary_path, std::ios::binary);
+        if (!ofs.write(buffer.data(), buffer.size())) {
+            ofs.close();
+            std::filesystem::remove(temporary_path);
+            return false;
+        }
+    }
+    std::error_code error_code;
+    std::filesystem::rename(temporary_path, path, error_code);
+    if (error_code) {
+        std::filesystem::remove(temporary_path, error_code);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mizcore {
+
+class ASTBlock;
+class ErrorTable;
+class TokenTable;
+
+// Serializes the results of an article into the format of
+// parse_result_format.hpp. The token table must hold all the tokens, that is,
+// the results of the streaming mode cannot be written.
+class ParseResultWriter
+{
+  public:
+    // ctor, dtor
+    ParseResultWriter(std::shared_ptr<TokenTable> token_table,
+                      std::shared_ptr<ASTBlock> ast_root,
+                      std::shared_ptr<ErrorTable> error_table)
+      : token_table_(std::move(token_table))
+      , ast_root_(std::move(ast_root))
+      , error_table_(std::move(error_table))
+    {}
+    virtual ~ParseResultWriter() = default;
+    ParseResultWriter(ParseResultWriter const&) = delete;
+    ParseResultWriter(ParseResultWriter&&) = delete;
+    ParseResultWriter& operator=(ParseResultWriter const&) = delete;
+    ParseResultWriter& operator=(ParseResultWriter&&) = delete;
+
+    // attributes
+    void SetKey(uint64_t key) { key_ = key; }
+    void SetFileNames(std::vector<std::string> filenames)
+    {
+        filenames_ = std::move(filenames);
+    }
+
+    // operations
+    void Write(std::string& buffer) const;
+    bool WriteFile(const std::string& path) const;
+
+  private:
+    std::shared_ptr<TokenTable> token_table_;
+    std::shared_ptr<ASTBlock> ast_root_;
+    std::shared_ptr<ErrorTable> error_table_;
+    uint64_t key_ = 0;
+    std::vector<std::string> filenames_;
+};
+
+} // namespace mizcore
@@ -1,5 +1,7 @@
+#include "json_writer.hpp"
 #include "pattern_element.hpp"
 
+using mizcore::JsonWriter;
 using mizcore::PatternElement;
 using json = nlohmann::json;
 
@@ -68,6 +70,32 @@ PatternElement::ToJson(nlohmann::json& json) const
     }
 }
 
+void
+PatternElement::WriteJson(JsonWriter& writer) const
+{
+    // The keys are in the order of nlohmann::json.
+    writer.BeginObject();
+    writer.Key("arities");
+    writer.BeginArray();
+    writer.UInt(arities_[0]);
+    if (type_ == PATTERN_TYPE::FUNCTOR || type_ == PATTERN_TYPE::PREDICATE) {
+        writer.UInt(arities_[1]);
+    }
+    writer.EndArray();
+    writer.Key("filename");
+    writer.String(filename_);
+    writer.Key("symbols");
+    writer.BeginArray();
+    writer.String(symbol_tokens_[0]->GetText());
+    if (type_ == PATTERN_TYPE::BRACKET_FUNCTOR) {
+        writer.String(symbol_tokens_[1]->GetText());
+    }
+    writer.EndArray();
+    writer.Key("type");
+    writer.String(QueryPatternTypeText(type_));
+    writer.EndObject();
+}
+
 bool
 PatternElement::operator<(const PatternElement& other) const
 {
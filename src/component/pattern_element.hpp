@@ -7,6 +7,7 @@
 
 namespace mizcore {
 
+class JsonWriter;
 class SymbolToken;
 
 class PatternElement
@@ -45,6 +46,8 @@ class PatternElement
 
     // operations
     void ToJson(nlohmann::json& json) const;
+    // Writes the same JSON as ToJson().
+    void WriteJson(JsonWriter& writer) const;
     bool operator<(const PatternElement& other) const;
 
   private:
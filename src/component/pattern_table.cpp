@@ -1,7 +1,9 @@
+#include "json_writer.hpp"
 #include "pattern_table.hpp"
 #include "pattern_element.hpp"
 #include <string_view>
 
+using mizcore::JsonWriter;
 using mizcore::PatternTable;
 using json = nlohmann::json;
 
@@ -29,3 +31,24 @@ PatternTable::ToJson(nlohmann::json& json) const
         }
     }
 }
+
+void
+PatternTable::WriteJson(JsonWriter& writer) const
+{
+    // An empty table is null as ToJson() leaves the json untouched.
+    bool has_patterns = false;
+    for (const auto& [filename, patterns] : file2patterns_) {
+        for (const auto& pattern : patterns) {
+            if (!has_patterns) {
+                writer.BeginArray();
+                has_patterns = true;
+            }
+            pattern->WriteJson(writer);
+        }
+    }
+    if (has_patterns) {
+        writer.EndArray();
+    } else {
+        writer.Null();
+    }
+}
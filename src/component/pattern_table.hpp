@@ -11,6 +11,7 @@
 
 namespace mizcore {
 
+class JsonWriter;
 class PatternElement;
 
 class PatternTable
@@ -30,6 +31,8 @@ class PatternTable
 
     // operations
     void ToJson(nlohmann::json& json) const;
+    // Writes the same JSON as ToJson() of a null json.
+    void WriteJson(JsonWriter& writer) const;
 
   private:
     // implementation
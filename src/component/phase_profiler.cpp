@@ -0,0 +1,137 @@
+#include <algorithm>
+
+#include "allocation_counter.hpp"
+#include "json_writer.hpp"
+#include "phase_profiler.hpp"
+
+using mizcore::AllocationCounter;
+using mizcore::JsonWriter;
+using mizcore::PhaseProfiler;
+using mizcore::PhaseRecord;
+using std::chrono::steady_clock;
+
+PhaseProfiler::Scope::Scope(PhaseProfiler* profiler, const char* name)
+  : profiler_(profiler)
+{
+    if (profiler_ == nullptr) {
+        return;
+    }
+    record_.name_ = name;
+    // The counters at the start are kept in the record until the end.
+    record_.allocation_num_ = AllocationCounter::GetAllocationNum();
+    record_.allocated_bytes_ = AllocationCounter::GetAllocatedBytes();
+    start_time_ = steady_clock::now();
+}
+
+PhaseProfiler::Scope::~Scope()
+{
+    End();
+}
+
+void
+PhaseProfiler::Scope::End()
+{
+    if (profiler_ == nullptr) {
+        return;
+    }
+    auto end_time = steady_clock::now();
+    record_.allocation_num_ =
+      AllocationCounter::GetAllocationNum() - record_.allocation_num_;
+    record_.allocated_bytes_ =
+      AllocationCounter::GetAllocatedBytes() - record_.allocated_bytes_;
+    profiler_->AddPhaseRecord(std::move(record_), start_time_, end_time);
+    profiler_ = nullptr;
+}
+
+std::vector<PhaseRecord>
+PhaseProfiler::GetPhaseRecords() const
+{
+    std::vector<PhaseRecord> phase_records;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        phase_records = phase_records_;
+    }
+    // The records are added at the end of the phases, so that an outer phase
+    // comes after its inner phases.
+    std::stable_sort(phase_records.begin(),
+                     phase_records.end(),
+                     [](const PhaseRecord& lhs, const PhaseRecord& rhs) {
+                         return lhs.start_ns_ < rhs.start_ns_;
+                     });
+    return phase_records;
+}
+
+void
+PhaseProfiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    origin_time_ = steady_clock::now();
+    phase_records_.clear();
+    thread_ids_.clear();
+}
+
+void
+PhaseProfiler::WriteChromeTrace(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    writer.Key("displayTimeUnit");
+    writer.String("ms");
+    writer.Key("traceEvents");
+    writer.BeginArray();
+    for (const auto& record : GetPhaseRecords()) {
+        // Complete events, whose times are in microseconds.
+        writer.BeginObject();
+        writer.Key("args");
+        writer.BeginObject();
+        writer.Key("allocated_bytes");
+        writer.UInt(record.allocated_bytes_);
+        writer.Key("allocation_num");
+        writer.UInt(record.allocation_num_);
+        writer.Key("block_num");
+        writer.UInt(record.block_num_);
+        writer.Key("statement_num");
+        writer.UInt(record.statement_num_);
+        writer.Key("token_num");
+        writer.UInt(record.token_num_);
+        writer.EndObject();
+        writer.Key("dur");
+        writer.UInt(record.duration_ns_ / 1000);
+        writer.Key("name");
+        writer.String(record.name_);
+        writer.Key("ph");
+        writer.String("X");
+        writer.Key("pid");
+        writer.UInt(0);
+        writer.Key("tid");
+        writer.UInt(record.thread_index_);
+        writer.Key("ts");
+        writer.UInt(record.start_ns_ / 1000);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+}
+
+void
+PhaseProfiler::AddPhaseRecord(PhaseRecord&& record,
+                              steady_clock::time_point start_time,
+                              steady_clock::time_point end_time)
+{
+    auto thread_id = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find(thread_ids_.begin(), thread_ids_.end(), thread_id);
+    record.thread_index_ = it - thread_ids_.begin();
+    if (it == thread_ids_.end()) {
+        thread_ids_.push_back(thread_id);
+    }
+    // A phase started before Clear() is clipped at the origin.
+    auto start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      start_time - origin_time_)
+                      .count();
+    record.start_ns_ = std::max<int64_t>(start_ns, 0);
+    record.duration_ns_ =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end_time -
+                                                           start_time)
+        .count();
+    phase_records_.push_back(std::move(record));
+}
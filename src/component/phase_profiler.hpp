@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mizcore {
+
+class JsonWriter;
+
+// The measurements of a phase, such as the lexing or the block parsing.
+struct PhaseRecord
+{
+    std::string name_;
+    // The threads are numbered in the order of their first records.
+    size_t thread_index_ = 0;
+    // Relative to the creation or the last Clear() of the profiler.
+    uint64_t start_ns_ = 0;
+    uint64_t duration_ns_ = 0;
+    // Zero if the phase does not count them.
+    size_t token_num_ = 0;
+    size_t block_num_ = 0;
+    size_t statement_num_ = 0;
+    // The allocations on all threads during the phase. Zero unless
+    // mizcore::allocation_hook is linked (see AllocationCounter).
+    uint64_t allocation_num_ = 0;
+    uint64_t allocated_bytes_ = 0;
+};
+
+// Collects the PhaseRecords of MizController, the lexer and the parsers.
+// The phases may nest, and may run on different threads at the same time.
+class PhaseProfiler
+{
+  public:
+    // Measures a phase from the construction to End() or the destruction of
+    // the scope. Nothing is measured when profiler is nullptr, which is the
+    // default of the users, so that the disabled profiling costs a branch.
+    class Scope
+    {
+      public:
+        // ctor, dtor
+        Scope(PhaseProfiler* profiler, const char* name);
+        virtual ~Scope();
+        Scope(Scope const&) = delete;
+        Scope(Scope&&) = delete;
+        Scope& operator=(Scope const&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+        // attributes
+        void SetTokenNum(size_t token_num) { record_.token_num_ = token_num; }
+        void SetBlockNum(size_t block_num) { record_.block_num_ = block_num; }
+        void SetStatementNum(size_t statement_num)
+        {
+            record_.statement_num_ = statement_num;
+        }
+
+        // operations
+        void End();
+
+      private:
+        PhaseProfiler* profiler_;
+        PhaseRecord record_;
+        std::chrono::steady_clock::time_point start_time_;
+    };
+
+    // ctor, dtor
+    PhaseProfiler() = default;
+    virtual ~PhaseProfiler() = default;
+    PhaseProfiler(PhaseProfiler const&) = delete;
+    PhaseProfiler(PhaseProfiler&&) = delete;
+    PhaseProfiler& operator=(PhaseProfiler const&) = delete;
+    PhaseProfiler& operator=(PhaseProfiler&&) = delete;
+
+    // attributes
+    // Sorted by the start time.
+    std::vector<PhaseRecord> GetPhaseRecords() const;
+
+    // operations
+    void Clear();
+    // Writes the records in the Chrome trace event format, which can be
+    // loaded into chrome://tracing or Perfetto.
+    void WriteChromeTrace(JsonWriter& writer) const;
+
+  private:
+    // implementation
+    void AddPhaseRecord(PhaseRecord&& record,
+                        std::chrono::steady_clock::time_point start_time,
+                        std::chrono::steady_clock::time_point end_time);
+
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point origin_time_ =
+      std::chrono::steady_clock::now();
+    std::vector<PhaseRecord> phase_records_;
+    std::vector<std::thread::id> thread_ids_;
+};
+
+} // namespace mizcore
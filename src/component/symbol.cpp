@@ -3,15 +3,20 @@
 using mizcore::Symbol;
 
 Symbol::Symbol(std::string_view text, SYMBOL_TYPE type, uint8_t priority)
-  : text_(text)
+  : copied_text_(text)
+  , text_(copied_text_)
   , type_(type)
   , priority_(priority)
+  , special_type_(QuerySpecialType(text, type))
+{}
+
+std::unique_ptr<Symbol>
+Symbol::MakeTextView(std::string_view text, SYMBOL_TYPE type, uint8_t priority)
 {
-    if (type == SYMBOL_TYPE::SPECIAL) {
-        special_type_ = QuerySpecialSymbolType(text);
-    } else {
-        special_type_ = SPECIAL_SYMBOL_TYPE::UNKNOWN;
-    }
+    auto symbol = std::make_unique<Symbol>(std::string_view(), type, priority);
+    symbol->text_ = text;
+    symbol->special_type_ = QuerySpecialType(text, type);
+    return symbol;
 }
 
 std::string_view
@@ -42,3 +47,10 @@ Symbol::GetTypeString() const
             return "";
     }
 }
+
+mizcore::SPECIAL_SYMBOL_TYPE
+Symbol::QuerySpecialType(std::string_view text, SYMBOL_TYPE type)
+{
+    return type == SYMBOL_TYPE::SPECIAL ? QuerySpecialSymbolType(text)
+                                        : SPECIAL_SYMBOL_TYPE::UNKNOWN;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -12,6 +13,16 @@ class Symbol final
 {
   public:
     Symbol(std::string_view text, SYMBOL_TYPE type, uint8_t priority = 64);
+    // The symbol refers to text without a copy, e.g. to the string pool of a
+    // mapped vocabulary image, so text must outlive the symbol.
+    static std::unique_ptr<Symbol> MakeTextView(std::string_view text,
+                                                SYMBOL_TYPE type,
+                                                uint8_t priority);
+    Symbol(Symbol const&) = delete;
+    Symbol(Symbol&&) = delete;
+    Symbol& operator=(Symbol const&) = delete;
+    Symbol& operator=(Symbol&&) = delete;
+
     std::string_view GetText() const { return text_; }
     SYMBOL_TYPE GetType() const { return type_; }
     uint8_t GetPriority() const { return priority_; }
@@ -19,7 +30,12 @@ class Symbol final
     SPECIAL_SYMBOL_TYPE GetSpecialType() const { return special_type_; }
 
   private:
-    std::string text_;
+    static SPECIAL_SYMBOL_TYPE QuerySpecialType(std::string_view text,
+                                                SYMBOL_TYPE type);
+
+    // text_ refers to copied_text_ unless the symbol is a text view.
+    std::string copied_text_;
+    std::string_view text_;
     SYMBOL_TYPE type_;
     uint8_t priority_;
     SPECIAL_SYMBOL_TYPE special_type_;
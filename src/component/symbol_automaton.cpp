@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <tuple>
+
+#include "symbol_automaton.hpp"
+
+using mizcore::Symbol;
+using mizcore::SymbolAutomaton;
+
+void
+SymbolAutomaton::Clear()
+{
+    units_.clear();
+    units_.shrink_to_fit();
+    symbols_.clear();
+    symbols_.shrink_to_fit();
+    state_num_ = 0;
+}
+
+void
+SymbolAutomaton::Build(
+  std::vector<std::pair<std::string_view, Symbol*>> symbols)
+{
+    Clear();
+
+    symbols.erase(std::remove_if(symbols.begin(),
+                                 symbols.end(),
+                                 [](const auto& x) { return x.first.empty(); }),
+                  symbols.end());
+    std::sort(symbols.begin(),
+              symbols.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return lhs.first < rhs.first;
+              });
+
+    symbols_.reserve(symbols.size());
+    for (const auto& [text, symbol] : symbols) {
+        symbols_.push_back(symbol);
+    }
+
+    // The root state is units_[0].
+    std::set<size_t> free_units;
+    Reserve(ALPHABET_SIZE, free_units);
+    units_[0].check = 0;
+    free_units.erase(0);
+    state_num_ = 1;
+
+    // Every state is created from the range of the sorted symbols which
+    // share the prefix of length "depth".
+    using StateRange = std::tuple<size_t, size_t, size_t, size_t>;
+    std::queue<StateRange> states;
+    states.emplace(0, 0, symbols.size(), 0);
+
+    std::vector<uint8_t> labels;
+    labels.reserve(ALPHABET_SIZE);
+    while (!states.empty()) {
+        auto [state, begin, end, depth] = states.front();
+        states.pop();
+
+        if (begin < end && symbols[begin].first.size() == depth) {
+            units_[state].accept = static_cast<uint32_t>(begin + 1);
+            ++begin;
+        }
+        if (begin == end) {
+            continue;
+        }
+
+        labels.clear();
+        for (size_t i = begin; i < end; ++i) {
+            auto label = static_cast<uint8_t>(symbols[i].first[depth]);
+            if (labels.empty() || labels.back() != label) {
+                labels.push_back(label);
+            }
+        }
+
+        size_t base = FindBase(labels, free_units);
+        units_[state].base = static_cast<int32_t>(base);
+        for (auto label : labels) {
+            units_[base + label].check = static_cast<int32_t>(state);
+            free_units.erase(base + label);
+        }
+        state_num_ += labels.size();
+
+        size_t child_begin = begin;
+        for (size_t i = begin; i <= end; ++i) {
+            if (i == end || static_cast<uint8_t>(symbols[i].first[depth]) !=
+                              static_cast<uint8_t>(
+                                symbols[child_begin].first[depth])) {
+                auto label = static_cast<uint8_t>(
+                  symbols[child_begin].first[depth]);
+                states.emplace(base + label, child_begin, i, depth + 1);
+                child_begin = i;
+            }
+        }
+    }
+
+    // Trim the unused tail so that every transition of the last states is
+    // still inside the array.
+    while (units_.size() > 1 && units_.back().check < 0) {
+        units_.pop_back();
+    }
+    units_.shrink_to_fit();
+}
+
+Symbol*
+SymbolAutomaton::QueryLongestMatchSymbol(std::string_view text) const
+{
+    Symbol* result = nullptr;
+    Walk(units_.data(), units_.size(), text, [this, &result](uint32_t accept) {
+        result = symbols_[accept - 1];
+    });
+    return result;
+}
+
+size_t
+SymbolAutomaton::FindBase(const std::vector<uint8_t>& labels,
+                          std::set<size_t>& free_units)
+{
+    // Try to place the first label on each free unit. base must be positive
+    // so that no transition goes back to the root.
+    size_t pos = labels.front() + 1U;
+    while (true) {
+        auto it = free_units.lower_bound(pos);
+        if (it == free_units.end()) {
+            Reserve(units_.size() + ALPHABET_SIZE, free_units);
+            continue;
+        }
+        pos = *it;
+        size_t base = pos - labels.front();
+        Reserve(base + ALPHABET_SIZE, free_units);
+        bool ok = std::all_of(
+          labels.begin(), labels.end(), [this, base](uint8_t label) {
+              return units_[base + label].check < 0;
+          });
+        if (ok) {
+            return base;
+        }
+        ++pos;
+    }
+}
+
+void
+SymbolAutomaton::Reserve(size_t size, std::set<size_t>& free_units)
+{
+    size_t old_size = units_.size();
+    if (old_size < size) {
+        units_.resize(std::max(size, old_size * 2));
+        for (size_t i = old_size; i < units_.size(); ++i) {
+            free_units.insert(free_units.end(), i);
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "char_class.hpp"
+
+namespace mizcore {
+
+class Symbol;
+
+// Deterministic automaton which recognizes a fixed set of symbols.
+// The transitions are stored as a double-array in one contiguous vector:
+// the transition from state s by the byte c goes to t = base(s) + c, and is
+// valid only when check(t) == s.
+class SymbolAutomaton
+{
+  public:
+    // A unit of the double-array. It is also the record of the automaton of a
+    // VocabularyImage, and must not be changed without its format version.
+    struct Unit
+    {
+        int32_t base = 0;
+        int32_t check = -1;
+        // 1 + index of the symbol accepted in this state, or 0.
+        uint32_t accept = 0;
+    };
+
+    // ctor, dtor
+    SymbolAutomaton() = default;
+    virtual ~SymbolAutomaton() = default;
+
+    SymbolAutomaton(const SymbolAutomaton&) = delete;
+    SymbolAutomaton(SymbolAutomaton&&) = delete;
+    SymbolAutomaton& operator=(const SymbolAutomaton&) = delete;
+    SymbolAutomaton& operator=(SymbolAutomaton&&) = delete;
+
+    // attributes
+    bool IsBuilt() const { return !units_.empty(); }
+    size_t GetStateNum() const { return state_num_; }
+    size_t GetUnitNum() const { return units_.size(); }
+    const std::vector<Unit>& GetUnits() const { return units_; }
+
+    // operations
+    void Clear();
+    void Build(std::vector<std::pair<std::string_view, Symbol*>> symbols);
+    Symbol* QueryLongestMatchSymbol(std::string_view text) const;
+    // Follows the transitions of the units by text, and calls on_accept with
+    // the accept value of each accepting state at a word boundary (see
+    // SymbolTable::IsWordBoundaryCharacter), from the shortest match.
+    template<class Callback>
+    static void Walk(const Unit* units,
+                     size_t unit_num,
+                     std::string_view text,
+                     Callback&& on_accept);
+
+  private:
+    static constexpr size_t ALPHABET_SIZE = 256;
+
+    size_t FindBase(const std::vector<uint8_t>& labels,
+                    std::set<size_t>& free_units);
+    void Reserve(size_t size, std::set<size_t>& free_units);
+
+    std::vector<Unit> units_;
+    std::vector<Symbol*> symbols_;
+    size_t state_num_ = 0;
+};
+
+template<class Callback>
+void
+SymbolAutomaton::Walk(const Unit* units,
+                      size_t unit_num,
+                      std::string_view text,
+                      Callback&& on_accept)
+{
+    if (unit_num == 0) {
+        return;
+    }
+    size_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        size_t next = static_cast<size_t>(units[state].base) +
+                      static_cast<uint8_t>(text[i]);
+        if (next >= unit_num ||
+            units[next].check != static_cast<int32_t>(state)) {
+            break;
+        }
+        state = next;
+
+        uint32_t accept = units[state].accept;
+        if (accept != 0 && (i + 1 == text.size() || !IsWordChar(text[i]) ||
+                            !IsWordChar(text[i + 1]))) {
+            on_accept(accept);
+        }
+    }
+}
+
+} // namespace mizcore
@@ -1,5 +1,11 @@
-#include "symbol_table.hpp"
+#include <algorithm>
+#include <set>
+
+#include "char_class.hpp"
+#include "fnv_hash.hpp"
 #include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "vocabulary_image.hpp"
 
 using std::string;
 using std::unique_ptr;
@@ -8,16 +14,46 @@ using std::vector;
 using mizcore::Symbol;
 using mizcore::SYMBOL_TYPE;
 using mizcore::SymbolTable;
+using mizcore::VocabularyImage;
 
 SymbolTable::SymbolTable()
 {
     Initialize();
 }
 
+SymbolTable::SymbolTable(std::shared_ptr<const SymbolTable> base)
+  : base_(std::move(base))
+  , use_symbol_automaton_(base_->use_symbol_automaton_)
+  , image_(base_->image_)
+  , image_table_(base_->image_table_)
+  , file_ranks_(image_ ? image_->GetFileNum() : 0, -1)
+{
+    BuildQueryMapOne("SPECIAL_");
+}
+
+SymbolTable::SymbolTable(std::shared_ptr<const VocabularyImage> image)
+  : image_(std::move(image))
+  , image_table_(this)
+  , image_symbols_(new std::atomic<Symbol*>[image_->GetSymbolNum()]())
+  , file_ranks_(image_->GetFileNum(), -1)
+{
+    BuildQueryMapOne("SPECIAL_");
+}
+
+SymbolTable::~SymbolTable()
+{
+    if (image_table_ == this) {
+        for (size_t i = 0; i < image_->GetSymbolNum(); ++i) {
+            delete image_symbols_[i].load();
+        }
+    }
+}
+
 void
 SymbolTable::Initialize()
 {
     query_map_is_built_ = false;
+    automaton_.Clear();
 
     AddSymbol("SPECIAL_", ",", SYMBOL_TYPE::SPECIAL);
     AddSymbol("SPECIAL_", ";", SYMBOL_TYPE::SPECIAL);
@@ -70,14 +106,47 @@ SymbolTable::AddSynonym(Symbol* s0, Symbol* s1)
     synonyms_.emplace_back(s0, s1);
 }
 
+std::vector<std::string_view>
+SymbolTable::CollectFileNames() const
+{
+    if (image_) {
+        std::vector<std::string_view> filenames;
+        filenames.reserve(image_->GetFileNum());
+        for (size_t i = 0; i < image_->GetFileNum(); ++i) {
+            filenames.push_back(image_->GetFileName(i));
+        }
+        return filenames;
+    }
+    std::set<std::string_view> filenames;
+    for (const auto* table = this; table != nullptr;
+         table = table->base_.get()) {
+        for (const auto& pair : table->file2symbols_) {
+            filenames.insert(pair.first);
+        }
+    }
+    return { filenames.begin(), filenames.end() };
+}
+
 std::vector<Symbol*>
 SymbolTable::CollectFileSymbols(std::string_view filename) const
 {
     vector<Symbol*> symbols;
-    auto it = file2symbols_.find(string(filename));
-    if (it != file2symbols_.end()) {
-        symbols.reserve(it->second.size());
-        for (const auto& symbol : it->second) {
+    if (image_) {
+        uint32_t filename_id = image_->FindFileId(filename);
+        if (filename_id != mizcore::VOCABULARY_IMAGE_NO_ID) {
+            const auto& file_record = image_->GetFileRecord(filename_id);
+            for (uint32_t id = file_record.first_symbol_id_;
+                 id < file_record.end_symbol_id_;
+                 ++id) {
+                symbols.push_back(GetImageSymbol(id));
+            }
+        }
+        return symbols;
+    }
+    const auto* file_symbols = FindFileSymbols(filename);
+    if (file_symbols != nullptr) {
+        symbols.reserve(file_symbols->size());
+        for (const auto& symbol : *file_symbols) {
             symbols.push_back(symbol.get());
         }
     }
@@ -87,9 +156,35 @@ SymbolTable::CollectFileSymbols(std::string_view filename) const
 const std::vector<std::pair<Symbol*, Symbol*>>&
 SymbolTable::CollectSynonyms() const
 {
+    if (image_) {
+        std::call_once(image_table_->image_synonyms_flag_, [this] {
+            auto& synonyms = image_table_->image_synonyms_;
+            synonyms.reserve(image_->GetSynonymNum());
+            for (size_t i = 0; i < image_->GetSynonymNum(); ++i) {
+                const auto& record = image_->GetSynonymRecord(i);
+                synonyms.emplace_back(GetImageSymbol(record.symbol_id0_),
+                                      GetImageSymbol(record.symbol_id1_));
+            }
+        });
+        return image_table_->image_synonyms_;
+    }
+    if (base_ && synonyms_.empty()) {
+        return base_->CollectSynonyms();
+    }
     return synonyms_;
 }
 
+void
+SymbolTable::SetUseSymbolAutomaton(bool use_symbol_automaton)
+{
+    use_symbol_automaton_ = use_symbol_automaton;
+    if (!use_symbol_automaton_) {
+        automaton_.Clear();
+    } else if (query_map_is_built_) {
+        BuildSymbolAutomaton();
+    }
+}
+
 void
 SymbolTable::BuildQueryMap()
 {
@@ -98,11 +193,22 @@ SymbolTable::BuildQueryMap()
     }
 
     BuildQueryMapOne("HIDDEN");
-    if (valid_filenames_.empty()) {
-        for (const auto& pair : file2symbols_) {
-            for (const auto& symbol_ptr : pair.second) {
-                Symbol* symbol = symbol_ptr.get();
-                query_map_[symbol->GetText()] = symbol;
+    if (valid_filenames_.empty() && image_) {
+        for (auto& file_rank : file_ranks_) {
+            file_rank = next_file_rank_++;
+        }
+    } else if (valid_filenames_.empty()) {
+        // The files of a fork shadow those of its base.
+        std::set<std::string_view> visited_filenames;
+        for (const auto* table = this; table != nullptr;
+             table = table->base_.get()) {
+            for (const auto& pair : table->file2symbols_) {
+                if (!visited_filenames.insert(pair.first).second) {
+                    continue;
+                }
+                for (const auto& symbol_ptr : pair.second) {
+                    AddQuerySymbol(symbol_ptr.get());
+                }
             }
         }
     } else {
@@ -111,16 +217,45 @@ SymbolTable::BuildQueryMap()
         }
     }
     query_map_is_built_ = true;
+
+    if (use_symbol_automaton_) {
+        BuildSymbolAutomaton();
+    }
 }
 
 Symbol*
 SymbolTable::QueryLongestMatchSymbol(std::string_view text) const
 {
-    size_t pos = text.length();
+    if (image_) {
+        uint32_t symbol_id =
+          image_->QueryLongestMatchSymbolId(text, file_ranks_);
+        return symbol_id == mizcore::VOCABULARY_IMAGE_NO_ID
+                 ? nullptr
+                 : GetImageSymbol(symbol_id);
+    }
+    if (!CanStartSymbol(text)) {
+        return nullptr;
+    }
+
+    // A symbol which ends inside the leading run of word characters can never
+    // be followed by a word boundary.
+    size_t word_end = ScanCharClassRun(text, 0, CHAR_CLASS::WORD);
+    if (word_end > max_symbol_length_) {
+        return nullptr;
+    }
+
+    if (automaton_.IsBuilt()) {
+        return automaton_.QueryLongestMatchSymbol(text);
+    }
+
+    size_t pos = std::min(text.length(), max_symbol_length_);
     while (pos > 0) {
         auto longest_prefix = query_map_.longest_prefix(text.substr(0, pos));
         if (longest_prefix != query_map_.end()) {
             pos = longest_prefix.key().length();
+            if (pos < word_end) {
+                break;
+            }
             if (IsWordBoundary(text, pos)) {
                 return longest_prefix.value();
             }
@@ -133,18 +268,141 @@ SymbolTable::QueryLongestMatchSymbol(std::string_view text) const
     return nullptr;
 }
 
-void
-SymbolTable::BuildQueryMapOne(std::string_view filename)
+uint64_t
+SymbolTable::ComputeFingerprint() const
+{
+    if (image_) {
+        return image_->GetFingerprint();
+    }
+    uint64_t hash = mizcore::FNV1A_OFFSET_BASIS;
+    std::set<std::string_view> visited_filenames;
+    for (const auto* table = this; table != nullptr;
+         table = table->base_.get()) {
+        for (const auto& pair : table->file2symbols_) {
+            if (!visited_filenames.insert(pair.first).second) {
+                continue;
+            }
+            hash = mizcore::Fnv1aHash(pair.first, hash);
+            hash = mizcore::Fnv1aHash(pair.second.size(), hash);
+            for (const auto& symbol_ptr : pair.second) {
+                hash = mizcore::Fnv1aHash(symbol_ptr->GetText().size(), hash);
+                hash = mizcore::Fnv1aHash(symbol_ptr->GetText(), hash);
+                hash = mizcore::Fnv1aHash(
+                  static_cast<uint64_t>(symbol_ptr->GetType()) << 8 |
+                    symbol_ptr->GetPriority(),
+                  hash);
+            }
+        }
+    }
+    for (const auto& [s0, s1] : CollectSynonyms()) {
+        hash = mizcore::Fnv1aHash(s0->GetText(), hash);
+        hash = mizcore::Fnv1aHash(s1->GetText(), hash);
+    }
+    return hash;
+}
+
+const std::vector<std::unique_ptr<Symbol>>*
+SymbolTable::FindFileSymbols(std::string_view filename) const
 {
     auto it = file2symbols_.find(string(filename));
     if (it != file2symbols_.end()) {
-        for (const auto& symbol_ptr : it->second) {
-            Symbol* symbol = symbol_ptr.get();
-            query_map_[symbol->GetText()] = symbol;
+        return &it->second;
+    }
+    return base_ ? base_->FindFileSymbols(filename) : nullptr;
+}
+
+void
+SymbolTable::BuildQueryMapOne(std::string_view filename)
+{
+    if (image_) {
+        uint32_t filename_id = image_->FindFileId(filename);
+        if (filename_id != mizcore::VOCABULARY_IMAGE_NO_ID) {
+            file_ranks_[filename_id] = next_file_rank_++;
+        }
+        return;
+    }
+    const auto* file_symbols = FindFileSymbols(filename);
+    if (file_symbols != nullptr) {
+        for (const auto& symbol_ptr : *file_symbols) {
+            AddQuerySymbol(symbol_ptr.get());
         }
     }
 }
 
+void
+SymbolTable::AddQuerySymbol(Symbol* symbol)
+{
+    std::string_view text = symbol->GetText();
+    if (text.empty()) {
+        return;
+    }
+    query_map_[text] = symbol;
+
+    auto c0 = static_cast<uint8_t>(text[0]);
+    first_char_filter_.set(c0);
+    if (text.length() == 1) {
+        single_char_filter_.set(c0);
+    } else {
+        auto c1 = static_cast<uint8_t>(text[1]);
+        first_two_chars_filter_.set(c0 * 256U + c1);
+    }
+    max_symbol_length_ = std::max(max_symbol_length_, text.length());
+}
+
+void
+SymbolTable::BuildSymbolAutomaton()
+{
+    if (image_) {
+        // The automaton of the image is used instead.
+        return;
+    }
+    std::vector<std::pair<std::string_view, Symbol*>> symbols;
+    symbols.reserve(query_map_.size());
+    for (auto it = query_map_.begin(); it != query_map_.end(); ++it) {
+        symbols.emplace_back(it.value()->GetText(), it.value());
+    }
+    automaton_.Build(std::move(symbols));
+}
+
+bool
+SymbolTable::CanStartSymbol(std::string_view text) const
+{
+    if (text.empty()) {
+        return false;
+    }
+
+    auto c0 = static_cast<uint8_t>(text[0]);
+    if (!first_char_filter_.test(c0)) {
+        return false;
+    }
+    if (text.length() == 1 || single_char_filter_.test(c0)) {
+        return true;
+    }
+    auto c1 = static_cast<uint8_t>(text[1]);
+    return first_two_chars_filter_.test(c0 * 256U + c1);
+}
+
+Symbol*
+SymbolTable::GetImageSymbol(uint32_t symbol_id) const
+{
+    auto& image_symbol = image_table_->image_symbols_[symbol_id];
+    Symbol* symbol = image_symbol.load(std::memory_order_acquire);
+    if (symbol != nullptr) {
+        return symbol;
+    }
+    const auto& record = image_->GetSymbolRecord(symbol_id);
+    auto new_symbol =
+      Symbol::MakeTextView(image_->GetSymbolText(symbol_id),
+                           static_cast<SYMBOL_TYPE>(record.type_),
+                           record.priority_);
+    // Another thread may have created the symbol in the meantime.
+    if (image_symbol.compare_exchange_strong(
+          symbol, new_symbol.get(), std::memory_order_acq_rel)) {
+        symbol = new_symbol.release();
+    }
+    return symbol;
+}
+
 bool
 SymbolTable::IsWordBoundary(std::string_view text, size_t pos)
 {
@@ -158,5 +416,5 @@ SymbolTable::IsWordBoundary(std::string_view text, size_t pos)
 bool
 SymbolTable::IsWordBoundaryCharacter(const char x)
 {
-    return !(static_cast<bool>(isalnum(x)) || (x == '_'));
+    return !IsWordChar(x);
 }
\ No newline at end of file
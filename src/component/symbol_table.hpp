@@ -1,24 +1,38 @@
 #pragma once
 
+#include <atomic>
+#include <bitset>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "ast_type.hpp"
+#include "symbol_automaton.hpp"
 #include "tsl/htrie_map.h"
 
 namespace mizcore {
 
 class Symbol;
+class VocabularyImage;
 
 class SymbolTable
 {
   public:
     // ctor, dtor
     SymbolTable();
-    virtual ~SymbolTable() = default;
+    // Fork of base: the symbols and synonyms of base are shared, and the
+    // query map is built independently. base must not be modified while the
+    // fork is in use.
+    explicit SymbolTable(std::shared_ptr<const SymbolTable> base);
+    // The symbols of the image, which are looked up on its automaton instead
+    // of the query map of each table. A symbol is created when it is first
+    // looked up, and refers to its text in the image. The table and its forks
+    // must not add symbols.
+    explicit SymbolTable(std::shared_ptr<const VocabularyImage> image);
+    virtual ~SymbolTable();
 
     SymbolTable(const SymbolTable&) = delete;
     SymbolTable(SymbolTable&&) = delete;
@@ -35,25 +49,70 @@ class SymbolTable
     {
         valid_filenames_.emplace_back(filename);
     }
+    const std::vector<std::string>& GetValidFileNames() const
+    {
+        return valid_filenames_;
+    }
+    // The file names of the table and its bases in the sorted order.
+    std::vector<std::string_view> CollectFileNames() const;
     std::vector<Symbol*> CollectFileSymbols(std::string_view filename) const;
     const std::vector<std::pair<Symbol*, Symbol*>>& CollectSynonyms() const;
+    // Compiles the active symbols into a SymbolAutomaton when the query map is
+    // built, and uses it for QueryLongestMatchSymbol.
+    void SetUseSymbolAutomaton(bool use_symbol_automaton);
+    bool IsUseSymbolAutomaton() const { return use_symbol_automaton_; }
+    const SymbolAutomaton& GetSymbolAutomaton() const { return automaton_; }
 
     // operations
     void Initialize();
     void BuildQueryMap();
     Symbol* QueryLongestMatchSymbol(std::string_view text) const;
+    // Hash of the symbols and synonyms of the table and its bases, which
+    // identifies the vocabulary in the keys of ParseResultCache.
+    uint64_t ComputeFingerprint() const;
 
   private:
     // implementation
+    const std::vector<std::unique_ptr<Symbol>>* FindFileSymbols(
+      std::string_view filename) const;
     void BuildQueryMapOne(std::string_view filename);
+    void AddQuerySymbol(Symbol* symbol);
+    void BuildSymbolAutomaton();
+    bool CanStartSymbol(std::string_view text) const;
+    Symbol* GetImageSymbol(uint32_t symbol_id) const;
     static bool IsWordBoundary(std::string_view text, size_t pos);
     static bool IsWordBoundaryCharacter(char x);
 
+    std::shared_ptr<const SymbolTable> base_;
     std::map<std::string, std::vector<std::unique_ptr<Symbol>>> file2symbols_;
     std::vector<std::pair<Symbol*, Symbol*>> synonyms_;
     std::vector<std::string> valid_filenames_;
     tsl::htrie_map<char, Symbol*> query_map_;
     bool query_map_is_built_ = false;
+
+    // Filters in front of query_map_, maintained together with it.
+    // first_char_filter_ : first characters of the symbols in query_map_
+    // single_char_filter_ : symbols of length one
+    // first_two_chars_filter_ : first two characters of the longer symbols
+    std::bitset<256> first_char_filter_;
+    std::bitset<256> single_char_filter_;
+    std::bitset<256 * 256> first_two_chars_filter_;
+    size_t max_symbol_length_ = 0;
+
+    bool use_symbol_automaton_ = false;
+    SymbolAutomaton automaton_;
+
+    // With an image, the files are ranked in the order in which they are
+    // added to the query map, and the symbols of the image are owned by
+    // image_table_, which is the table of the image or a base of the fork.
+    // The symbols are created by the threads which look them up first.
+    std::shared_ptr<const VocabularyImage> image_;
+    const SymbolTable* image_table_ = nullptr;
+    std::unique_ptr<std::atomic<Symbol*>[]> image_symbols_;
+    mutable std::once_flag image_synonyms_flag_;
+    mutable std::vector<std::pair<Symbol*, Symbol*>> image_synonyms_;
+    std::vector<int32_t> file_ranks_;
+    int32_t next_file_rank_ = 0;
 };
 
 } // namespace mizcore
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <utility>
+
+#include "thread_pool.hpp"
+
+using mizcore::ThreadPool;
+
+namespace {
+
+thread_local bool is_in_task = false;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_num)
+{
+    if (thread_num == 0) {
+        thread_num = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // The calling thread is the participant 0.
+    for (size_t i = 0; i < thread_num; ++i) {
+        ranges_.emplace_back(std::make_unique<TaskRange>());
+    }
+    for (size_t i = 1; i < thread_num; ++i) {
+        workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void
+ThreadPool::ParallelFor(size_t n, const std::function<void(size_t)>& task)
+{
+    if (n == 0) {
+        return;
+    }
+    if (workers_.empty() || n == 1 || is_in_task) {
+        for (size_t i = 0; i < n; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> parallel_for_lock(parallel_for_mutex_);
+
+    size_t participant_num = ranges_.size();
+    for (size_t i = 0; i < participant_num; ++i) {
+        std::lock_guard<std::mutex> lock(ranges_[i]->mutex_);
+        ranges_[i]->begin_ = n * i / participant_num;
+        ranges_[i]->end_ = n * (i + 1) / participant_num;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        exception_ = nullptr;
+        active_worker_num_ = workers_.size();
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    RunTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return active_worker_num_ == 0; });
+    task_ = nullptr;
+    if (exception_) {
+        std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+}
+
+void
+ThreadPool::WorkerLoop(size_t participant_id)
+{
+    size_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [this, generation] {
+                return is_stopping_ || generation_ != generation;
+            });
+            if (is_stopping_) {
+                return;
+            }
+            generation = generation_;
+        }
+
+        RunTasks(participant_id);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_worker_num_;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+void
+ThreadPool::RunTasks(size_t participant_id)
+{
+    is_in_task = true;
+    size_t index = 0;
+    while (true) {
+        if (!PopTask(participant_id, index)) {
+            if (!StealTasks(participant_id)) {
+                break;
+            }
+            continue;
+        }
+
+        try {
+            (*task_)(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!exception_) {
+                exception_ = std::current_exception();
+            }
+        }
+    }
+    is_in_task = false;
+}
+
+bool
+ThreadPool::PopTask(size_t participant_id, size_t& index)
+{
+    auto& range = *ranges_[participant_id];
+    std::lock_guard<std::mutex> lock(range.mutex_);
+    if (range.begin_ == range.end_) {
+        return false;
+    }
+    index = range.begin_++;
+    return true;
+}
+
+bool
+ThreadPool::StealTasks(size_t participant_id)
+{
+    size_t participant_num = ranges_.size();
+    for (size_t i = 1; i < participant_num; ++i) {
+        auto& victim = *ranges_[(participant_id + i) % participant_num];
+        size_t begin = 0;
+        size_t end = 0;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex_);
+            size_t rest = victim.end_ - victim.begin_;
+            if (rest == 0) {
+                continue;
+            }
+            begin = victim.end_ - (rest + 1) / 2;
+            end = victim.end_;
+            victim.end_ = begin;
+        }
+
+        auto& range = *ranges_[participant_id];
+        std::lock_guard<std::mutex> lock(range.mutex_);
+        range.begin_ = begin;
+        range.end_ = end;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mizcore {
+
+// Fixed size thread pool for data parallel loops.
+// Each participant owns a contiguous range of the loop indices, and steals
+// the half of another range when its own range is exhausted.
+class ThreadPool
+{
+  public:
+    // ctor, dtor
+    // thread_num includes the calling thread. 0 means the number of the
+    // hardware threads.
+    explicit ThreadPool(size_t thread_num = 0);
+    virtual ~ThreadPool();
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    // attributes
+    size_t GetThreadNum() const { return workers_.size() + 1; }
+
+    // operations
+    // Call task(i) for each i in [0, n) and wait for all of them. The calling
+    // thread also runs the tasks. A call from inside a task runs serially.
+    // The first exception thrown by the tasks is rethrown.
+    void ParallelFor(size_t n, const std::function<void(size_t)>& task);
+
+  private:
+    struct TaskRange
+    {
+        std::mutex mutex_;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+    };
+
+    void WorkerLoop(size_t participant_id);
+    void RunTasks(size_t participant_id);
+    bool PopTask(size_t participant_id, size_t& index);
+    bool StealTasks(size_t participant_id);
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<TaskRange>> ranges_;
+
+    std::mutex parallel_for_mutex_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(size_t)>* task_ = nullptr;
+    std::exception_ptr exception_;
+    size_t generation_ = 0;
+    size_t active_worker_num_ = 0;
+    bool is_stopping_ = false;
+};
+
+} // namespace mizcore
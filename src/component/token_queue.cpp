@@ -0,0 +1,73 @@
+#include "ast_token.hpp"
+#include "token_queue.hpp"
+
+using mizcore::ASTToken;
+using mizcore::TokenQueue;
+
+TokenQueue::~TokenQueue()
+{
+    for (auto* token : tokens_) {
+        delete token;
+    }
+}
+
+void
+TokenQueue::Push(const std::vector<ASTToken*>& tokens)
+{
+    if (tokens.empty()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(
+      lock, [this] { return tokens_.size() < capacity_ || is_cancelled_; });
+    if (is_cancelled_) {
+        for (auto* token : tokens) {
+            delete token;
+        }
+        return;
+    }
+    tokens_.insert(tokens_.end(), tokens.begin(), tokens.end());
+    lock.unlock();
+    not_empty_.notify_one();
+}
+
+bool
+TokenQueue::Pop(std::vector<ASTToken*>& tokens)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !tokens_.empty() || is_closed_; });
+    if (tokens_.empty()) {
+        return false;
+    }
+    tokens.insert(tokens.end(), tokens_.begin(), tokens_.end());
+    tokens_.clear();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+}
+
+void
+TokenQueue::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_closed_ = true;
+    }
+    not_empty_.notify_all();
+}
+
+void
+TokenQueue::Cancel()
+{
+    std::deque<ASTToken*> tokens;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_cancelled_ = true;
+        tokens.swap(tokens_);
+    }
+    not_full_.notify_all();
+    for (auto* token : tokens) {
+        delete token;
+    }
+}
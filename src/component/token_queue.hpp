@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace mizcore {
+
+class ASTToken;
+
+// Bounded queue which hands over tokens from a lexer thread to a parser
+// thread. The tokens are detached from the TokenTable of the lexer, and the
+// receiver adopts them into its own TokenTable.
+class TokenQueue
+{
+  public:
+    // ctor, dtor
+    explicit TokenQueue(size_t capacity = 4096)
+      : capacity_(capacity)
+    {}
+    virtual ~TokenQueue();
+    TokenQueue(TokenQueue const&) = delete;
+    TokenQueue(TokenQueue&&) = delete;
+    TokenQueue& operator=(TokenQueue const&) = delete;
+    TokenQueue& operator=(TokenQueue&&) = delete;
+
+    // attributes
+    size_t GetCapacity() const { return capacity_; }
+
+    // operations
+    // Blocks while the queue is full.
+    void Push(const std::vector<ASTToken*>& tokens);
+    // Appends all the queued tokens to "tokens". Blocks while the queue is
+    // empty and not closed. Returns false when no more token will come.
+    bool Pop(std::vector<ASTToken*>& tokens);
+    void Close();
+    // Called by the receiver which stops popping. The queued tokens and those
+    // pushed from now on are deleted, and Push() no longer blocks.
+    void Cancel();
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<ASTToken*> tokens_;
+    size_t capacity_;
+    bool is_closed_ = false;
+    bool is_cancelled_ = false;
+};
+
+} // namespace mizcore
@@ -1,19 +1,24 @@
+#include <cassert>
 #include <iomanip>
+#include <iterator>
 #include <ostream>
 #include <sstream>
 
 #include "ast_token.hpp"
+#include "json_writer.hpp"
 #include "token_table.hpp"
 
 using nlohmann::json;
 
 using mizcore::ASTToken;
+using mizcore::JsonWriter;
+using mizcore::TokenColumns;
 using mizcore::TokenTable;
 
 void
 TokenTable::AddToken(ASTToken* token)
 {
-    token->SetId(tokens_.size());
+    token->SetId(GetTokenNum());
     tokens_.emplace_back(token);
 }
 
@@ -21,7 +26,64 @@ void
 TokenTable::ReplaceToken(ASTToken* token, size_t i)
 {
     token->SetId(i);
-    tokens_[i].reset(token);
+    tokens_[i - first_token_id_].reset(token);
+}
+
+void
+TokenTable::DetachTokens(size_t end_id, std::vector<ASTToken*>& tokens)
+{
+    assert(first_token_id_ <= end_id && end_id <= GetTokenNum());
+    size_t n = end_id - first_token_id_;
+    tokens.reserve(tokens.size() + n);
+    for (size_t i = 0; i < n; ++i) {
+        tokens.push_back(tokens_[i].release());
+    }
+    tokens_.erase(tokens_.begin(), tokens_.begin() + n);
+    first_token_id_ = end_id;
+}
+
+void
+TokenTable::AdoptTokens(const std::vector<ASTToken*>& tokens)
+{
+    for (auto* token : tokens) {
+        assert(token->GetId() == GetTokenNum());
+        tokens_.emplace_back(token);
+    }
+}
+
+void
+TokenTable::SpliceTokens(size_t begin_id,
+                         size_t end_id,
+                         const std::vector<ASTToken*>& tokens)
+{
+    assert(first_token_id_ <= begin_id && begin_id <= end_id &&
+           end_id <= GetTokenNum());
+    std::vector<std::unique_ptr<ASTToken>> new_tokens(tokens.begin(),
+                                                      tokens.end());
+    auto it = tokens_.erase(tokens_.begin() + (begin_id - first_token_id_),
+                            tokens_.begin() + (end_id - first_token_id_));
+    tokens_.insert(it,
+                   std::make_move_iterator(new_tokens.begin()),
+                   std::make_move_iterator(new_tokens.end()));
+    for (size_t i = begin_id - first_token_id_; i < tokens_.size(); ++i) {
+        tokens_[i]->SetId(first_token_id_ + i);
+    }
+}
+
+void
+TokenTable::ReleaseTokens(size_t end_id,
+                          const std::vector<ASTToken*>& retained_tokens)
+{
+    assert(first_token_id_ <= end_id && end_id <= GetTokenNum());
+    for (auto* token : retained_tokens) {
+        size_t id = token->GetId();
+        if (first_token_id_ <= id && id < end_id &&
+            tokens_[id - first_token_id_].get() == token) {
+            retained_tokens_.push_back(std::move(tokens_[id - first_token_id_]));
+        }
+    }
+    tokens_.erase(tokens_.begin(), tokens_.begin() + (end_id - first_token_id_));
+    first_token_id_ = end_id;
 }
 
 void
@@ -33,3 +95,57 @@ TokenTable::ToJson(nlohmann::json& json) const
         json.push_back(j);
     }
 }
+
+void
+TokenTable::WriteJson(JsonWriter& writer) const
+{
+    // An empty table is null as ToJson() leaves the json untouched.
+    if (tokens_.empty()) {
+        writer.Null();
+        return;
+    }
+    writer.BeginArray();
+    for (const auto& token : tokens_) {
+        token->WriteJson(writer);
+    }
+    writer.EndArray();
+}
+
+void
+TokenTable::ToColumns(TokenColumns& columns) const
+{
+    size_t token_num = tokens_.size();
+    columns.ids_.resize(token_num);
+    columns.token_types_.resize(token_num);
+    columns.sub_types_.resize(token_num);
+    columns.line_numbers_.resize(token_num);
+    columns.column_numbers_.resize(token_num);
+    columns.offsets_.resize(token_num);
+    columns.lengths_.resize(token_num);
+    columns.ref_ids_.resize(token_num);
+    columns.text_.clear();
+
+    size_t text_size = 0;
+    for (const auto& token : tokens_) {
+        text_size += token->GetText().size();
+    }
+    columns.text_.reserve(text_size);
+
+    for (size_t i = 0; i < token_num; ++i) {
+        const ASTToken* token = tokens_[i].get();
+        std::string_view text = token->GetText();
+        const ASTToken* ref_token = token->GetRefToken();
+        columns.ids_[i] = static_cast<uint32_t>(token->GetId());
+        columns.token_types_[i] = static_cast<uint8_t>(token->GetTokenType());
+        columns.sub_types_[i] = token->GetSubType();
+        columns.line_numbers_[i] =
+          static_cast<uint32_t>(token->GetLineNumber());
+        columns.column_numbers_[i] =
+          static_cast<uint32_t>(token->GetColumnNumber());
+        columns.offsets_[i] = static_cast<uint32_t>(columns.text_.size());
+        columns.lengths_[i] = static_cast<uint32_t>(text.size());
+        columns.ref_ids_[i] =
+          ref_token == nullptr ? -1 : static_cast<int32_t>(ref_token->GetId());
+        columns.text_ += text;
+    }
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "nlohmann/json.hpp"
@@ -8,6 +10,26 @@
 namespace mizcore {
 
 class ASTToken;
+class JsonWriter;
+
+// The tokens of a table as parallel arrays, one element per token, which are
+// exported in bulk without touching the token objects one by one.
+struct TokenColumns
+{
+    std::vector<uint32_t> ids_;
+    std::vector<uint8_t> token_types_;
+    // See ASTToken::GetSubType().
+    std::vector<uint8_t> sub_types_;
+    std::vector<uint32_t> line_numbers_;
+    std::vector<uint32_t> column_numbers_;
+    // The range of the text of the token in text_.
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    // The id of the referred token of an identifier, or -1.
+    std::vector<int32_t> ref_ids_;
+    // The texts of the tokens concatenated.
+    std::string text_;
+};
 
 class TokenTable
 {
@@ -23,18 +45,46 @@ class TokenTable
     // attributes
     void AddToken(ASTToken* token);
     void ReplaceToken(ASTToken* token, size_t i);
-    ASTToken* GetToken(size_t i) const { return tokens_[i].get(); }
-    size_t GetTokenNum() const { return tokens_.size(); }
+    // The tokens whose id is less than GetFirstTokenId() have been detached
+    // or released. Returns nullptr for them and for the ids out of the table.
+    ASTToken* GetToken(size_t i) const
+    {
+        if (i < first_token_id_ || i - first_token_id_ >= tokens_.size()) {
+            return nullptr;
+        }
+        return tokens_[i - first_token_id_].get();
+    }
+    size_t GetTokenNum() const { return first_token_id_ + tokens_.size(); }
+    size_t GetFirstTokenId() const { return first_token_id_; }
     ASTToken* GetLastToken() const
     {
         return tokens_.empty() ? nullptr : tokens_.back().get();
     }
 
     // operations
+    // Move the ownership of the tokens [GetFirstTokenId(), end_id) to another
+    // table, which receives them by AdoptTokens().
+    void DetachTokens(size_t end_id, std::vector<ASTToken*>& tokens);
+    void AdoptTokens(const std::vector<ASTToken*>& tokens);
+    // Replace the tokens [begin_id, end_id) with tokens, and renumber them and
+    // the following ones.
+    void SpliceTokens(size_t begin_id,
+                      size_t end_id,
+                      const std::vector<ASTToken*>& tokens);
+    // Delete the tokens [GetFirstTokenId(), end_id) except "retained_tokens",
+    // which are kept alive until the table is destroyed.
+    void ReleaseTokens(size_t end_id,
+                       const std::vector<ASTToken*>& retained_tokens);
     void ToJson(nlohmann::json& json) const;
+    // Writes the same JSON as ToJson() of a null json.
+    void WriteJson(JsonWriter& writer) const;
+    // Fills columns with the tokens [GetFirstTokenId(), GetTokenNum()).
+    void ToColumns(TokenColumns& columns) const;
 
   private:
     std::vector<std::unique_ptr<ASTToken>> tokens_;
+    std::vector<std::unique_ptr<ASTToken>> retained_tokens_;
+    size_t first_token_id_ = 0;
 };
 
 } // namespace mizcore
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "vocabulary_image.hpp"
+
+using mizcore::StringRecord;
+using mizcore::Symbol;
+using mizcore::SYMBOL_TYPE;
+using mizcore::SymbolAutomaton;
+using mizcore::SymbolTable;
+using mizcore::VocabularyFileRecord;
+using mizcore::VocabularyImage;
+using mizcore::VocabularyImageHeader;
+using mizcore::VocabularySymbolRecord;
+using mizcore::VocabularySynonymRecord;
+
+namespace {
+
+bool
+IsInStringPool(const StringRecord& record, std::string_view string_pool)
+{
+    return uint64_t(record.offset_) + record.length_ <= string_pool.size();
+}
+
+bool
+IsSymbolType(uint8_t type)
+{
+    switch (static_cast<SYMBOL_TYPE>(type)) {
+        case SYMBOL_TYPE::PREDICATE:
+        case SYMBOL_TYPE::FUNCTOR:
+        case SYMBOL_TYPE::MODE:
+        case SYMBOL_TYPE::STRUCTURE:
+        case SYMBOL_TYPE::SELECTOR:
+        case SYMBOL_TYPE::ATTRIBUTE:
+        case SYMBOL_TYPE::LEFT_FUNCTOR_BRACKET:
+        case SYMBOL_TYPE::RIGHT_FUNCTOR_BRACKET:
+        case SYMBOL_TYPE::SPECIAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+template<class T>
+void
+AppendRecords(const std::vector<T>& records, std::string& buffer)
+{
+    buffer.append(reinterpret_cast<const char*>(records.data()),
+                  records.size() * sizeof(T));
+}
+
+} // namespace
+
+uint32_t
+VocabularyImage::FindFileId(std::string_view filename) const
+{
+    uint32_t begin = 0;
+    uint32_t end = header_->filename_num_;
+    while (begin < end) {
+        uint32_t middle = begin + (end - begin) / 2;
+        if (GetFileName(middle) < filename) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    if (begin < header_->filename_num_ && GetFileName(begin) == filename) {
+        return begin;
+    }
+    return VOCABULARY_IMAGE_NO_ID;
+}
+
+bool
+VocabularyImage::Open(const std::string& path)
+{
+    Close();
+    if (!file_.Open(path) || !Locate(file_.GetData()) || !Validate()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void
+VocabularyImage::Close()
+{
+    file_.Close();
+    header_ = nullptr;
+    file_records_ = nullptr;
+    symbol_records_ = nullptr;
+    synonym_records_ = nullptr;
+    text_records_ = nullptr;
+    text_symbol_begins_ = nullptr;
+    text_symbol_ids_ = nullptr;
+    units_ = nullptr;
+    string_pool_ = std::string_view();
+}
+
+void
+VocabularyImage::Write(const SymbolTable& vocabulary, std::string& buffer)
+{
+    // The symbols are numbered in the order of the files.
+    std::vector<std::string_view> filenames = vocabulary.CollectFileNames();
+    std::vector<Symbol*> symbols;
+    std::vector<VocabularyFileRecord> file_records;
+    std::vector<uint32_t> symbol_filename_ids;
+    std::string string_pool;
+    auto add_string = [&string_pool](std::string_view text) {
+        StringRecord record{ static_cast<uint32_t>(string_pool.size()),
+                             static_cast<uint32_t>(text.size()) };
+        string_pool += text;
+        return record;
+    };
+    for (const auto& filename : filenames) {
+        VocabularyFileRecord record = {};
+        record.name_ = add_string(filename);
+        record.first_symbol_id_ = static_cast<uint32_t>(symbols.size());
+        for (auto* symbol : vocabulary.CollectFileSymbols(filename)) {
+            symbols.push_back(symbol);
+            symbol_filename_ids.push_back(
+              static_cast<uint32_t>(file_records.size()));
+        }
+        record.end_symbol_id_ = static_cast<uint32_t>(symbols.size());
+        file_records.push_back(record);
+    }
+
+    std::vector<std::string_view> texts;
+    texts.reserve(symbols.size());
+    for (auto* symbol : symbols) {
+        texts.push_back(symbol->GetText());
+    }
+    std::sort(texts.begin(), texts.end());
+    texts.erase(std::unique(texts.begin(), texts.end()), texts.end());
+    std::vector<StringRecord> text_records;
+    text_records.reserve(texts.size());
+    for (auto text : texts) {
+        text_records.push_back(add_string(text));
+    }
+
+    std::unordered_map<const Symbol*, uint32_t> symbol2id;
+    std::vector<VocabularySymbolRecord> symbol_records;
+    std::vector<uint32_t> text_symbol_begins(texts.size() + 1, 0);
+    symbol_records.reserve(symbols.size());
+    for (uint32_t id = 0; id < symbols.size(); ++id) {
+        const auto* symbol = symbols[id];
+        symbol2id.emplace(symbol, id);
+        VocabularySymbolRecord record = {};
+        record.text_id_ = static_cast<uint32_t>(
+          std::lower_bound(texts.begin(), texts.end(), symbol->GetText()) -
+          texts.begin());
+        record.filename_id_ = symbol_filename_ids[id];
+        record.type_ = static_cast<uint8_t>(symbol->GetType());
+        record.priority_ = symbol->GetPriority();
+        symbol_records.push_back(record);
+        ++text_symbol_begins[record.text_id_ + 1];
+    }
+    for (size_t i = 0; i < texts.size(); ++i) {
+        text_symbol_begins[i + 1] += text_symbol_begins[i];
+    }
+    std::vector<uint32_t> text_symbol_ids(symbols.size());
+    std::vector<uint32_t> text_symbol_ends(text_symbol_begins.begin(),
+                                           text_symbol_begins.end() - 1);
+    for (uint32_t id = 0; id < symbols.size(); ++id) {
+        text_symbol_ids[text_symbol_ends[symbol_records[id].text_id_]++] = id;
+    }
+
+    std::vector<VocabularySynonymRecord> synonym_records;
+    for (const auto& [s0, s1] : vocabulary.CollectSynonyms()) {
+        auto it0 = symbol2id.find(s0);
+        auto it1 = symbol2id.find(s1);
+        if (it0 != symbol2id.end() && it1 != symbol2id.end()) {
+            synonym_records.push_back({ it0->second, it1->second });
+        }
+    }
+
+    // SymbolAutomaton accepts 1 + the index of the text in the sorted order,
+    // which is 1 + the text id except for the empty text it drops.
+    size_t empty_text_num = !texts.empty() && texts.front().empty() ? 1 : 0;
+    std::vector<std::pair<std::string_view, Symbol*>> automaton_texts;
+    automaton_texts.reserve(texts.size());
+    for (size_t i = empty_text_num; i < texts.size(); ++i) {
+        automaton_texts.emplace_back(texts[i], nullptr);
+    }
+    SymbolAutomaton automaton;
+    automaton.Build(std::move(automaton_texts));
+    std::vector<SymbolAutomaton::Unit> units = automaton.GetUnits();
+    for (auto& unit : units) {
+        if (unit.accept != 0) {
+            unit.accept += static_cast<uint32_t>(empty_text_num);
+        }
+    }
+
+    VocabularyImageHeader header = {};
+    std::memcpy(
+      header.magic_, VOCABULARY_IMAGE_MAGIC, sizeof(header.magic_));
+    header.format_version_ = VOCABULARY_IMAGE_FORMAT_VERSION;
+    header.byte_order_mark_ = PARSE_RESULT_BYTE_ORDER_MARK;
+    header.filename_num_ = static_cast<uint32_t>(file_records.size());
+    header.symbol_num_ = static_cast<uint32_t>(symbol_records.size());
+    header.synonym_num_ = static_cast<uint32_t>(synonym_records.size());
+    header.text_num_ = static_cast<uint32_t>(text_records.size());
+    header.unit_num_ = static_cast<uint32_t>(units.size());
+    header.fingerprint_ = vocabulary.ComputeFingerprint();
+    header.string_pool_size_ = string_pool.size();
+
+    buffer.clear();
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    AppendRecords(file_records, buffer);
+    AppendRecords(symbol_records, buffer);
+    AppendRecords(synonym_records, buffer);
+    AppendRecords(text_records, buffer);
+    AppendRecords(text_symbol_begins, buffer);
+    AppendRecords(text_symbol_ids, buffer);
+    AppendRecords(units, buffer);
+    buffer += string_pool;
+}
+
+bool
+VocabularyImage::WriteFile(const SymbolTable& vocabulary,
+                           const std::string& path)
+{
+    std::string buffer;
+    Write(vocabulary, buffer);
+
+    // As ParseResultWriter::WriteFile(), the file is renamed after it is
+    // completely written, so that no process maps a partial image.
+    std::random_device random_device;
+    std::string temporary_path =
+      path + ".tmp" + std::to_string(random_device());
+    {
+        std::ofstream ofs(temporary_path, std::ios::binary);
+        if (!ofs.write(buffer.data(), buffer.size())) {
+            ofs.close();
+            std::filesystem::remove(temporary_path);
+            return false;
+        }
+    }
+    std::error_code error_code;
+    std::filesystem::rename(temporary_path, path, error_code);
+    if (error_code) {
+        std::filesystem::remove(temporary_path, error_code);
+        return false;
+    }
+    return true;
+}
+
+uint32_t
+VocabularyImage::QueryLongestMatchSymbolId(
+  std::string_view text,
+  const std::vector<int32_t>& file_ranks) const
+{
+    uint32_t result = VOCABULARY_IMAGE_NO_ID;
+    SymbolAutomaton::Walk(
+      units_, header_->unit_num_, text, [&](uint32_t accept) {
+          uint32_t text_id = accept - 1;
+          int32_t max_rank = -1;
+          for (uint32_t i = text_symbol_begins_[text_id];
+               i < text_symbol_begins_[text_id + 1];
+               ++i) {
+              uint32_t symbol_id = text_symbol_ids_[i];
+              int32_t rank =
+                file_ranks[symbol_records_[symbol_id].filename_id_];
+              if (rank >= 0 && rank >= max_rank) {
+                  max_rank = rank;
+                  result = symbol_id;
+              }
+          }
+      });
+    return result;
+}
+
+bool
+VocabularyImage::Locate(std::string_view data)
+{
+    const auto* header =
+      reinterpret_cast<const VocabularyImageHeader*>(data.data());
+    if (data.size() < sizeof(*header) ||
+        reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0 ||
+        std::memcmp(header->magic_,
+                    VOCABULARY_IMAGE_MAGIC,
+                    sizeof(header->magic_)) != 0 ||
+        header->format_version_ != VOCABULARY_IMAGE_FORMAT_VERSION ||
+        header->byte_order_mark_ != PARSE_RESULT_BYTE_ORDER_MARK) {
+        return false;
+    }
+
+    uint64_t file_offset = sizeof(*header);
+    uint64_t symbol_offset =
+      file_offset +
+      uint64_t(header->filename_num_) * sizeof(VocabularyFileRecord);
+    uint64_t synonym_offset =
+      symbol_offset +
+      uint64_t(header->symbol_num_) * sizeof(VocabularySymbolRecord);
+    uint64_t text_offset =
+      synonym_offset +
+      uint64_t(header->synonym_num_) * sizeof(VocabularySynonymRecord);
+    uint64_t text_symbol_begin_offset =
+      text_offset + uint64_t(header->text_num_) * sizeof(StringRecord);
+    uint64_t text_symbol_id_offset =
+      text_symbol_begin_offset +
+      (uint64_t(header->text_num_) + 1) * sizeof(uint32_t);
+    uint64_t unit_offset =
+      text_symbol_id_offset + uint64_t(header->symbol_num_) * sizeof(uint32_t);
+    uint64_t string_pool_offset =
+      unit_offset +
+      uint64_t(header->unit_num_) * sizeof(SymbolAutomaton::Unit);
+    if (string_pool_offset > data.size() ||
+        header->string_pool_size_ != data.size() - string_pool_offset) {
+        return false;
+    }
+
+    const char* base = data.data();
+    header_ = header;
+    file_records_ =
+      reinterpret_cast<const VocabularyFileRecord*>(base + file_offset);
+    symbol_records_ =
+      reinterpret_cast<const VocabularySymbolRecord*>(base + symbol_offset);
+    synonym_records_ =
+      reinterpret_cast<const VocabularySynonymRecord*>(base + synonym_offset);
+    text_records_ = reinterpret_cast<const StringRecord*>(base + text_offset);
+    text_symbol_begins_ =
+      reinterpret_cast<const uint32_t*>(base + text_symbol_begin_offset);
+    text_symbol_ids_ =
+      reinterpret_cast<const uint32_t*>(base + text_symbol_id_offset);
+    units_ =
+      reinterpret_cast<const SymbolAutomaton::Unit*>(base + unit_offset);
+    string_pool_ = data.substr(string_pool_offset);
+    return true;
+}
+
+// The records are checked as those of the parse results, since a stale or
+// truncated image must not be trusted.
+bool
+VocabularyImage::Validate() const
+{
+    uint32_t filename_num = header_->filename_num_;
+    uint32_t symbol_num = header_->symbol_num_;
+    uint32_t text_num = header_->text_num_;
+    uint32_t end_symbol_id = 0;
+    for (uint32_t i = 0; i < filename_num; ++i) {
+        const auto& record = file_records_[i];
+        if (!IsInStringPool(record.name_, string_pool_) ||
+            record.first_symbol_id_ != end_symbol_id ||
+            record.end_symbol_id_ < record.first_symbol_id_ ||
+            record.end_symbol_id_ > symbol_num ||
+            (i > 0 && GetFileName(i - 1) >= GetFileName(i))) {
+            return false;
+        }
+        end_symbol_id = record.end_symbol_id_;
+    }
+    if (end_symbol_id != symbol_num) {
+        return false;
+    }
+    for (uint32_t i = 0; i < symbol_num; ++i) {
+        const auto& record = symbol_records_[i];
+        if (record.text_id_ >= text_num || !IsSymbolType(record.type_) ||
+            record.filename_id_ >= filename_num ||
+            i < file_records_[record.filename_id_].first_symbol_id_ ||
+            i >= file_records_[record.filename_id_].end_symbol_id_) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header_->synonym_num_; ++i) {
+        const auto& record = synonym_records_[i];
+        if (record.symbol_id0_ >= symbol_num ||
+            record.symbol_id1_ >= symbol_num) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < text_num; ++i) {
+        if (!IsInStringPool(text_records_[i], string_pool_)) {
+            return false;
+        }
+    }
+    if (text_symbol_begins_[0] != 0 ||
+        text_symbol_begins_[text_num] != symbol_num) {
+        return false;
+    }
+    for (uint32_t i = 0; i < text_num; ++i) {
+        if (text_symbol_begins_[i] > text_symbol_begins_[i + 1]) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < symbol_num; ++i) {
+        if (text_symbol_ids_[i] >= symbol_num) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header_->unit_num_; ++i) {
+        if (units_[i].accept > text_num) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "parse_result_format.hpp"
+#include "symbol_automaton.hpp"
+
+namespace mizcore {
+
+class SymbolTable;
+
+// Binary image of a vocabulary, which the processes map read-only and share
+// instead of loading mml.vct each (see SymbolTable(image)). The symbol
+// automaton over all the symbols is included, so that the lookups run on the
+// mapped pages:
+//
+//   VocabularyImageHeader
+//   VocabularyFileRecord[filename_num]    in the order of the file names
+//   VocabularySymbolRecord[symbol_num]    grouped by the files, each in the
+//                                         order of the definitions
+//   VocabularySynonymRecord[synonym_num]
+//   StringRecord[text_num]                distinct texts in the sorted order
+//   uint32_t[text_num + 1]                begin of the symbols of each text in
+//                                         the following array
+//   uint32_t[symbol_num]                  symbol ids grouped by the texts
+//   SymbolAutomaton::Unit[unit_num]       accept is 1 + text id
+//   char[string_pool_size]
+//
+// As in the format of the parse results, the records are in the byte order of
+// the host.
+constexpr char VOCABULARY_IMAGE_MAGIC[4] = { 'M', 'Z', 'V', 'I' };
+constexpr uint32_t VOCABULARY_IMAGE_FORMAT_VERSION = 1;
+constexpr uint32_t VOCABULARY_IMAGE_NO_ID = UINT32_MAX;
+
+struct VocabularyImageHeader
+{
+    char magic_[4];
+    uint32_t format_version_;
+    uint32_t byte_order_mark_;
+    uint32_t filename_num_;
+    uint32_t symbol_num_;
+    uint32_t synonym_num_;
+    uint32_t text_num_;
+    uint32_t unit_num_;
+    // SymbolTable::ComputeFingerprint() of the vocabulary.
+    uint64_t fingerprint_;
+    uint64_t string_pool_size_;
+};
+
+struct VocabularyFileRecord
+{
+    StringRecord name_;
+    // The symbols of the file are [first_symbol_id_, end_symbol_id_).
+    uint32_t first_symbol_id_;
+    uint32_t end_symbol_id_;
+};
+
+struct VocabularySymbolRecord
+{
+    uint32_t text_id_;
+    uint32_t filename_id_;
+    // SYMBOL_TYPE other than UNKNOWN.
+    uint8_t type_;
+    uint8_t priority_;
+    uint16_t reserved_;
+};
+
+struct VocabularySynonymRecord
+{
+    uint32_t symbol_id0_;
+    uint32_t symbol_id1_;
+};
+
+static_assert(sizeof(VocabularyImageHeader) == 48);
+static_assert(sizeof(VocabularyFileRecord) == 16);
+static_assert(sizeof(VocabularySymbolRecord) == 12);
+static_assert(sizeof(VocabularySynonymRecord) == 8);
+static_assert(sizeof(SymbolAutomaton::Unit) == 12);
+
+class VocabularyImage
+{
+  public:
+    // ctor, dtor
+    VocabularyImage() = default;
+    virtual ~VocabularyImage() = default;
+    VocabularyImage(VocabularyImage const&) = delete;
+    VocabularyImage(VocabularyImage&&) = delete;
+    VocabularyImage& operator=(VocabularyImage const&) = delete;
+    VocabularyImage& operator=(VocabularyImage&&) = delete;
+
+    // attributes
+    bool IsOpen() const { return header_ != nullptr; }
+    uint64_t GetFingerprint() const { return header_->fingerprint_; }
+    size_t GetFileNum() const { return header_->filename_num_; }
+    std::string_view GetFileName(size_t filename_id) const
+    {
+        return GetString(file_records_[filename_id].name_);
+    }
+    // VOCABULARY_IMAGE_NO_ID if there is no such file.
+    uint32_t FindFileId(std::string_view filename) const;
+    const VocabularyFileRecord& GetFileRecord(size_t filename_id) const
+    {
+        return file_records_[filename_id];
+    }
+    size_t GetSymbolNum() const { return header_->symbol_num_; }
+    const VocabularySymbolRecord& GetSymbolRecord(size_t symbol_id) const
+    {
+        return symbol_records_[symbol_id];
+    }
+    std::string_view GetSymbolText(size_t symbol_id) const
+    {
+        return GetString(text_records_[symbol_records_[symbol_id].text_id_]);
+    }
+    size_t GetSynonymNum() const { return header_->synonym_num_; }
+    const VocabularySynonymRecord& GetSynonymRecord(size_t i) const
+    {
+        return synonym_records_[i];
+    }
+
+    // operations
+    // Returns false if the file cannot be mapped or is not a valid image.
+    bool Open(const std::string& path);
+    void Close();
+    // Writes the image of the symbols and the synonyms of vocabulary and its
+    // bases. WriteFile() returns false if the file cannot be written.
+    static void Write(const SymbolTable& vocabulary, std::string& buffer);
+    static bool WriteFile(const SymbolTable& vocabulary,
+                          const std::string& path);
+
+    // The id of the longest symbol at the start of text which ends at a word
+    // boundary, among the symbols of the files of non-negative ranks. Of the
+    // symbols of the same text, that of the file of the highest rank is
+    // taken, and the later defined one in the same file. Returns
+    // VOCABULARY_IMAGE_NO_ID if there is no such symbol.
+    uint32_t QueryLongestMatchSymbolId(
+      std::string_view text,
+      const std::vector<int32_t>& file_ranks) const;
+
+  private:
+    // implementation
+    std::string_view GetString(const StringRecord& record) const
+    {
+        return string_pool_.substr(record.offset_, record.length_);
+    }
+    bool Locate(std::string_view data);
+    bool Validate() const;
+
+    MappedFile file_;
+    const VocabularyImageHeader* header_ = nullptr;
+    const VocabularyFileRecord* file_records_ = nullptr;
+    const VocabularySymbolRecord* symbol_records_ = nullptr;
+    const VocabularySynonymRecord* synonym_records_ = nullptr;
+    const StringRecord* text_records_ = nullptr;
+    const uint32_t* text_symbol_begins_ = nullptr;
+    const uint32_t* text_symbol_ids_ = nullptr;
+    const SymbolAutomaton::Unit* units_ = nullptr;
+    std::string_view string_pool_;
+};
+
+} // namespace mizcore
@@ -1,27 +1,39 @@
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <set>
 #include <sstream>
+#include <unordered_map>
+#include <utility>
 
 #include "spdlog/spdlog.h"
 
 #include "ast_block.hpp"
 #include "ast_statement.hpp"
 #include "ast_token.hpp"
+#include "char_class.hpp"
 #include "error_object.hpp"
 #include "error_table.hpp"
 #include "miz_block_parser.hpp"
+#include "phase_profiler.hpp"
+#include "thread_pool.hpp"
+#include "token_queue.hpp"
 #include "token_table.hpp"
 
 using mizcore::ASTBlock;
 using mizcore::ASTStatement;
 using mizcore::ASTToken;
+using mizcore::ErrorTable;
 using mizcore::MizBlockParser;
+using mizcore::PhaseProfiler;
 
 using mizcore::BLOCK_TYPE;
 using mizcore::ELEMENT_TYPE;
 using mizcore::ERROR_TYPE;
+using mizcore::IDENTIFIER_TYPE;
 using mizcore::KEYWORD_TYPE;
 using mizcore::STATEMENT_TYPE;
 using mizcore::TOKEN_TYPE;
@@ -59,40 +71,369 @@ void
 MizBlockParser::Parse()
 {
     ASTToken* prev_token = nullptr;
-    size_t token_num = token_table_->GetTokenNum();
-    if (token_num == 0) {
+    if (FetchToken(0) == nullptr) {
         return;
     }
 
-    for (size_t i = 0; i < token_num; ++i) {
-        auto* token = token_table_->GetToken(i);
-        auto token_type = token->GetTokenType();
-        switch (token_type) {
-            case TOKEN_TYPE::UNKNOWN:
-                ParseUnknown(token);
-                break;
-            case TOKEN_TYPE::NUMERAL:
-                ParseNumeral(token);
-                break;
-            case TOKEN_TYPE::SYMBOL:
-                ParseSymbol(token, prev_token);
-                break;
-            case TOKEN_TYPE::IDENTIFIER:
-                ParseIdentifier(token);
-                break;
-            case TOKEN_TYPE::KEYWORD:
-                ParseKeyword(token, prev_token);
-                break;
-            case TOKEN_TYPE::COMMENT:
-                // ignore
+    if (item_callback_) {
+        // The reference frame of the root block, which is pushed by
+        // ResolveIdentifierInBlock() in the normal mode.
+        PushReferenceStack();
+    }
+
+    // The items are recorded only in the normal mode.
+    bool is_recording_items =
+      is_incremental_mode_ && !item_callback_ && !token_queue_;
+    std::vector<std::array<size_t, 2>> error_nums;
+    items_.clear();
+
+    PhaseProfiler::Scope build_scope(phase_profiler_.get(), "build_ast");
+    ASTToken* token = nullptr;
+    for (size_t i = 0; (token = FetchToken(i)) != nullptr; ++i) {
+        if (is_recording_items) {
+            ParseItemToken(i, token, prev_token, items_, error_nums);
+        } else {
+            ParseToken(token, prev_token);
+        }
+
+        if (token->GetTokenType() != TOKEN_TYPE::COMMENT) {
+            prev_token = token;
+        }
+    }
+
+    // The lexer has finished, so the token table is complete from here.
+    token_queue_.reset();
+    queued_tokens_.clear();
+
+    CheckArticleEnd(prev_token);
+    if (is_recording_items) {
+        FinishItems(items_, error_nums, token_table_->GetTokenNum());
+        is_top_error_after_build_ = GetCurrentComponent()->IsError();
+        built_item_num_ = items_.size();
+    }
+
+    build_scope.End();
+
+    // Resolve identifier type and references
+    PhaseProfiler::Scope resolve_scope(phase_profiler_.get(),
+                                       "resolve_identifier");
+    if (item_callback_) {
+        EmitItems(nullptr);
+        PopReferenceStack();
+    } else if (is_recording_items) {
+        ResolveIdentifierInItems();
+    } else if (CanResolveIdentifierInParallel()) {
+        ResolveIdentifierInRootInParallel();
+    } else {
+        ResolveIdentifierInBlock(ast_root_.get());
+    }
+}
+
+bool
+MizBlockParser::Reparse(size_t edited_token_id,
+                        size_t removed_token_num,
+                        size_t inserted_token_num)
+{
+    if (!is_incremental_mode_ || is_partial_mode_ || item_callback_ ||
+        token_queue_ || items_.empty()) {
+        return false;
+    }
+    auto* root = ast_root_.get();
+    assert(root->GetChildComponentNum() == items_.size());
+    assert(reference_stack_.size() == 2);
+
+    // The item of the token before the edit may be continued by the edited
+    // tokens, and a proof is built with the preceding statement.
+    size_t last_kept_id = edited_token_id > 0 ? edited_token_id - 1 : 0;
+    auto it = std::upper_bound(
+      items_.begin(),
+      items_.end(),
+      last_kept_id,
+      [](size_t id, const Item& item) { return id < item.first_token_id_; });
+    size_t begin = it == items_.begin() ? 0 : it - items_.begin() - 1;
+    auto is_proof = [root](size_t i) {
+        auto* block = root->GetChildBlock(i);
+        return block != nullptr && block->GetBlockType() == BLOCK_TYPE::PROOF;
+    };
+    while (begin > 0 && is_proof(begin)) {
+        --begin;
+    }
+    if (!items_[begin].is_after_begin_keyword_) {
+        return false;
+    }
+
+    // The tokens of the old items from suffix on follow the edit.
+    size_t removed_end_id = edited_token_id + removed_token_num;
+    it = std::lower_bound(
+      items_.begin() + begin,
+      items_.end(),
+      removed_end_id,
+      [](const Item& item, size_t id) { return item.first_token_id_ < id; });
+    size_t suffix = it - items_.begin();
+    auto new_token_id = [=](size_t id) {
+        return id + inserted_token_num - removed_token_num;
+    };
+
+    PhaseProfiler::Scope build_scope(phase_profiler_.get(), "build_ast");
+    auto old_component_stack = ast_component_stack_;
+    int old_proof_stack_num = proof_stack_num_;
+    bool old_is_in_environ = is_in_environ_;
+    bool old_is_in_section = is_in_section_;
+    bool old_is_after_begin_keyword = is_after_begin_keyword_;
+    std::vector<std::unique_ptr<ASTComponent>> old_components;
+    root->DetachChildComponents(begin, old_components);
+    ast_component_stack_ = std::stack<ASTComponent*>();
+    ast_component_stack_.push(root);
+    proof_stack_num_ = 0;
+    is_in_environ_ = items_[begin].is_in_environ_;
+    is_in_section_ = items_[begin].is_in_section_;
+    is_after_begin_keyword_ = items_[begin].is_after_begin_keyword_;
+    error_table_->Clear();
+
+    // Build the items until the start of an old item after the edit, except a
+    // proof, is reached at the root in the same state. The old items from
+    // there on are built in the same way as before.
+    std::vector<Item> items;
+    std::vector<std::array<size_t, 2>> error_nums;
+    size_t end = items_.size();
+    size_t next = suffix;
+    size_t i = items_[begin].first_token_id_;
+    ASTToken* prev_token = QueryPrevToken(token_table_->GetToken(i));
+    ASTToken* token = nullptr;
+    for (; (token = FetchToken(i)) != nullptr; ++i) {
+        while (next < items_.size() &&
+               new_token_id(items_[next].first_token_id_) < i) {
+            ++next;
+        }
+        if (next < items_.size() &&
+            new_token_id(items_[next].first_token_id_) == i &&
+            ast_component_stack_.size() == 1 &&
+            is_in_environ_ == items_[next].is_in_environ_ &&
+            is_in_section_ == items_[next].is_in_section_ &&
+            is_after_begin_keyword_ == items_[next].is_after_begin_keyword_) {
+            auto* component = old_components[next - begin].get();
+            bool is_proof_component =
+              component->GetElementType() == ELEMENT_TYPE::BLOCK &&
+              static_cast<ASTBlock*>(component)->GetBlockType() ==
+                BLOCK_TYPE::PROOF;
+            if (!is_proof_component) {
+                end = next;
                 break;
+            }
         }
 
-        if (token_type != TOKEN_TYPE::COMMENT) {
+        ParseItemToken(i, token, prev_token, items, error_nums);
+        if (token->GetTokenType() != TOKEN_TYPE::COMMENT) {
             prev_token = token;
         }
     }
 
+    bool is_synchronized = end < items_.size();
+    if (is_synchronized) {
+        for (size_t k = end; k < items_.size(); ++k) {
+            root->AddChildComponent(std::move(old_components[k - begin]));
+        }
+        ast_component_stack_ = old_component_stack;
+        proof_stack_num_ = old_proof_stack_num;
+        is_in_environ_ = old_is_in_environ;
+        is_in_section_ = old_is_in_section;
+        is_after_begin_keyword_ = old_is_after_begin_keyword;
+    } else {
+        CheckArticleEnd(prev_token);
+    }
+    assert(!items.empty());
+    FinishItems(items, error_nums, i);
+
+    // The references of the old items [begin, end) are removed from the root
+    // frames. Those of the tokens left in the table are compared by the ids
+    // with the references of the built items later, and the removed
+    // references of the lexed tokens have changed anyway. The lexed tokens
+    // are left out of the kept tokens, as they may be allocated at the
+    // addresses of the removed ones.
+    std::array<size_t, 2> reference_nums = { 0, 0 };
+    for (size_t k = 0; k < begin; ++k) {
+        for (size_t f = 0; f < reference_nums.size(); ++f) {
+            reference_nums[f] += items_[k].reference_nums_[f];
+        }
+    }
+    std::unordered_map<const ASTToken*, size_t> kept_token_ids;
+    size_t inserted_end_id = edited_token_id + inserted_token_num;
+    for (size_t k = items_[begin].first_token_id_; k < i; ++k) {
+        if (k < edited_token_id || k >= inserted_end_id) {
+            kept_token_ids.emplace(token_table_->GetToken(k), k);
+        }
+    }
+    using Reference = std::pair<size_t, IDENTIFIER_TYPE>;
+    std::array<std::vector<Reference>, 2> removed_references;
+    bool is_reference_removed = false;
+    std::vector<std::string> removed_texts;
+    std::array<size_t, 2> removed_reference_nums = { 0, 0 };
+    for (size_t k = begin; k < end; ++k) {
+        for (size_t f = 0; f < reference_nums.size(); ++f) {
+            removed_reference_nums[f] += items_[k].reference_nums_[f];
+        }
+        removed_texts.insert(removed_texts.end(),
+                             items_[k].reference_texts_.begin(),
+                             items_[k].reference_texts_.end());
+    }
+    for (size_t f = 0; f < reference_nums.size(); ++f) {
+        auto& references = reference_stack_[f].references_;
+        auto first = references.begin() + reference_nums[f];
+        auto last = first + removed_reference_nums[f];
+        for (auto rit = first; rit != last; ++rit) {
+            auto kit = kept_token_ids.find(*rit);
+            if (kit == kept_token_ids.end()) {
+                is_reference_removed = true;
+            } else {
+                removed_references[f].emplace_back(
+                  kit->second, (*rit)->GetIdentifierType());
+            }
+        }
+        references.erase(first, last);
+    }
+    for (size_t k = end; k < items_.size(); ++k) {
+        items_[k].first_token_id_ = new_token_id(items_[k].first_token_id_);
+        items_[k].end_token_id_ = new_token_id(items_[k].end_token_id_);
+    }
+    items_.erase(items_.begin() + begin, items_.begin() + end);
+    items_.insert(items_.begin() + begin,
+                  std::make_move_iterator(items.begin()),
+                  std::make_move_iterator(items.end()));
+    size_t built_end = begin + items.size();
+    built_item_num_ = items.size();
+
+    bool is_root_error = false;
+    for (const auto& item : items_) {
+        is_root_error = is_root_error || item.is_root_error_;
+    }
+    root->SetError(is_root_error);
+    auto* top_component = GetCurrentComponent();
+    if (top_component != root && is_synchronized) {
+        top_component->SetError(is_top_error_after_build_);
+    }
+    is_top_error_after_build_ = top_component->IsError();
+    build_scope.End();
+
+    // Resolve the built items and the item after them, which refers to the
+    // last built token, and the following items which have the texts of the
+    // changed references. The other items keep their results.
+    PhaseProfiler::Scope resolve_scope(phase_profiler_.get(),
+                                       "resolve_identifier");
+    error_table_->Clear();
+    for (const auto& item : items_) {
+        AddItemErrors(item.build_errors_, nullptr);
+    }
+    resolved_item_num_ = 0;
+    reference_nums = { 0, 0 };
+    std::unordered_set<std::string> changed_texts;
+    std::array<std::vector<Reference>, 2> built_references;
+    for (size_t k = 0; k < items_.size(); ++k) {
+        auto& item = items_[k];
+        if (k < begin ||
+            (k > built_end && !HasItemIdentifier(item, changed_texts))) {
+            AddItemErrors(item.resolve_errors_, top_component);
+        } else {
+            // The references of the following items are put aside, so that
+            // the root frames are those before the item.
+            std::array<std::vector<IdentifierToken*>, 2> old_references;
+            std::array<std::vector<IdentifierToken*>, 2> following_references;
+            std::vector<IDENTIFIER_TYPE> old_types;
+            for (size_t f = 0; f < reference_nums.size(); ++f) {
+                auto& references = reference_stack_[f].references_;
+                auto first = references.begin() + reference_nums[f];
+                auto last = first + item.reference_nums_[f];
+                old_references[f].assign(first, last);
+                following_references[f].assign(last, references.end());
+                references.erase(first, references.end());
+                for (auto* reference : old_references[f]) {
+                    old_types.push_back(reference->GetIdentifierType());
+                }
+            }
+
+            if (!ResetItemIdentifiers(item)) {
+                return false;
+            }
+            ResolveIdentifierInItem(k);
+
+            std::vector<IDENTIFIER_TYPE> types;
+            bool is_changed = false;
+            for (size_t f = 0; f < reference_nums.size(); ++f) {
+                auto& references = reference_stack_[f].references_;
+                auto first = references.begin() + reference_nums[f];
+                is_changed = is_changed ||
+                             !std::equal(first,
+                                         references.end(),
+                                         old_references[f].begin(),
+                                         old_references[f].end());
+                for (auto rit = first; rit != references.end(); ++rit) {
+                    types.push_back((*rit)->GetIdentifierType());
+                    if (k < built_end) {
+                        built_references[f].emplace_back(
+                          (*rit)->GetId(), (*rit)->GetIdentifierType());
+                    }
+                }
+                references.insert(references.end(),
+                                  following_references[f].begin(),
+                                  following_references[f].end());
+            }
+            if (k + 1 == built_end) {
+                // The built items replace the old ones, whose references are
+                // the same unless a token has been lexed again.
+                if (is_reference_removed ||
+                    built_references != removed_references) {
+                    changed_texts.insert(removed_texts.begin(),
+                                         removed_texts.end());
+                    for (size_t b = begin; b < built_end; ++b) {
+                        changed_texts.insert(
+                          items_[b].reference_texts_.begin(),
+                          items_[b].reference_texts_.end());
+                    }
+                }
+            } else if (k >= built_end && (is_changed || types != old_types)) {
+                for (const auto& references : old_references) {
+                    for (auto* reference : references) {
+                        changed_texts.emplace(reference->GetText());
+                    }
+                }
+                changed_texts.insert(item.reference_texts_.begin(),
+                                     item.reference_texts_.end());
+            }
+        }
+        for (size_t f = 0; f < reference_nums.size(); ++f) {
+            reference_nums[f] += item.reference_nums_[f];
+        }
+    }
+    return true;
+}
+
+void
+MizBlockParser::ParseToken(ASTToken* token, ASTToken* prev_token)
+{
+    switch (token->GetTokenType()) {
+        case TOKEN_TYPE::UNKNOWN:
+            ParseUnknown(token);
+            break;
+        case TOKEN_TYPE::NUMERAL:
+            ParseNumeral(token);
+            break;
+        case TOKEN_TYPE::SYMBOL:
+            ParseSymbol(token, prev_token);
+            break;
+        case TOKEN_TYPE::IDENTIFIER:
+            ParseIdentifier(token);
+            break;
+        case TOKEN_TYPE::KEYWORD:
+            ParseKeyword(token, prev_token);
+            break;
+        case TOKEN_TYPE::COMMENT:
+            // ignore
+            break;
+    }
+}
+
+void
+MizBlockParser::CheckArticleEnd(ASTToken* prev_token)
+{
     // Check the last token of the article
     if (ast_component_stack_.size() != 1) {
         auto* component = GetCurrentComponent();
@@ -106,9 +447,6 @@ MizBlockParser::Parse()
             PopStatement(last_token);
         }
     }
-
-    // Resolve identifier type and references
-    ResolveIdentifierInBlock(ast_root_.get());
 }
 
 void
@@ -300,10 +638,9 @@ MizBlockParser::ParseSchemeKeyword(KeywordToken* token)
         auto* parent_block = static_cast<ASTBlock*>(component);
 
         // Read tokens until a semicolon or "proof" keyword
-        size_t token_num = token_table_->GetTokenNum();
+        ASTToken* current_token = nullptr;
         size_t id = token->GetId() + 1;
-        for (; id < token_num; ++id) {
-            ASTToken* current_token = token_table_->GetToken(id);
+        for (; (current_token = FetchToken(id)) != nullptr; ++id) {
             if (current_token->GetText() == ";") {
                 if (is_abs_mode_) {
                     PushStatement(token, parent_block, STATEMENT_TYPE::SCHEME);
@@ -318,7 +655,7 @@ MizBlockParser::ParseSchemeKeyword(KeywordToken* token)
             }
         }
 
-        if (id == token_num) {
+        if (current_token == nullptr) {
             // The error (No closed statement) will be detected in Parse()
             PushStatement(token, parent_block, STATEMENT_TYPE::SCHEME);
         }
@@ -388,6 +725,14 @@ MizBlockParser::PushBlock(ASTToken* token,
                           ASTBlock* parent_block,
                           BLOCK_TYPE block_type)
 {
+    // Emit the preceding items before the new block becomes the current
+    // component, which the errors of their resolution are recorded to. A proof
+    // block belongs to the preceding item.
+    if (item_callback_ && parent_block == ast_root_.get() &&
+        block_type != BLOCK_TYPE::PROOF) {
+        EmitItems(token);
+    }
+
     // Create a new block and set it to a parent.
     std::unique_ptr<ASTBlock> block = std::make_unique<ASTBlock>(block_type);
     block->SetFirstToken(token);
@@ -436,6 +781,12 @@ MizBlockParser::PushStatement(ASTToken* token,
                               ASTBlock* parent_block,
                               STATEMENT_TYPE statement_type)
 {
+    // Emit the preceding items before the new statement becomes the current
+    // component.
+    if (item_callback_ && parent_block == ast_root_.get()) {
+        EmitItems(token);
+    }
+
     // Create a new statement and set it to a parent block.
     std::unique_ptr<ASTStatement> statement =
       std::make_unique<ASTStatement>(statement_type);
@@ -462,7 +813,28 @@ MizBlockParser::PopStatement(ASTToken* token)
 }
 
 ASTToken*
-MizBlockParser::QueryPrevToken(ASTToken* token) const
+MizBlockParser::FetchToken(size_t i)
+{
+    if (i < item_first_token_id_ || i >= item_end_token_id_) {
+        return nullptr;
+    }
+    while (token_queue_ && i >= token_table_->GetTokenNum()) {
+        queued_tokens_.clear();
+        if (!token_queue_->Pop(queued_tokens_)) {
+            break;
+        }
+        token_table_->AdoptTokens(queued_tokens_);
+    }
+
+    if (i < token_table_->GetFirstTokenId() ||
+        i >= token_table_->GetTokenNum()) {
+        return nullptr;
+    }
+    return token_table_->GetToken(i);
+}
+
+ASTToken*
+MizBlockParser::QueryPrevToken(ASTToken* token)
 {
     if (token == nullptr) {
         return nullptr;
@@ -475,7 +847,11 @@ MizBlockParser::QueryPrevToken(ASTToken* token) const
 
     do {
         --i;
-        auto* prev_token = token_table_->GetToken(i);
+        auto* prev_token = FetchToken(i);
+        if (prev_token == nullptr) {
+            // Released in the streaming mode, or before the item of a worker
+            return i < item_first_token_id_ ? item_prev_token_.get() : nullptr;
+        }
         if (prev_token->GetTokenType() != TOKEN_TYPE::COMMENT) {
             return prev_token;
         }
@@ -485,14 +861,14 @@ MizBlockParser::QueryPrevToken(ASTToken* token) const
 }
 
 ASTToken*
-MizBlockParser::QueryNextToken(ASTToken* token) const
+MizBlockParser::QueryNextToken(ASTToken* token)
 {
     if (token == nullptr) {
         return nullptr;
     }
-    size_t token_num = token_table_->GetTokenNum();
-    for (size_t i = token->GetId() + 1; i < token_num; ++i) {
-        auto* next_token = token_table_->GetToken(i);
+    ASTToken* next_token = nullptr;
+    for (size_t i = token->GetId() + 1; (next_token = FetchToken(i)) != nullptr;
+         ++i) {
         if (next_token->GetTokenType() != TOKEN_TYPE::COMMENT) {
             return next_token;
         }
@@ -500,6 +876,389 @@ MizBlockParser::QueryNextToken(ASTToken* token) const
     return nullptr;
 }
 
+void
+MizBlockParser::EmitItems(ASTToken* next_item_token)
+{
+    auto* root = ast_root_.get();
+    size_t begin = root->GetReleasedChildComponentNum();
+    size_t end = root->GetChildComponentNum();
+    size_t token_end = token_table_->GetTokenNum();
+    if (next_item_token != nullptr) {
+        // The next item is about to be added to the root.
+        token_end = next_item_token->GetId();
+        if (begin >= end) {
+            return;
+        }
+    }
+
+    ResolveIdentifierInChildComponents(root, begin, end);
+
+    std::vector<ASTComponent*> components;
+    components.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        components.push_back(root->GetChildComponent(i));
+    }
+    std::vector<ASTToken*> tokens;
+    tokens.reserve(token_end - emitted_token_num_);
+    for (size_t i = emitted_token_num_; i < token_end; ++i) {
+        tokens.push_back(token_table_->GetToken(i));
+    }
+    emitted_token_num_ = token_end;
+
+    item_callback_(components, tokens);
+
+    root->ReleaseChildComponents(end);
+
+    // Keep a few tokens before the next item for QueryPrevToken().
+    constexpr size_t LOOK_BEHIND_TOKEN_NUM = 3;
+    size_t release_end = token_end;
+    if (next_item_token != nullptr) {
+        ASTToken* token = next_item_token;
+        for (size_t n = 0; n < LOOK_BEHIND_TOKEN_NUM; ++n) {
+            ASTToken* prev_token = QueryPrevToken(token);
+            if (prev_token == nullptr) {
+                break;
+            }
+            token = prev_token;
+        }
+        release_end = std::min(release_end, token->GetId());
+    }
+
+    // The references in the root frames and the tokens of the errors are
+    // still referred after the release.
+    scanned_reference_nums_.resize(reference_stack_.size(), 0);
+    for (size_t i = 0; i < reference_stack_.size(); ++i) {
+        const auto& references = reference_stack_[i].references_;
+        pending_retained_tokens_.insert(pending_retained_tokens_.end(),
+                                        references.begin() +
+                                          scanned_reference_nums_[i],
+                                        references.end());
+        scanned_reference_nums_[i] = references.size();
+    }
+    size_t error_num = error_table_->GetErrorNum();
+    for (size_t i = scanned_error_num_; i < error_num; ++i) {
+        pending_retained_tokens_.push_back(
+          error_table_->GetError(i)->GetASTToken());
+    }
+    scanned_error_num_ = error_num;
+
+    auto it = std::partition(
+      pending_retained_tokens_.begin(),
+      pending_retained_tokens_.end(),
+      [release_end](ASTToken* token) { return token->GetId() >= release_end; });
+    std::vector<ASTToken*> retained_tokens(it, pending_retained_tokens_.end());
+    pending_retained_tokens_.erase(it, pending_retained_tokens_.end());
+
+    token_table_->ReleaseTokens(release_end, retained_tokens);
+}
+
+bool
+MizBlockParser::CanResolveIdentifierInParallel() const
+{
+    // In the partial mode, ReplaceIdentifierType() replaces the tokens in the
+    // shared token table.
+    return thread_pool_ && thread_pool_->GetThreadNum() > 1 &&
+           !is_partial_mode_ && !item_callback_ &&
+           ast_root_->GetChildComponentNum() > 1;
+}
+
+void
+MizBlockParser::ResolveIdentifierInRootInParallel()
+{
+    // The top-level items affect each other only through the two root frames
+    // of the reference stack: the frame of the root labels and the frame of
+    // the root block. Every item only modifies its own tokens.
+    auto* root = ast_root_.get();
+    size_t item_num = root->GetChildComponentNum();
+    PushReferenceStack();
+    assert(reference_stack_.size() == 2);
+
+    // Phase 1: collect the references which each item adds to the root
+    // frames. Only the tokens pushed to the reference stack are resolved, since
+    // ResolveReference() copies their identifier types. The blocks which add
+    // no references to the root frames are skipped, such as most proofs.
+    std::vector<std::array<size_t, 2>> reference_nums(item_num);
+    CountRootDeclarationKeywords();
+    is_declaration_pass_ = true;
+    for (size_t i = 0; i < item_num; ++i) {
+        reference_nums[i] = { reference_stack_[0].references_.size(),
+                              reference_stack_[1].references_.size() };
+        ResolveIdentifierInChildComponents(root, i, i + 1);
+    }
+    is_declaration_pass_ = false;
+    declared_tokens_.clear();
+    root_declaration_keyword_nums_.clear();
+
+    std::array<std::vector<IDENTIFIER_TYPE>, 2> root_types;
+    for (size_t k = 0; k < root_types.size(); ++k) {
+        for (auto* token : reference_stack_[k].references_) {
+            root_types[k].push_back(token->GetIdentifierType());
+        }
+    }
+
+    // Every worker fetches the tokens of its own item only, which it alone
+    // rewrites. The token before the item is copied, since another worker
+    // may be rewriting it.
+    std::vector<size_t> first_token_ids(item_num + 1);
+    std::vector<std::shared_ptr<ASTToken>> prev_tokens(item_num);
+    for (size_t i = 0; i < item_num; ++i) {
+        auto* first_token = root->GetChildComponent(i)->GetRangeFirstToken();
+        first_token_ids[i] = first_token->GetId();
+        auto* prev_token = QueryPrevToken(first_token);
+        if (prev_token != nullptr) {
+            prev_tokens[i] = std::make_shared<UnknownToken>(
+              prev_token->GetLineNumber(),
+              prev_token->GetColumnNumber(),
+              prev_token->GetText());
+            prev_tokens[i]->SetId(prev_token->GetId());
+        }
+    }
+    first_token_ids[item_num] = token_table_->GetTokenNum();
+
+    // Phase 2: resolve each item against the root frames as they were before
+    // the item. The identifier types of the preceding items are taken from
+    // the snapshot, since their tokens are being rewritten by other threads.
+    std::vector<std::shared_ptr<ErrorTable>> error_tables(item_num);
+    thread_pool_->ParallelFor(item_num, [&](size_t i) {
+        error_tables[i] = std::make_shared<ErrorTable>();
+        MizBlockParser resolver(token_table_, error_tables[i]);
+        resolver.item_first_token_id_ = first_token_ids[i];
+        resolver.item_end_token_id_ = first_token_ids[i + 1];
+        resolver.item_prev_token_ = prev_tokens[i];
+        resolver.reference_stack_.clear();
+        for (size_t k = 0; k < root_types.size(); ++k) {
+            const auto& references = reference_stack_[k].references_;
+            size_t n = reference_nums[i][k];
+            References frame;
+            frame.references_.assign(references.begin(),
+                                     references.begin() + n);
+            frame.snapshot_types_.assign(root_types[k].begin(),
+                                         root_types[k].begin() + n);
+            resolver.reference_stack_.push_back(std::move(frame));
+        }
+        resolver.ResolveIdentifierInChildComponents(root, i, i + 1);
+    });
+
+    // Record the errors in the order of the serial resolution.
+    for (const auto& error_table : error_tables) {
+        for (size_t i = 0; i < error_table->GetErrorNum(); ++i) {
+            auto* error = error_table->GetError(i);
+            RecordError(error->GetASTToken(), error->GetErrorType());
+        }
+    }
+    PopReferenceStack();
+}
+
+void
+MizBlockParser::CountRootDeclarationKeywords()
+{
+    // "reserve", "scheme", and "means" or "equals" of a definition label add
+    // references to the root label frame from any depth.
+    size_t token_num = token_table_->GetTokenNum();
+    root_declaration_keyword_nums_.assign(token_num + 1, 0);
+    for (size_t i = 0; i < token_num; ++i) {
+        auto* token = token_table_->GetToken(i);
+        bool is_declaration_keyword = false;
+        if (token->GetTokenType() == TOKEN_TYPE::KEYWORD) {
+            switch (static_cast<KeywordToken*>(token)->GetKeywordType()) {
+                case KEYWORD_TYPE::RESERVE:
+                case KEYWORD_TYPE::SCHEME:
+                    is_declaration_keyword = true;
+                    break;
+                case KEYWORD_TYPE::MEANS:
+                case KEYWORD_TYPE::EQUALS: {
+                    auto* next_token = QueryNextToken(token);
+                    is_declaration_keyword =
+                      next_token != nullptr && next_token->GetText() == ":";
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        root_declaration_keyword_nums_[i + 1] =
+          root_declaration_keyword_nums_[i] + (is_declaration_keyword ? 1 : 0);
+    }
+}
+
+bool
+MizBlockParser::CanDeclareInRoot(const ASTBlock* block) const
+{
+    // Only the statements just below the root add references to the root
+    // block frame, and the frames of the other blocks are popped at their end.
+    auto* first_token = block->GetRangeFirstToken();
+    auto* last_token = block->GetRangeLastToken();
+    size_t first_id = first_token->GetId();
+    size_t end_id = last_token != nullptr
+                      ? last_token->GetId() + 1
+                      : root_declaration_keyword_nums_.size() - 1;
+    return root_declaration_keyword_nums_[end_id] >
+           root_declaration_keyword_nums_[first_id];
+}
+
+void
+MizBlockParser::ParseItemToken(size_t i,
+                               ASTToken* token,
+                               ASTToken* prev_token,
+                               std::vector<Item>& items,
+                               std::vector<std::array<size_t, 2>>& error_nums)
+{
+    auto* root = ast_root_.get();
+    size_t child_num = root->GetChildComponentNum();
+    bool is_in_environ = is_in_environ_;
+    bool is_in_section = is_in_section_;
+    bool is_after_begin_keyword = is_after_begin_keyword_;
+    std::array<size_t, 2> nums = { error_table_->GetErrorNum(),
+                                   root_error_num_ };
+    ParseToken(token, prev_token);
+    if (token->GetTokenType() == TOKEN_TYPE::KEYWORD) {
+        auto keyword_type = static_cast<KeywordToken*>(token)->GetKeywordType();
+        if (keyword_type == KEYWORD_TYPE::BEGIN_) {
+            is_after_begin_keyword_ = true;
+        } else if (keyword_type == KEYWORD_TYPE::ENVIRON) {
+            is_after_begin_keyword_ = false;
+        }
+    }
+
+    // A token starts an item at most, whose errors are recorded from the
+    // start of the token.
+    if (root->GetChildComponentNum() > child_num) {
+        assert(root->GetChildComponentNum() == child_num + 1);
+        Item item;
+        item.first_token_id_ = i;
+        item.is_in_environ_ = is_in_environ;
+        item.is_in_section_ = is_in_section;
+        item.is_after_begin_keyword_ = is_after_begin_keyword;
+        items.push_back(std::move(item));
+        error_nums.push_back(nums);
+    }
+}
+
+void
+MizBlockParser::FinishItems(
+  std::vector<Item>& items,
+  const std::vector<std::array<size_t, 2>>& error_nums,
+  size_t end_token_id)
+{
+    assert(items.size() == error_nums.size());
+    for (size_t k = 0; k < items.size(); ++k) {
+        auto& item = items[k];
+        bool is_last = k + 1 == items.size();
+        item.end_token_id_ =
+          is_last ? end_token_id : items[k + 1].first_token_id_;
+        size_t error_end =
+          is_last ? error_table_->GetErrorNum() : error_nums[k + 1][0];
+        size_t root_error_end =
+          is_last ? root_error_num_ : error_nums[k + 1][1];
+        item.build_errors_.clear();
+        for (size_t e = error_nums[k][0]; e < error_end; ++e) {
+            item.build_errors_.push_back(*error_table_->GetError(e));
+        }
+        item.is_root_error_ = root_error_end > error_nums[k][1];
+    }
+}
+
+void
+MizBlockParser::ResolveIdentifierInItems()
+{
+    // The reference frame of the root block is kept for Reparse().
+    assert(reference_stack_.size() == 1);
+    PushReferenceStack();
+    resolved_item_num_ = 0;
+    for (size_t i = 0; i < items_.size(); ++i) {
+        ResolveIdentifierInItem(i);
+    }
+}
+
+void
+MizBlockParser::ResolveIdentifierInItem(size_t i)
+{
+    // The root frames end with the references of the preceding items.
+    auto& item = items_[i];
+    std::array<size_t, 2> reference_nums = {
+        reference_stack_[0].references_.size(),
+        reference_stack_[1].references_.size()
+    };
+    size_t error_num = error_table_->GetErrorNum();
+    ResolveIdentifierInChildComponents(ast_root_.get(), i, i + 1);
+    assert(reference_stack_.size() == 2);
+
+    item.resolve_errors_.clear();
+    for (size_t e = error_num; e < error_table_->GetErrorNum(); ++e) {
+        item.resolve_errors_.push_back(*error_table_->GetError(e));
+    }
+    item.reference_texts_.clear();
+    for (size_t f = 0; f < reference_nums.size(); ++f) {
+        const auto& references = reference_stack_[f].references_;
+        item.reference_nums_[f] = references.size() - reference_nums[f];
+        for (size_t r = reference_nums[f]; r < references.size(); ++r) {
+            item.reference_texts_.emplace_back(references[r]->GetText());
+        }
+    }
+    item.identifier_texts_.clear();
+    for (size_t id = item.first_token_id_; id < item.end_token_id_; ++id) {
+        auto* token = token_table_->GetToken(id);
+        if (token->GetTokenType() == TOKEN_TYPE::IDENTIFIER) {
+            item.identifier_texts_.emplace_back(token->GetText());
+        }
+    }
+    std::sort(item.identifier_texts_.begin(), item.identifier_texts_.end());
+    item.identifier_texts_.erase(std::unique(item.identifier_texts_.begin(),
+                                             item.identifier_texts_.end()),
+                                 item.identifier_texts_.end());
+    ++resolved_item_num_;
+}
+
+bool
+MizBlockParser::ResetItemIdentifiers(const Item& item)
+{
+    // As the lexer creates the identifiers after "begin". The identifiers
+    // after "environ" may have been typed by the lexer.
+    if (!item.is_after_begin_keyword_) {
+        return false;
+    }
+    for (size_t id = item.first_token_id_; id < item.end_token_id_; ++id) {
+        auto* token = token_table_->GetToken(id);
+        if (token->GetTokenType() == TOKEN_TYPE::KEYWORD &&
+            static_cast<KeywordToken*>(token)->GetKeywordType() ==
+              KEYWORD_TYPE::ENVIRON) {
+            return false;
+        }
+        if (token->GetTokenType() == TOKEN_TYPE::IDENTIFIER) {
+            auto* identifier_token = static_cast<IdentifierToken*>(token);
+            identifier_token->SetIdentifierType(IDENTIFIER_TYPE::UNKNOWN);
+            identifier_token->SetRefToken(nullptr);
+        }
+    }
+    return true;
+}
+
+bool
+MizBlockParser::HasItemIdentifier(
+  const Item& item,
+  const std::unordered_set<std::string>& texts) const
+{
+    const auto& identifier_texts = item.identifier_texts_;
+    return std::any_of(
+      texts.begin(), texts.end(), [&identifier_texts](const std::string& text) {
+          return std::binary_search(
+            identifier_texts.begin(), identifier_texts.end(), text);
+      });
+}
+
+void
+MizBlockParser::AddItemErrors(const std::vector<ErrorObject>& errors,
+                              ASTComponent* component)
+{
+    for (const auto& error : errors) {
+        error_table_->AddError(new ErrorObject(error));
+        if (component != nullptr &&
+            GetErrorLevel(error.GetErrorType()) == ERROR_LEVEL::ERROR) {
+            component->SetError(true);
+        }
+    }
+}
+
 void
 MizBlockParser::ResolveIdentifierInBlock(ASTBlock* block)
 {
@@ -508,16 +1267,27 @@ MizBlockParser::ResolveIdentifierInBlock(ASTBlock* block)
         ResolveNowBlockIdentifier(block);
     }
 
-    size_t child_num = block->GetChildComponentNum();
-    for (size_t i = 0; i < child_num; ++i) {
+    ResolveIdentifierInChildComponents(
+      block, 0, block->GetChildComponentNum());
+    PopReferenceStack();
+}
+
+void
+MizBlockParser::ResolveIdentifierInChildComponents(ASTBlock* block,
+                                                   size_t begin,
+                                                   size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
         auto* component = block->GetChildComponent(i);
         if (component->GetElementType() == ELEMENT_TYPE::BLOCK) {
-            ResolveIdentifierInBlock(static_cast<ASTBlock*>(component));
+            auto* child_block = static_cast<ASTBlock*>(component);
+            if (!is_declaration_pass_ || CanDeclareInRoot(child_block)) {
+                ResolveIdentifierInBlock(child_block);
+            }
         } else {
             ResolveIdentifierInStatement(static_cast<ASTStatement*>(component));
         }
     }
-    PopReferenceStack();
 }
 
 void
@@ -945,11 +1715,12 @@ MizBlockParser::ResolveIdentifierAroundWhere(ASTStatement* statement,
     assert(where_token->GetText() == "where");
     size_t where_id = where_token->GetId();
 
-    // Determine a variable scope of the "where" clause
-    size_t first_scope_id = 0;
+    // Determine a variable scope of the "where" clause, which does not start
+    // before the statement
+    auto* first_statement_token = statement->GetRangeFirstToken();
+    size_t first_scope_id = first_statement_token->GetId();
     {
-        auto* first_statement_token = statement->GetRangeFirstToken();
-        size_t first_statement_id = first_statement_token->GetId();
+        size_t first_statement_id = first_scope_id;
 
         for (ASTToken* curr_token = QueryPrevToken(where_token);
              curr_token != nullptr && curr_token->GetId() >= first_statement_id;
@@ -1036,16 +1807,23 @@ MizBlockParser::ResolveIdentifierAroundWhere(ASTStatement* statement,
 }
 
 void
-MizBlockParser::RecordError(ASTToken* token, ERROR_TYPE error_type) const
+MizBlockParser::RecordError(ASTToken* token, ERROR_TYPE error_type)
 {
     assert(token != nullptr);
+    if (is_declaration_pass_) {
+        return;
+    }
 
     auto* error = new ErrorObject(error_type, token);
     error_table_->AddError(error);
 
     auto error_level = GetErrorLevel(error_type);
     if (error_level == ERROR_LEVEL::ERROR) {
-        GetCurrentComponent()->SetError(true);
+        auto* component = GetCurrentComponent();
+        component->SetError(true);
+        if (component == ast_root_.get()) {
+            ++root_error_num_;
+        }
     }
 }
 
@@ -1132,16 +1910,11 @@ MizBlockParser::CanBeLabelToken(ASTToken* token) const
         auto text = token->GetText();
         assert(!text.empty());
 
-        if (isalpha(text[0]) == 0) {
+        if (!IsAlphaChar(text[0])) {
             return false;
         }
-
-        for (size_t i = 1; i < text.size(); ++i) {
-            if ((isalnum(text[i]) == 0) || text[i] != '_') {
-                return false;
-            }
-        }
-        return true;
+        return ScanCharClassRun(text, 1, CHAR_CLASS::IDENTIFIER) ==
+               text.size();
     }
 
     return false;
@@ -1189,6 +1962,9 @@ MizBlockParser::PushToReferenceStack(ASTToken* token, bool is_root_label)
     assert(!reference_stack_.empty());
     assert(token->GetTokenType() == TOKEN_TYPE::IDENTIFIER);
     auto* identfiler_token = static_cast<IdentifierToken*>(token);
+    if (is_declaration_pass_) {
+        declared_tokens_.insert(token);
+    }
     if (is_root_label) {
         reference_stack_.front().references_.push_back(identfiler_token);
     } else if (reference_stack_.back().is_statement_ && identfiler_token->GetIdentifierType() != IDENTIFIER_TYPE::VARIABLE) {
@@ -1208,6 +1984,10 @@ MizBlockParser::ResolveReference(ASTToken* token)
         (!is_partial_mode_ || token_type != TOKEN_TYPE::SYMBOL)) {
         return;
     }
+    if (is_declaration_pass_ &&
+        declared_tokens_.find(token) == declared_tokens_.end()) {
+        return;
+    }
 
     if (token_type == TOKEN_TYPE::IDENTIFIER) {
         auto* identifierToken = static_cast<IdentifierToken*>(token);
@@ -1220,15 +2000,19 @@ MizBlockParser::ResolveReference(ASTToken* token)
     for (auto rit = reference_stack_.rbegin(); rit != reference_stack_.rend();
          ++rit) {
         const auto& references = rit->references_;
-        for (auto rit2 = references.rbegin(); rit2 != references.rend(); ++rit2) {
-            IdentifierToken* ref_token = *rit2;
+        const auto& snapshot_types = rit->snapshot_types_;
+        for (size_t i = references.size(); i-- > 0;) {
+            IdentifierToken* ref_token = references[i];
             if (ref_token == token) {
                 continue;
             }
 
             std::string_view ref_text = ref_token->GetText();
             if (text == ref_text) {
-                ReplaceIdentifierType(token, ref_token->GetIdentifierType());
+                auto ref_type = i < snapshot_types.size()
+                                  ? snapshot_types[i]
+                                  : ref_token->GetIdentifierType();
+                ReplaceIdentifierType(token, ref_type);
                 assert(token->GetTokenType() == TOKEN_TYPE::IDENTIFIER);
                 static_cast<IdentifierToken*>(token)->SetRefToken(ref_token);
                 return;
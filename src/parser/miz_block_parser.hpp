@@ -1,11 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <stack>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "ast_type.hpp"
 #include "error_def.hpp"
+#include "error_object.hpp"
 
 namespace mizcore {
 
@@ -15,6 +21,9 @@ class ASTStatement;
 class IdentifierToken;
 class ASTToken;
 class KeywordToken;
+class PhaseProfiler;
+class ThreadPool;
+class TokenQueue;
 class TokenTable;
 class ErrorTable;
 
@@ -41,9 +50,70 @@ class MizBlockParser
     bool IsABSMode() const { return is_abs_mode_; }
     void SetABSMode(bool is_abs_mode) { is_abs_mode_ = is_abs_mode; }
 
+    // Receive the tokens from token_queue while the lexer is still running.
+    // They are adopted into token_table, which must be empty.
+    void SetTokenQueue(std::shared_ptr<TokenQueue> token_queue)
+    {
+        token_queue_ = std::move(token_queue);
+    }
+
+    // Streaming mode: each completed top-level item is resolved and passed to
+    // item_callback, and then its components and tokens are released. Only the
+    // tokens referred by later items (root labels and so on) are kept.
+    // The pointers passed to the callback are valid only during the call.
+    using ItemCallback =
+      std::function<void(const std::vector<ASTComponent*>& components,
+                         const std::vector<ASTToken*>& tokens)>;
+    void SetItemCallback(ItemCallback item_callback)
+    {
+        item_callback_ = std::move(item_callback);
+    }
+
+    // Resolve the identifiers of the top-level items on thread_pool. The
+    // results are the same as the serial resolution. Ignored in the partial
+    // and streaming modes.
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool)
+    {
+        thread_pool_ = std::move(thread_pool);
+    }
+
+    // Record the phases "build_ast" and "resolve_identifier" of Parse().
+    void SetPhaseProfiler(std::shared_ptr<PhaseProfiler> phase_profiler)
+    {
+        phase_profiler_ = std::move(phase_profiler);
+    }
+
+    // Incremental mode: record the top-level items of Parse(), so that
+    // Reparse() can parse only the items around an edit of the tokens.
+    bool IsIncrementalMode() const { return is_incremental_mode_; }
+    void SetIncrementalMode(bool is_incremental_mode)
+    {
+        is_incremental_mode_ = is_incremental_mode;
+    }
+
     void Parse();
+    // The tokens [edited_token_id, edited_token_id + removed_token_num) of
+    // the token table have been replaced with inserted_token_num tokens since
+    // the last Parse() or Reparse() in the incremental mode (see
+    // MizIncrementalLexer). The items are built again from the one before the
+    // edit until an old item after it is reached in the same state, and the
+    // old items are kept on both sides. The identifiers are resolved again in
+    // the built items, the item after them, and the following items which
+    // have the texts of the references changed in the root frames. The
+    // results are the same as those of Parse() for the edited tokens.
+    // Returns false if the edit is not after "begin" or the built items are
+    // not, in which case the tokens must be parsed by a new parser.
+    bool Reparse(size_t edited_token_id,
+                 size_t removed_token_num,
+                 size_t inserted_token_num);
+    // The numbers of the top-level items built and resolved by the last
+    // Parse() or Reparse() in the incremental mode.
+    size_t GetBuiltItemNum() const { return built_item_num_; }
+    size_t GetResolvedItemNum() const { return resolved_item_num_; }
 
   private:
+    void ParseToken(ASTToken* token, ASTToken* prev_token);
+    void CheckArticleEnd(ASTToken* prev_token);
     void ParseUnknown(ASTToken* token);
     void ParseNumeral(ASTToken* token);
     void ParseSymbol(ASTToken* token, ASTToken* prev_token);
@@ -67,16 +137,26 @@ class MizBlockParser
                                 ASTBlock* parent_block,
                                 STATEMENT_TYPE statement_type);
     void PopStatement(ASTToken* token);
-    ASTToken* QueryPrevToken(ASTToken* token) const;
-    ASTToken* QueryNextToken(ASTToken* token) const;
+    ASTToken* FetchToken(size_t i);
+    ASTToken* QueryPrevToken(ASTToken* token);
+    ASTToken* QueryNextToken(ASTToken* token);
+
+    void EmitItems(ASTToken* next_item_token);
 
+    bool CanResolveIdentifierInParallel() const;
+    void ResolveIdentifierInRootInParallel();
+    void CountRootDeclarationKeywords();
+    bool CanDeclareInRoot(const ASTBlock* block) const;
     void ResolveIdentifierInBlock(ASTBlock* block);
+    void ResolveIdentifierInChildComponents(ASTBlock* block,
+                                            size_t begin,
+                                            size_t end);
     void ResolveIdentifierInStatement(ASTStatement* statement);
     void ResolveNowBlockIdentifier(ASTBlock* block);
     void ResolveIdentifierAroundWhere(ASTStatement* statement,
                                       ASTToken* curr_token);
 
-    void RecordError(ASTToken* token, ERROR_TYPE error_type) const;
+    void RecordError(ASTToken* token, ERROR_TYPE error_type);
 
     ASTComponent* GetCurrentComponent() const
     {
@@ -93,6 +173,23 @@ class MizBlockParser
     bool CanBeLabelToken(ASTToken* token) const;
     ASTToken* ReplaceIdentifierType(ASTToken* token, IDENTIFIER_TYPE type);
 
+    struct Item;
+    void ParseItemToken(size_t i,
+                        ASTToken* token,
+                        ASTToken* prev_token,
+                        std::vector<Item>& items,
+                        std::vector<std::array<size_t, 2>>& error_nums);
+    void FinishItems(std::vector<Item>& items,
+                     const std::vector<std::array<size_t, 2>>& error_nums,
+                     size_t end_token_id);
+    void ResolveIdentifierInItems();
+    void ResolveIdentifierInItem(size_t i);
+    bool ResetItemIdentifiers(const Item& item);
+    bool HasItemIdentifier(const Item& item,
+                           const std::unordered_set<std::string>& texts) const;
+    void AddItemErrors(const std::vector<ErrorObject>& errors,
+                       ASTComponent* component);
+
     void PushReferenceStack(bool is_statement = false);
     void PopReferenceStack();
     void PushToReferenceStack(ASTToken* token, bool is_root_label = false);
@@ -103,17 +200,75 @@ class MizBlockParser
       References(bool is_statement = false) : is_statement_(is_statement) {}
       bool is_statement_ = false;
       std::vector<IdentifierToken*> references_;
+      // The identifier types of references_[0, snapshot_types_.size()), which
+      // belong to the preceding items resolved by other threads.
+      std::vector<IDENTIFIER_TYPE> snapshot_types_;
+    };
+
+    // A top-level item of the incremental mode, which is a child of the root.
+    struct Item {
+      // The tokens [first_token_id_, end_token_id_), up to the next item.
+      size_t first_token_id_ = 0;
+      size_t end_token_id_ = 0;
+      // The state of the parser before the item.
+      bool is_in_environ_ = false;
+      bool is_in_section_ = false;
+      // The last keyword of "begin" and "environ" before the item is "begin",
+      // after which the lexer creates the identifiers with no types.
+      bool is_after_begin_keyword_ = false;
+      // An error of the building has been recorded to the root.
+      bool is_root_error_ = false;
+      std::vector<ErrorObject> build_errors_;
+      std::vector<ErrorObject> resolve_errors_;
+      // The numbers and the texts of the references added to the two root
+      // frames of the reference stack.
+      std::array<size_t, 2> reference_nums_ = { 0, 0 };
+      std::vector<std::string> reference_texts_;
+      // The sorted texts of the identifiers.
+      std::vector<std::string> identifier_texts_;
     };
 
   private:
     bool is_partial_mode_ = false;
     bool is_abs_mode_ = false;
     std::shared_ptr<TokenTable> token_table_;
+    std::shared_ptr<TokenQueue> token_queue_;
+    std::vector<ASTToken*> queued_tokens_;
     std::shared_ptr<ASTBlock> ast_root_ =
       std::make_shared<ASTBlock>(BLOCK_TYPE::ROOT);
     std::stack<ASTComponent*> ast_component_stack_;
     std::shared_ptr<ErrorTable> error_table_;
     std::vector<References> reference_stack_;
+    std::shared_ptr<PhaseProfiler> phase_profiler_;
+
+    // Parallel resolution
+    std::shared_ptr<ThreadPool> thread_pool_;
+    bool is_declaration_pass_ = false;
+    std::unordered_set<ASTToken*> declared_tokens_;
+    // The numbers of the keywords which may add references to the root label
+    // frame before each token, by which the declaration pass skips blocks.
+    std::vector<size_t> root_declaration_keyword_nums_;
+    // The token range of the item resolved by a worker, out of which the
+    // tokens are not fetched, and a copy of the token before the item.
+    size_t item_first_token_id_ = 0;
+    size_t item_end_token_id_ = SIZE_MAX;
+    std::shared_ptr<ASTToken> item_prev_token_;
+
+    // Streaming mode
+    ItemCallback item_callback_;
+    size_t emitted_token_num_ = 0;
+    size_t scanned_error_num_ = 0;
+    std::vector<size_t> scanned_reference_nums_;
+    std::vector<ASTToken*> pending_retained_tokens_;
+
+    // Incremental mode
+    bool is_incremental_mode_ = false;
+    std::vector<Item> items_;
+    bool is_after_begin_keyword_ = false;
+    size_t root_error_num_ = 0;
+    bool is_top_error_after_build_ = false;
+    size_t built_item_num_ = 0;
+    size_t resolved_item_num_ = 0;
 
     // Only for internal use
     bool is_in_environ_ = false;
@@ -22,7 +22,8 @@ MizPatternParser::ParseBlock(const ASTBlock* ast_block,
                              const std::string& filename)
 {
     size_t child_num = ast_block->GetChildComponentNum();
-    for (size_t i = 0; i < child_num; ++i) {
+    for (size_t i = ast_block->GetReleasedChildComponentNum(); i < child_num;
+         ++i) {
         ASTComponent* child_component = ast_block->GetChildComponent(i);
         auto component_type = child_component->GetElementType();
         if (component_type == ELEMENT_TYPE::BLOCK) {
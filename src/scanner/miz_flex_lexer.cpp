@@ -2,9 +2,12 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "ast_token.hpp"
+#include "phase_profiler.hpp"
 #include "symbol_table.hpp"
+#include "token_queue.hpp"
 #include "token_table.hpp"
 
 #undef yyFlexLexer
@@ -13,7 +16,10 @@
 
 #include "miz_flex_lexer.hpp"
 
+using mizcore::ASTToken;
 using mizcore::MizFlexLexer;
+using mizcore::MizLexerLineState;
+using mizcore::PhaseProfiler;
 
 using mizcore::KEYWORD_TYPE;
 
@@ -24,13 +30,70 @@ MizFlexLexer::MizFlexLexer(std::istream* in,
   , token_table_(std::make_shared<TokenTable>())
 {}
 
+MizLexerLineState
+MizFlexLexer::GetLineState() const
+{
+    MizLexerLineState line_state;
+    line_state.is_in_environ_section_ = is_in_environ_section_;
+    line_state.is_in_vocabulary_section_ = is_in_vocabulary_section_;
+    line_state.is_after_begin_ = is_after_begin_;
+    auto* last_token = token_table_->GetLastToken();
+    line_state.is_after_unknown_ =
+      (last_token != nullptr) &&
+      last_token->GetTokenType() == TOKEN_TYPE::UNKNOWN;
+    return line_state;
+}
+
+void
+MizFlexLexer::SetLineState(const MizLexerLineState& line_state)
+{
+    // An unknown token cannot be continued from another lexing.
+    assert(!line_state.is_after_unknown_);
+    is_in_environ_section_ = line_state.is_in_environ_section_;
+    is_in_vocabulary_section_ = line_state.is_in_vocabulary_section_;
+    is_after_begin_ = line_state.is_after_begin_;
+}
+
+void
+MizFlexLexer::CloseTokenQueue()
+{
+    if (token_queue_) {
+        PublishTokens(token_table_->GetTokenNum());
+        token_queue_->Close();
+        token_queue_.reset();
+    }
+}
+
+void
+MizFlexLexer::AddToken(ASTToken* token)
+{
+    token_table_->AddToken(token);
+
+    // The last token is held back since ScanUnknown() may still extend it.
+    constexpr size_t BATCH_SIZE = 256;
+    size_t token_num = token_table_->GetTokenNum();
+    if (token_queue_ &&
+        token_num - 1 - token_table_->GetFirstTokenId() >= BATCH_SIZE) {
+        PublishTokens(token_num - 1);
+    }
+}
+
+void
+MizFlexLexer::PublishTokens(size_t end_id)
+{
+    std::vector<ASTToken*> tokens;
+    token_table_->DetachTokens(end_id, tokens);
+    token_queue_->Push(tokens);
+}
+
 size_t
 MizFlexLexer::ScanSymbol()
 {
-    Symbol* symbol = symbol_table_->QueryLongestMatchSymbol(yytext);
+    Symbol* symbol = symbol_table_->QueryLongestMatchSymbol(
+      std::string_view(yytext, yyleng));
     if (symbol != nullptr) {
         ASTToken* token = new SymbolToken(line_number_, column_number_, symbol);
-        token_table_->AddToken(token);
+        AddToken(token);
         size_t length = token->GetText().size();
         column_number_ += length;
 
@@ -47,7 +110,7 @@ size_t
 MizFlexLexer::ScanIdentifier()
 {
     ASTToken* token = new IdentifierToken(line_number_, column_number_, yytext);
-    token_table_->AddToken(token);
+    AddToken(token);
     column_number_ += yyleng;
     return yyleng;
 }
@@ -62,6 +125,8 @@ MizFlexLexer::ScanKeyword(KEYWORD_TYPE type)
     } else if (type == KEYWORD_TYPE::BEGIN_) {
         is_in_environ_section_ = false;
         is_in_vocabulary_section_ = false;
+        is_after_begin_ = true;
+        PhaseProfiler::Scope scope(phase_profiler_.get(), "build_query_map");
         symbol_table_->BuildQueryMap();
     } else if (type == KEYWORD_TYPE::VOCABULARIES) {
         if (is_in_environ_section_) {
@@ -69,7 +134,7 @@ MizFlexLexer::ScanKeyword(KEYWORD_TYPE type)
         }
     }
 
-    token_table_->AddToken(token);
+    AddToken(token);
     column_number_ += yyleng;
     return yyleng;
 }
@@ -79,7 +144,7 @@ MizFlexLexer::ScanNumeral()
 {
     ASTToken* token = new NumeralToken(line_number_, column_number_, yytext);
     assert(token);
-    token_table_->AddToken(token);
+    AddToken(token);
     column_number_ += yyleng;
     return yyleng;
 }
@@ -91,7 +156,7 @@ MizFlexLexer::ScanFileName()
         ASTToken* token = new IdentifierToken(
           line_number_, column_number_, yytext, IDENTIFIER_TYPE::FILENAME);
         assert(token);
-        token_table_->AddToken(token);
+        AddToken(token);
         column_number_ += yyleng;
 
         if (is_in_vocabulary_section_) {
@@ -108,7 +173,7 @@ MizFlexLexer::ScanComment(COMMENT_TYPE type)
     ASTToken* token =
       new CommentToken(line_number_, column_number_, yytext, type);
     assert(token);
-    token_table_->AddToken(token);
+    AddToken(token);
     column_number_ += yyleng;
     return yyleng;
 }
@@ -124,8 +189,18 @@ MizFlexLexer::ScanUnknown()
     } else {
         ASTToken* token =
           new UnknownToken(line_number_, column_number_, yytext);
-        token_table_->AddToken(token);
+        AddToken(token);
     }
     column_number_ += yyleng;
     return yyleng;
 }
+
+void
+MizFlexLexer::ScanReturn()
+{
+    ++line_number_;
+    column_number_ = 1;
+    if (is_recording_line_states_) {
+        line_states_.push_back(GetLineState());
+    }
+}
@@ -2,8 +2,10 @@
 
 #include <memory>
 #include <stack>
+#include <vector>
 
 #include "ast_type.hpp"
+#include "miz_lexer_line_state.hpp"
 
 namespace mizcore {
 
@@ -12,6 +14,8 @@ class ASTBlock;
 class ASTStatement;
 class SymbolTable;
 class ASTToken;
+class PhaseProfiler;
+class TokenQueue;
 class TokenTable;
 
 class MizFlexLexer : public yyMizFlexLexer
@@ -33,7 +37,41 @@ class MizFlexLexer : public yyMizFlexLexer
         return symbol_table_;
     }
 
+    void SetLineNumber(size_t line_number) { line_number_ = line_number; }
+
+    // The state at the start of the first line, e.g. that recorded by the
+    // previous lexing of the text.
+    MizLexerLineState GetLineState() const;
+    void SetLineState(const MizLexerLineState& line_state);
+    // Record the states at the start of the lines after the first one.
+    void SetRecordingLineStates(bool is_recording_line_states)
+    {
+        is_recording_line_states_ = is_recording_line_states;
+    }
+    const std::vector<MizLexerLineState>& GetLineStates() const
+    {
+        return line_states_;
+    }
+
+    // Publish the scanned tokens to token_queue in batches. The ownership of
+    // the published tokens moves to the receiver.
+    void SetTokenQueue(std::shared_ptr<TokenQueue> token_queue)
+    {
+        token_queue_ = std::move(token_queue);
+    }
+    // Publish the remaining tokens and close the queue.
+    void CloseTokenQueue();
+
+    // Record the phase "build_query_map" at "begin".
+    void SetPhaseProfiler(std::shared_ptr<PhaseProfiler> phase_profiler)
+    {
+        phase_profiler_ = std::move(phase_profiler);
+    }
+
   private:
+    void AddToken(ASTToken* token);
+    void PublishTokens(size_t end_id);
+
     size_t ScanSymbol();
     size_t ScanIdentifier();
     size_t ScanKeyword(KEYWORD_TYPE type);
@@ -41,15 +79,22 @@ class MizFlexLexer : public yyMizFlexLexer
     size_t ScanFileName();
     size_t ScanComment(COMMENT_TYPE token_type);
     size_t ScanUnknown();
+    void ScanReturn();
 
   private:
     std::shared_ptr<SymbolTable> symbol_table_;
     std::shared_ptr<TokenTable> token_table_;
+    std::shared_ptr<TokenQueue> token_queue_;
+    std::shared_ptr<PhaseProfiler> phase_profiler_;
     size_t line_number_ = 1;
     size_t column_number_ = 1;
 
     bool is_in_environ_section_ = false;
     bool is_in_vocabulary_section_ = false;
+    bool is_after_begin_ = false;
+
+    bool is_recording_line_states_ = false;
+    std::vector<MizLexerLineState> line_states_;
 };
 
 } // namespace mizcore
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+#include "ast_token.hpp"
+#include "miz_incremental_lexer.hpp"
+#include "miz_lexer_handler.hpp"
+#include "token_table.hpp"
+
+using mizcore::ASTToken;
+using mizcore::KeywordToken;
+using mizcore::MizIncrementalLexer;
+using mizcore::MizLexerHandler;
+using mizcore::MizLexerLineState;
+using mizcore::SymbolTable;
+using mizcore::TokenTable;
+
+using mizcore::KEYWORD_TYPE;
+using mizcore::TOKEN_TYPE;
+
+namespace {
+
+// The id of the first token at the line of line_index or after.
+size_t
+FindFirstTokenIdOfLine(const TokenTable& token_table, size_t line_index)
+{
+    size_t first = token_table.GetFirstTokenId();
+    size_t last = token_table.GetTokenNum();
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        auto* token = token_table.GetToken(middle);
+        if (static_cast<size_t>(token->GetLineNumber()) <= line_index) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+// "begin" and "environ" change the vocabularies of the symbol table.
+bool
+HasSectionKeyword(const TokenTable& token_table, size_t begin_id, size_t end_id)
+{
+    for (size_t i = begin_id; i < end_id; ++i) {
+        auto* token = token_table.GetToken(i);
+        if (token->GetTokenType() != TOKEN_TYPE::KEYWORD) {
+            continue;
+        }
+        auto keyword_type = static_cast<KeywordToken*>(token)->GetKeywordType();
+        if (keyword_type == KEYWORD_TYPE::BEGIN_ ||
+            keyword_type == KEYWORD_TYPE::ENVIRON) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+MizIncrementalLexer::MizIncrementalLexer(
+  std::shared_ptr<SymbolTable> symbol_table)
+  : symbol_table_(std::move(symbol_table))
+  , token_table_(std::make_shared<TokenTable>())
+  , line_offsets_(1, 0)
+  , line_states_(1)
+{}
+
+void
+MizIncrementalLexer::Lex(std::string_view text)
+{
+    text_ = text;
+    token_table_ =
+      LexLines(text_, 0, text_.size(), 0, MizLexerLineState(), line_states_);
+    CollectLineOffsets(text_, 0, text_.size(), line_offsets_);
+    assert(line_offsets_.size() == line_states_.size());
+
+    edited_token_id_ = 0;
+    removed_token_num_ = 0;
+    inserted_token_num_ = token_table_->GetTokenNum();
+    lexed_line_num_ = CountLines(line_offsets_, text_.size());
+}
+
+bool
+MizIncrementalLexer::Edit(size_t offset,
+                          size_t length,
+                          std::string_view replacement)
+{
+    if (offset > text_.size() || length > text_.size() - offset) {
+        return false;
+    }
+
+    // The edit may join "\r" at the end of the previous line with "\n".
+    size_t line_index = FindLineIndex(offset > 0 ? offset - 1 : 0);
+    while (!IsRestartable(line_states_[line_index])) {
+        if (line_index == 0 || !line_states_[line_index].is_after_begin_) {
+            return false;
+        }
+        --line_index;
+    }
+
+    std::string text = text_;
+    text.replace(offset, length, replacement);
+    size_t edit_end = offset + replacement.size();
+    size_t begin = line_offsets_[line_index];
+
+    // Lex the lines up to the first line start after the edit, and twice as
+    // many lines each time the lexer state has not synchronized with the old
+    // one yet. The new lines [line_index, line_index + new_line_num)
+    // replace the old lines [line_index, old_line_index).
+    std::shared_ptr<TokenTable> token_table;
+    std::vector<MizLexerLineState> line_states;
+    std::vector<size_t> line_offsets;
+    size_t new_line_num = 0;
+    size_t old_line_index = 0;
+    size_t end = begin;
+    for (size_t window_line_num = 1;; window_line_num *= 2) {
+        end = SkipLines(text, edit_end, window_line_num);
+        token_table = LexLines(
+          text, begin, end, line_index, line_states_[line_index], line_states);
+        CollectLineOffsets(text, begin, end, line_offsets);
+        assert(line_offsets.size() == line_states.size());
+
+        new_line_num = line_offsets.size();
+        old_line_index = line_offsets_.size();
+        for (size_t i = 1; i < line_offsets.size(); ++i) {
+            if (line_offsets[i] < edit_end ||
+                line_states[i].is_after_unknown_) {
+                continue;
+            }
+            size_t old_offset = line_offsets[i] - replacement.size() + length;
+            auto it = std::lower_bound(
+              line_offsets_.begin(), line_offsets_.end(), old_offset);
+            if (it == line_offsets_.end() || *it != old_offset) {
+                continue;
+            }
+            size_t k = it - line_offsets_.begin();
+            if (line_states[i] == line_states_[k]) {
+                new_line_num = i;
+                old_line_index = k;
+                break;
+            }
+        }
+        if (old_line_index < line_offsets_.size() || end == text.size()) {
+            break;
+        }
+    }
+
+    size_t first_token_id = FindFirstTokenIdOfLine(*token_table_, line_index);
+    size_t end_token_id = FindFirstTokenIdOfLine(*token_table_, old_line_index);
+    size_t new_token_num =
+      FindFirstTokenIdOfLine(*token_table, line_index + new_line_num);
+    if (HasSectionKeyword(*token_table_, first_token_id, end_token_id) ||
+        HasSectionKeyword(*token_table, 0, new_token_num)) {
+        return false;
+    }
+
+    // The following tokens start at the start of a line, so that only their
+    // line numbers change.
+    size_t new_line_index = line_index + new_line_num;
+    if (new_line_index != old_line_index) {
+        for (size_t i = end_token_id; i < token_table_->GetTokenNum(); ++i) {
+            auto* token = token_table_->GetToken(i);
+            size_t line_number = token->GetLineNumber();
+            token->SetLineNumber(line_number + new_line_index - old_line_index);
+        }
+    }
+    std::vector<ASTToken*> tokens;
+    token_table->DetachTokens(new_token_num, tokens);
+    token_table_->SpliceTokens(first_token_id, end_token_id, tokens);
+
+    for (size_t i = old_line_index; i < line_offsets_.size(); ++i) {
+        line_offsets_[i] += replacement.size() - length;
+    }
+    line_offsets_.erase(line_offsets_.begin() + line_index,
+                        line_offsets_.begin() + old_line_index);
+    line_offsets_.insert(line_offsets_.begin() + line_index,
+                         line_offsets.begin(),
+                         line_offsets.begin() + new_line_num);
+    line_states_.erase(line_states_.begin() + line_index,
+                       line_states_.begin() + old_line_index);
+    line_states_.insert(line_states_.begin() + line_index,
+                        line_states.begin(),
+                        line_states.begin() + new_line_num);
+    text_ = std::move(text);
+
+    edited_token_id_ = first_token_id;
+    removed_token_num_ = end_token_id - first_token_id;
+    inserted_token_num_ = new_token_num;
+    lexed_line_num_ = CountLines(line_offsets, end);
+    return true;
+}
+
+std::shared_ptr<TokenTable>
+MizIncrementalLexer::LexLines(
+  std::string_view text,
+  size_t begin,
+  size_t end,
+  size_t line_index,
+  const MizLexerLineState& line_state,
+  std::vector<MizLexerLineState>& line_states) const
+{
+    std::istringstream iss(std::string(text.substr(begin, end - begin)));
+    MizLexerHandler miz_handler(&iss, symbol_table_);
+    miz_handler.SetLineNumber(line_index + 1);
+    miz_handler.SetLineState(line_state);
+    miz_handler.SetRecordingLineStates(true);
+    miz_handler.yylex();
+
+    const auto& handler_line_states = miz_handler.GetLineStates();
+    line_states.clear();
+    line_states.reserve(handler_line_states.size() + 1);
+    line_states.push_back(line_state);
+    line_states.insert(line_states.end(),
+                       handler_line_states.begin(),
+                       handler_line_states.end());
+    return miz_handler.GetTokenTable();
+}
+
+size_t
+MizIncrementalLexer::FindLineIndex(size_t offset) const
+{
+    auto it =
+      std::upper_bound(line_offsets_.begin(), line_offsets_.end(), offset);
+    return it - line_offsets_.begin() - 1;
+}
+
+void
+MizIncrementalLexer::CollectLineOffsets(std::string_view text,
+                                        size_t begin,
+                                        size_t end,
+                                        std::vector<size_t>& line_offsets)
+{
+    // "\r\n", "\r" and "\n" are line breaks as in the lexer.
+    line_offsets.clear();
+    line_offsets.push_back(begin);
+    size_t pos = begin;
+    while (pos < end) {
+        size_t next = text.find_first_of("\r\n", pos);
+        if (next == std::string_view::npos || next >= end) {
+            break;
+        }
+        if (text[next] == '\r' && next + 1 < end && text[next + 1] == '\n') {
+            ++next;
+        }
+        pos = next + 1;
+        line_offsets.push_back(pos);
+    }
+}
+
+size_t
+MizIncrementalLexer::CountLines(const std::vector<size_t>& line_offsets,
+                                size_t end)
+{
+    // The last line start may be the end, where no line is lexed.
+    return line_offsets.size() - (line_offsets.back() == end ? 1 : 0);
+}
+
+size_t
+MizIncrementalLexer::SkipLines(std::string_view text, size_t pos, size_t num)
+{
+    for (size_t i = 0; i < num; ++i) {
+        size_t next = text.find_first_of("\r\n", pos);
+        if (next == std::string_view::npos) {
+            return text.size();
+        }
+        if (text[next] == '\r' && next + 1 < text.size() &&
+            text[next + 1] == '\n') {
+            ++next;
+        }
+        pos = next + 1;
+    }
+    return pos;
+}
+
+bool
+MizIncrementalLexer::IsRestartable(const MizLexerLineState& line_state)
+{
+    return line_state.is_after_begin_ && !line_state.is_in_environ_section_ &&
+           !line_state.is_after_unknown_;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "miz_lexer_line_state.hpp"
+
+namespace mizcore {
+
+class SymbolTable;
+class TokenTable;
+
+// Lexes an article and keeps its tokens up to date with the edits of the text.
+// The state of the lexer is recorded at the start of every line. An edit is
+// lexed again from the start of the line before it, and as soon as a line
+// start after the edit has the same state as the corresponding one of the old
+// text, the old tokens from there on are kept with their line numbers shifted.
+// The tokens are the same as those of MizLexerHandler for the edited text.
+class MizIncrementalLexer
+{
+  public:
+    explicit MizIncrementalLexer(std::shared_ptr<SymbolTable> symbol_table);
+    virtual ~MizIncrementalLexer() = default;
+
+    MizIncrementalLexer(const MizIncrementalLexer&) = delete;
+    MizIncrementalLexer(MizIncrementalLexer&&) = delete;
+    MizIncrementalLexer& operator=(const MizIncrementalLexer&) = delete;
+    MizIncrementalLexer& operator=(MizIncrementalLexer&&) = delete;
+
+    // Lexes the whole text.
+    void Lex(std::string_view text);
+    // Replaces [offset, offset + length) of the text with replacement, and
+    // updates the tokens of the table in place. Returns false, leaving the
+    // text and the tokens as they are, if the range is out of the text or the
+    // edit may change the vocabularies: the edit is not after "begin", or the
+    // lines lexed again have "begin" or "environ". Then the edited text must
+    // be lexed with a new symbol table, since this one may have been changed.
+    bool Edit(size_t offset, size_t length, std::string_view replacement);
+
+    std::shared_ptr<TokenTable> GetTokenTable() const { return token_table_; }
+    const std::string& GetText() const { return text_; }
+    size_t GetLineNum() const { return line_offsets_.size(); }
+
+    // The tokens [GetEditedTokenId(), GetEditedTokenId() +
+    // GetRemovedTokenNum()) of the table before the last Edit() have been
+    // replaced with GetInsertedTokenNum() tokens.
+    size_t GetEditedTokenId() const { return edited_token_id_; }
+    size_t GetRemovedTokenNum() const { return removed_token_num_; }
+    size_t GetInsertedTokenNum() const { return inserted_token_num_; }
+    // The number of the lines lexed by the last Lex() or Edit().
+    size_t GetLexedLineNum() const { return lexed_line_num_; }
+
+  private:
+    std::shared_ptr<TokenTable> LexLines(
+      std::string_view text,
+      size_t begin,
+      size_t end,
+      size_t line_index,
+      const MizLexerLineState& line_state,
+      std::vector<MizLexerLineState>& line_states) const;
+    size_t FindLineIndex(size_t offset) const;
+    static void CollectLineOffsets(std::string_view text,
+                                   size_t begin,
+                                   size_t end,
+                                   std::vector<size_t>& line_offsets);
+    static size_t CountLines(const std::vector<size_t>& line_offsets,
+                             size_t end);
+    static size_t SkipLines(std::string_view text, size_t pos, size_t num);
+    static bool IsRestartable(const MizLexerLineState& line_state);
+
+    std::shared_ptr<SymbolTable> symbol_table_;
+    std::shared_ptr<TokenTable> token_table_;
+    std::string text_;
+    // The offset in text_ and the lexer state of the start of each line.
+    std::vector<size_t> line_offsets_;
+    std::vector<MizLexerLineState> line_states_;
+
+    size_t edited_token_id_ = 0;
+    size_t removed_token_num_ = 0;
+    size_t inserted_token_num_ = 0;
+    size_t lexed_line_num_ = 0;
+};
+
+} // namespace mizcore
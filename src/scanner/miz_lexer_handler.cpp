@@ -10,7 +10,10 @@
 
 using mizcore::MizFlexLexer;
 using mizcore::MizLexerHandler;
+using mizcore::MizLexerLineState;
+using mizcore::PhaseProfiler;
 using mizcore::SymbolTable;
+using mizcore::TokenQueue;
 using mizcore::TokenTable;
 
 MizLexerHandler::MizLexerHandler(
@@ -29,7 +32,46 @@ MizLexerHandler::yylex()
         auto symbol_table = miz_flex_lexer_->GetSymbolTable();
         symbol_table->BuildQueryMap();
     }
-    return miz_flex_lexer_->yylex();
+    int result = miz_flex_lexer_->yylex();
+    miz_flex_lexer_->CloseTokenQueue();
+    return result;
+}
+
+void
+MizLexerHandler::SetLineNumber(size_t line_number)
+{
+    miz_flex_lexer_->SetLineNumber(line_number);
+}
+
+void
+MizLexerHandler::SetLineState(const MizLexerLineState& line_state)
+{
+    miz_flex_lexer_->SetLineState(line_state);
+}
+
+void
+MizLexerHandler::SetRecordingLineStates(bool is_recording_line_states)
+{
+    miz_flex_lexer_->SetRecordingLineStates(is_recording_line_states);
+}
+
+const std::vector<MizLexerLineState>&
+MizLexerHandler::GetLineStates() const
+{
+    return miz_flex_lexer_->GetLineStates();
+}
+
+void
+MizLexerHandler::SetTokenQueue(std::shared_ptr<TokenQueue> token_queue)
+{
+    miz_flex_lexer_->SetTokenQueue(std::move(token_queue));
+}
+
+void
+MizLexerHandler::SetPhaseProfiler(
+  std::shared_ptr<PhaseProfiler> phase_profiler)
+{
+    miz_flex_lexer_->SetPhaseProfiler(std::move(phase_profiler));
 }
 
 std::shared_ptr<TokenTable>
@@ -2,10 +2,15 @@
 
 #include <fstream>
 #include <memory>
+#include <vector>
+
+#include "miz_lexer_line_state.hpp"
 
 namespace mizcore {
 
+class PhaseProfiler;
 class SymbolTable;
+class TokenQueue;
 class TokenTable;
 class MizFlexLexer;
 
@@ -30,6 +35,23 @@ class MizLexerHandler
         is_partial_mode_ = is_partial_mode;
     }
 
+    // The line number of the first line of the input.
+    void SetLineNumber(size_t line_number);
+    // The state of the lexer at the start of the first line of the input.
+    void SetLineState(const MizLexerLineState& line_state);
+
+    // Record the states at the start of the lines after the first one, from
+    // which the lexing can restart (see MizIncrementalLexer).
+    void SetRecordingLineStates(bool is_recording_line_states);
+    const std::vector<MizLexerLineState>& GetLineStates() const;
+
+    // Publish the tokens to token_queue while scanning instead of keeping them
+    // in the token table. The queue is closed when yylex() returns.
+    void SetTokenQueue(std::shared_ptr<TokenQueue> token_queue);
+
+    // Record the phase "build_query_map" at "begin".
+    void SetPhaseProfiler(std::shared_ptr<PhaseProfiler> phase_profiler);
+
   private:
     std::shared_ptr<MizFlexLexer> miz_flex_lexer_;
     bool is_partial_mode_ = false;
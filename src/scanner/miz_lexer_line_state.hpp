@@ -0,0 +1,31 @@
+#pragma once
+
+namespace mizcore {
+
+// The state of MizFlexLexer at the start of a line. The lexing of the text
+// from the line on restarts in this state, unless the line continues an
+// unknown token.
+struct MizLexerLineState
+{
+    bool is_in_environ_section_ = false;
+    bool is_in_vocabulary_section_ = false;
+    // "begin" has built the query map of the symbol table.
+    bool is_after_begin_ = false;
+    // The last token is unknown, which an unknown text at the start of the
+    // line extends.
+    bool is_after_unknown_ = false;
+
+    bool operator==(const MizLexerLineState& rhs) const
+    {
+        return is_in_environ_section_ == rhs.is_in_environ_section_ &&
+               is_in_vocabulary_section_ == rhs.is_in_vocabulary_section_ &&
+               is_after_begin_ == rhs.is_after_begin_ &&
+               is_after_unknown_ == rhs.is_after_unknown_;
+    }
+    bool operator!=(const MizLexerLineState& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+} // namespace mizcore
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <sstream>
+
+#include "ast_token.hpp"
+#include "char_class.hpp"
+#include "miz_lexer_handler.hpp"
+#include "miz_parallel_lexer_handler.hpp"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "token_table.hpp"
+
+using mizcore::ASTToken;
+using mizcore::KeywordToken;
+using mizcore::MizLexerHandler;
+using mizcore::MizParallelLexerHandler;
+using mizcore::SymbolTable;
+using mizcore::ThreadPool;
+using mizcore::TokenTable;
+
+using mizcore::KEYWORD_TYPE;
+using mizcore::TOKEN_TYPE;
+
+namespace {
+
+// Chunks smaller than this are not worth a task.
+constexpr size_t MIN_CHUNK_SIZE = 16 * 1024;
+
+constexpr std::array<std::string_view, 6> SPLIT_KEYWORDS = {
+    "theorem", "definition", "registration", "notation", "scheme", "reserve",
+};
+
+bool
+StartsWithKeyword(std::string_view text, size_t pos, std::string_view keyword)
+{
+    if (text.compare(pos, keyword.size(), keyword) != 0) {
+        return false;
+    }
+    size_t end = pos + keyword.size();
+    return end == text.size() || !mizcore::IsIdentifierChar(text[end]);
+}
+
+bool
+ContainsKeyword(std::string_view text, size_t pos, std::string_view keyword)
+{
+    while (pos < text.size()) {
+        size_t line_end = text.find_first_of("\r\n", pos);
+        if (line_end == std::string_view::npos) {
+            line_end = text.size();
+        }
+        // A comment runs from "::" to the end of the line.
+        std::string_view line = text.substr(pos, line_end - pos);
+        line = line.substr(0, line.find("::"));
+        for (size_t i = line.find(keyword); i != std::string_view::npos;
+             i = line.find(keyword, i + 1)) {
+            if ((i == 0 || !mizcore::IsIdentifierChar(line[i - 1])) &&
+                StartsWithKeyword(line, i, keyword)) {
+                return true;
+            }
+        }
+        pos = line_end + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+MizParallelLexerHandler::MizParallelLexerHandler(
+  std::istream* in,
+  const std::shared_ptr<SymbolTable>& symbol_table,
+  std::shared_ptr<ThreadPool> thread_pool)
+  : in_(in)
+  , symbol_table_(symbol_table)
+  , thread_pool_(std::move(thread_pool))
+{}
+
+int
+MizParallelLexerHandler::yylex()
+{
+    text_.assign(std::istreambuf_iterator<char>(*in_),
+                 std::istreambuf_iterator<char>());
+    SplitText();
+
+    // The first chunk includes the environ and "begin", and must be lexed
+    // before the others since it builds the query map of the symbol table.
+    token_table_ = LexChunk(chunks_.front());
+    if (chunks_.size() > 1 && !IsSerialPrefix(*token_table_)) {
+        chunks_[1].end_ = chunks_.back().end_;
+        chunks_.resize(2);
+    }
+
+    std::vector<std::shared_ptr<TokenTable>> token_tables(chunks_.size());
+    thread_pool_->ParallelFor(chunks_.size() - 1,
+                              [this, &token_tables](size_t i) {
+                                  token_tables[i + 1] = LexChunk(chunks_[i + 1]);
+                              });
+
+    // Stitch the tokens, which renumbers their ids.
+    std::vector<ASTToken*> tokens;
+    for (size_t i = 1; i < token_tables.size(); ++i) {
+        tokens.clear();
+        token_tables[i]->DetachTokens(token_tables[i]->GetTokenNum(), tokens);
+        for (auto* token : tokens) {
+            token_table_->AddToken(token);
+        }
+    }
+    return 0;
+}
+
+void
+MizParallelLexerHandler::SplitText()
+{
+    std::string_view text = text_;
+    chunks_.clear();
+    chunks_.push_back({ 0, text.size(), 1 });
+
+    bool is_after_begin = false;
+
+    size_t chunk_size = std::max(
+      MIN_CHUNK_SIZE, text.size() / (thread_pool_->GetThreadNum() * 4));
+    size_t line_number = 1;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        // pos is at the beginning of a line.
+        if (!is_after_begin) {
+            if (StartsWithKeyword(text, pos, "begin")) {
+                is_after_begin = true;
+                // "environ" after "begin" changes the lexer state.
+                if (ContainsKeyword(text, pos, "environ")) {
+                    break;
+                }
+            }
+        } else if (pos - chunks_.back().begin_ >= chunk_size) {
+            bool is_split_point = std::any_of(
+              SPLIT_KEYWORDS.begin(),
+              SPLIT_KEYWORDS.end(),
+              [text, pos](std::string_view keyword) {
+                  return StartsWithKeyword(text, pos, keyword);
+              });
+            if (is_split_point) {
+                chunks_.back().end_ = pos;
+                chunks_.push_back({ pos, text.size(), line_number });
+            }
+        }
+
+        // Move to the next line. "\r\n", "\r" and "\n" are line breaks.
+        size_t next = text.find_first_of("\r\n", pos);
+        if (next == std::string_view::npos) {
+            break;
+        }
+        if (text[next] == '\r' && next + 1 < text.size() &&
+            text[next + 1] == '\n') {
+            ++next;
+        }
+        pos = next + 1;
+        ++line_number;
+    }
+}
+
+std::shared_ptr<TokenTable>
+MizParallelLexerHandler::LexChunk(const Chunk& chunk) const
+{
+    std::istringstream iss(text_.substr(chunk.begin_, chunk.end_ - chunk.begin_));
+    MizLexerHandler miz_handler(&iss, symbol_table_);
+    miz_handler.SetLineNumber(chunk.line_number_);
+    miz_handler.yylex();
+    return miz_handler.GetTokenTable();
+}
+
+bool
+MizParallelLexerHandler::IsSerialPrefix(const TokenTable& token_table)
+{
+    // The lexer has left the environ section by "begin", so the query map has
+    // been built.
+    for (size_t i = token_table.GetTokenNum(); i-- > 0;) {
+        auto* token = token_table.GetToken(i);
+        if (token->GetTokenType() != TOKEN_TYPE::KEYWORD) {
+            continue;
+        }
+        auto keyword_type = static_cast<KeywordToken*>(token)->GetKeywordType();
+        if (keyword_type == KEYWORD_TYPE::BEGIN_) {
+            return true;
+        }
+        if (keyword_type == KEYWORD_TYPE::ENVIRON) {
+            return false;
+        }
+    }
+    return false;
+}
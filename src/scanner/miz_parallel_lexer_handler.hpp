@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mizcore {
+
+class SymbolTable;
+class ThreadPool;
+class TokenTable;
+
+// Lexes an article in parallel.
+// The text before the first top-level item after "begin" is lexed serially,
+// which builds the query map of the symbol table. The rest of the text is
+// split at the top-level keywords at column 1, where the lexer carries no
+// state, and the chunks are lexed concurrently. The tokens are the same as
+// those of MizLexerHandler.
+class MizParallelLexerHandler
+{
+  public:
+    MizParallelLexerHandler(std::istream* in,
+                            const std::shared_ptr<SymbolTable>& symbol_table,
+                            std::shared_ptr<ThreadPool> thread_pool);
+    virtual ~MizParallelLexerHandler() = default;
+
+    MizParallelLexerHandler(const MizParallelLexerHandler&) = delete;
+    MizParallelLexerHandler(MizParallelLexerHandler&&) = delete;
+    MizParallelLexerHandler& operator=(const MizParallelLexerHandler&) = delete;
+    MizParallelLexerHandler& operator=(MizParallelLexerHandler&&) = delete;
+
+    int yylex();
+    std::shared_ptr<TokenTable> GetTokenTable() const { return token_table_; }
+    size_t GetChunkNum() const { return chunks_.size(); }
+
+  private:
+    struct Chunk
+    {
+        size_t begin_ = 0;
+        size_t end_ = 0;
+        size_t line_number_ = 1;
+    };
+
+    void SplitText();
+    std::shared_ptr<TokenTable> LexChunk(const Chunk& chunk) const;
+    static bool IsSerialPrefix(const TokenTable& token_table);
+
+    std::istream* in_;
+    std::shared_ptr<SymbolTable> symbol_table_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+    std::shared_ptr<TokenTable> token_table_;
+    std::string text_;
+    std::vector<Chunk> chunks_;
+};
+
+} // namespace mizcore
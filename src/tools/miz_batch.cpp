@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ast_block.hpp"
+#include "ast_token.hpp"
+#include "error_table.hpp"
+#include "json_writer.hpp"
+#include "miz_controller.hpp"
+#include "nlohmann/json.hpp"
+#include "parse_result_cache.hpp"
+#include "spdlog/spdlog.h"
+#include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "token_table.hpp"
+
+using mizcore::JsonWriter;
+using mizcore::MizController;
+using mizcore::ParseResultCache;
+using mizcore::SymbolTable;
+using mizcore::ThreadPool;
+namespace fs = std::filesystem;
+
+// Batch driver for the whole library.
+// The vocabulary is loaded once and shared by the articles, which are
+// processed on a thread pool. For each article, <name>_tokens.json,
+// <name>_blocks.json and <name>_errors.json are written into the output
+// directory, together with summary.json of all articles. <name> is the stem
+// of the article, to which its index in the inputs is appended if another
+// article has the same stem. With -c, the parse results are restored from
+// CACHE_DIR for the unchanged articles.
+//
+// Usage: miz_batch [-j THREADS] [-o OUTPUT_DIR] [-c CACHE_DIR] VCT_PATH
+//                  INPUT...
+//   INPUT : a .miz/.abs file, a directory searched recursively, or @LIST which
+//           is a file listing one article path per line.
+
+namespace {
+
+struct ArticleResult
+{
+    fs::path path_;
+    std::string name_;
+    bool is_success_ = false;
+    bool is_cached_ = false;
+    double seconds_ = 0.0;
+    size_t token_num_ = 0;
+    size_t error_num_ = 0;
+    std::string failure_;
+};
+
+double
+ElapsedSeconds(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> duration =
+      std::chrono::steady_clock::now() - start;
+    return duration.count();
+}
+
+bool
+IsArticlePath(const fs::path& path)
+{
+    auto extension = path.extension();
+    return extension == ".miz" || extension == ".abs";
+}
+
+void
+CollectArticles(const std::string& input, std::vector<fs::path>& articles)
+{
+    if (!input.empty() && input[0] == '@') {
+        std::ifstream ifs(input.substr(1));
+        if (!ifs) {
+            spdlog::error("Failed to open list file. The specified path: \"{}\"",
+                          input.substr(1));
+            return;
+        }
+        std::string line;
+        while (std::getline(ifs, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                articles.emplace_back(line);
+            }
+        }
+    } else if (fs::is_directory(input)) {
+        std::vector<fs::path> paths;
+        for (const auto& entry : fs::recursive_directory_iterator(input)) {
+            if (entry.is_regular_file() && IsArticlePath(entry.path())) {
+                paths.push_back(entry.path());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        articles.insert(articles.end(), paths.begin(), paths.end());
+    } else {
+        articles.emplace_back(input);
+    }
+}
+
+std::string
+GetArticleName(const fs::path& path)
+{
+    std::string name = path.stem().string();
+    if (path.extension() == ".abs") {
+        name += "_abs";
+    }
+    return name;
+}
+
+// The names of the output files of the articles, which are unique even if
+// the articles in different directories have the same stem.
+std::vector<std::string>
+MakeOutputNames(const std::vector<fs::path>& articles)
+{
+    std::vector<std::string> names;
+    std::map<std::string, size_t> name_nums;
+    for (const auto& article : articles) {
+        names.push_back(GetArticleName(article));
+        ++name_nums[names.back()];
+    }
+    std::set<std::string> used_names;
+    for (const auto& name : names) {
+        if (name_nums[name] == 1) {
+            used_names.insert(name);
+        }
+    }
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (name_nums[names[i]] == 1) {
+            continue;
+        }
+        std::string name = names[i] + "_" + std::to_string(i);
+        while (used_names.count(name) > 0) {
+            name += "_" + std::to_string(i);
+        }
+        used_names.insert(name);
+        names[i] = name;
+    }
+    return names;
+}
+
+// Parses a count of the command line, which must be a decimal number.
+bool
+ParseCount(const std::string& text, size_t& count)
+{
+    if (text.empty() ||
+        !std::all_of(text.begin(), text.end(), [](char c) {
+            return c >= '0' && c <= '9';
+        })) {
+        return false;
+    }
+    try {
+        count = std::stoul(text);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void
+WriteJson(const nlohmann::json& json, const fs::path& path)
+{
+    std::ofstream ofs(path);
+    if (!ofs) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+    ofs << json.dump(4) << std::endl;
+}
+
+// Streams the JSON of a table or the AST without building the DOM, which is
+// the same as dump(4) of ToJson().
+template<class T>
+void
+WriteJson(const T& object, const fs::path& path)
+{
+    std::ofstream ofs(path);
+    if (!ofs) {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
+    {
+        JsonWriter writer(ofs, 4);
+        object.WriteJson(writer);
+    }
+    ofs << std::endl;
+}
+
+void
+ProcessArticle(const std::shared_ptr<const SymbolTable>& vocabulary,
+               const std::shared_ptr<ParseResultCache>& cache,
+               const fs::path& output_dir,
+               ArticleResult& result)
+{
+    if (!fs::is_regular_file(result.path_)) {
+        throw std::runtime_error("No such article");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MizController miz_controller;
+    miz_controller.SetVocabulary(vocabulary);
+    miz_controller.SetResultCache(cache);
+    miz_controller.ExecFile(result.path_.string().c_str(), nullptr);
+    result.seconds_ = ElapsedSeconds(start);
+    result.is_cached_ = miz_controller.IsRestoredFromCache();
+
+    auto token_table = miz_controller.GetTokenTable();
+    auto error_table = miz_controller.GetErrorTable();
+    result.token_num_ = token_table->GetTokenNum();
+    result.error_num_ = error_table->GetErrorNum();
+
+    const std::string& name = result.name_;
+    WriteJson(*token_table, output_dir / (name + "_tokens.json"));
+    WriteJson(*miz_controller.GetASTRoot(),
+              output_dir / (name + "_blocks.json"));
+    WriteJson(*error_table, output_dir / (name + "_errors.json"));
+    result.is_success_ = true;
+}
+
+int
+PrintUsage()
+{
+    std::cerr << "Usage: miz_batch [-j THREADS] [-o OUTPUT_DIR] [-c CACHE_DIR] "
+                 "VCT_PATH INPUT...\n"
+                 "  INPUT : .miz/.abs file, directory, or @LIST file\n";
+    return 1;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    size_t thread_num = 0;
+    fs::path output_dir = "miz_batch_result";
+    std::string cache_dir;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if ((argument == "-j" || argument == "-o" || argument == "-c") &&
+            i + 1 < argc) {
+            if (argument == "-j") {
+                if (!ParseCount(argv[++i], thread_num)) {
+                    return PrintUsage();
+                }
+            } else if (argument == "-o") {
+                output_dir = argv[++i];
+            } else {
+                cache_dir = argv[++i];
+            }
+        } else if (argument == "-h" || argument == "--help") {
+            return PrintUsage();
+        } else {
+            arguments.push_back(argument);
+        }
+    }
+    if (arguments.size() < 2) {
+        return PrintUsage();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const std::string& vctpath = arguments.front();
+    if (!fs::is_regular_file(vctpath)) {
+        spdlog::error("Failed to open vct file. The specified path: \"{}\"",
+                      vctpath);
+        return 1;
+    }
+    std::shared_ptr<const SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.c_str());
+    std::shared_ptr<ParseResultCache> cache;
+    if (!cache_dir.empty()) {
+        cache = std::make_shared<ParseResultCache>(cache_dir, vocabulary);
+    }
+    double vocabulary_seconds = ElapsedSeconds(start);
+
+    std::vector<fs::path> articles;
+    for (size_t i = 1; i < arguments.size(); ++i) {
+        CollectArticles(arguments[i], articles);
+    }
+    auto names = MakeOutputNames(articles);
+    fs::create_directories(output_dir);
+
+    // The articles are assigned to the threads in contiguous ranges, and the
+    // idle threads steal the rest of the ranges.
+    ThreadPool thread_pool(thread_num);
+    std::vector<ArticleResult> results(articles.size());
+    thread_pool.ParallelFor(articles.size(), [&](size_t i) {
+        auto& result = results[i];
+        result.path_ = articles[i];
+        result.name_ = names[i];
+        try {
+            ProcessArticle(vocabulary, cache, output_dir, result);
+        } catch (const std::exception& e) {
+            result.failure_ = e.what();
+            spdlog::error("Failed to process \"{}\": {}",
+                          result.path_.string(),
+                          e.what());
+        }
+    });
+    double wall_seconds = ElapsedSeconds(start);
+
+    nlohmann::json summary;
+    size_t total_token_num = 0;
+    size_t total_error_num = 0;
+    size_t failure_num = 0;
+    double total_article_seconds = 0.0;
+    nlohmann::json& article_jsons = summary["articles"];
+    article_jsons = nlohmann::json::array();
+    for (const auto& result : results) {
+        nlohmann::json article_json = { { "path", result.path_.string() },
+                                        { "name", result.name_ },
+                                        { "success", result.is_success_ },
+                                        { "cached", result.is_cached_ },
+                                        { "seconds", result.seconds_ },
+                                        { "token_num", result.token_num_ },
+                                        { "error_num", result.error_num_ } };
+        if (!result.is_success_) {
+            article_json["failure"] = result.failure_;
+            ++failure_num;
+        }
+        article_jsons.push_back(article_json);
+        total_token_num += result.token_num_;
+        total_error_num += result.error_num_;
+        total_article_seconds += result.seconds_;
+    }
+    summary["thread_num"] = thread_pool.GetThreadNum();
+    summary["article_num"] = results.size();
+    summary["failure_num"] = failure_num;
+    summary["cache_hit_num"] = cache ? cache->GetHitNum() : 0;
+    summary["token_num"] = total_token_num;
+    summary["error_num"] = total_error_num;
+    summary["vocabulary_seconds"] = vocabulary_seconds;
+    summary["article_seconds"] = total_article_seconds;
+    summary["wall_seconds"] = wall_seconds;
+    WriteJson(summary, output_dir / "summary.json");
+
+    spdlog::info("{} articles ({} failed), {} tokens, {} errors in {:.3f} s "
+                 "on {} threads (vocabulary {:.3f} s)",
+                 results.size(),
+                 failure_num,
+                 total_token_num,
+                 total_error_num,
+                 wall_seconds,
+                 thread_pool.GetThreadNum(),
+                 vocabulary_seconds);
+    return failure_num == 0 ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+#include <string>
+
+#include "miz_controller.hpp"
+#include "miz_server.hpp"
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "spdlog/spdlog.h"
+#include "symbol_table.hpp"
+
+using mizcore::MizController;
+using mizcore::MizServer;
+
+// Persistent JSON-RPC server over stdin/stdout (see MizServer).
+//
+// Usage: miz_server VCT_PATH
+
+int
+main(int argc, char* argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: miz_server VCT_PATH\n";
+        return 1;
+    }
+
+    // stdout is reserved for the responses.
+    spdlog::set_default_logger(spdlog::stderr_color_mt("miz_server"));
+
+    std::ios::sync_with_stdio(false);
+    MizServer server(MizController::LoadVocabulary(argv[1]));
+    std::string message;
+    bool has_header = false;
+    while (!server.IsShutdown() &&
+           MizServer::ReadMessage(std::cin, message, has_header)) {
+        std::string response = server.HandleMessage(message);
+        if (!response.empty()) {
+            MizServer::WriteMessage(std::cout, response, has_header);
+        }
+    }
+    return 0;
+}
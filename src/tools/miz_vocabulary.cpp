@@ -0,0 +1,38 @@
+#include <iostream>
+
+#include "miz_controller.hpp"
+#include "symbol_table.hpp"
+#include "vocabulary_image.hpp"
+
+using mizcore::MizController;
+using mizcore::VocabularyImage;
+
+// Writes the vocabulary image of mml.vct (see VocabularyImage). The image is
+// passed to the tools and the bindings in place of VCT_PATH, and the worker
+// processes map it instead of loading the vocabulary each. An IMAGE_PATH
+// under /dev/shm keeps the image in shared memory.
+//
+// Usage: miz_vocabulary VCT_PATH IMAGE_PATH
+
+int
+main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "Usage: miz_vocabulary VCT_PATH IMAGE_PATH\n";
+        return 1;
+    }
+
+    auto vocabulary = MizController::LoadVocabulary(argv[1]);
+    if (!VocabularyImage::WriteFile(*vocabulary, argv[2])) {
+        std::cerr << "Failed to write " << argv[2] << "\n";
+        return 1;
+    }
+    VocabularyImage image;
+    if (!image.Open(argv[2])) {
+        std::cerr << "Failed to map " << argv[2] << "\n";
+        return 1;
+    }
+    std::cout << image.GetFileNum() << " files, " << image.GetSymbolNum()
+              << " symbols\n";
+    return 0;
+}
@@ -1,28 +1,141 @@
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+#include <tuple>
 
 #include "ast_block.hpp"
 #include "ast_token.hpp"
 #include "error_table.hpp"
 #include "miz_block_parser.hpp"
 #include "miz_controller.hpp"
+#include "miz_incremental_lexer.hpp"
 #include "miz_lexer_handler.hpp"
+#include "miz_parallel_lexer_handler.hpp"
+#include "parse_result_cache.hpp"
+#include "parse_result_reader.hpp"
+#include "parse_result_writer.hpp"
+#include "phase_profiler.hpp"
 #include "spdlog/spdlog.h"
 #include "symbol.hpp"
 #include "symbol_table.hpp"
+#include "thread_pool.hpp"
+#include "token_queue.hpp"
 #include "token_table.hpp"
 #include "vct_lexer_handler.hpp"
+#include "vocabulary_image.hpp"
 
+using mizcore::ASTBlock;
+using mizcore::ASTComponent;
+using mizcore::ELEMENT_TYPE;
 using mizcore::ErrorTable;
 using mizcore::MizBlockParser;
 using mizcore::MizController;
+using mizcore::MizIncrementalLexer;
 using mizcore::MizLexerHandler;
+using mizcore::MizParallelLexerHandler;
+using mizcore::ParseResultReader;
+using mizcore::ParseResultWriter;
+using mizcore::PhaseProfiler;
+using mizcore::Symbol;
+using mizcore::SYMBOL_TYPE;
+using mizcore::SymbolTable;
+using mizcore::ThreadPool;
+using mizcore::TokenQueue;
+using mizcore::TokenTable;
 using mizcore::VctLexerHandler;
+using mizcore::VocabularyImage;
 
+namespace {
+
+// Counts the blocks and the statements in the subtree of component.
 void
-MizController::ExecImpl(std::istream& ifs_miz, const char* vctpath)
+CountComponents(const ASTComponent* component,
+                size_t& block_num,
+                size_t& statement_num)
+{
+    if (component->GetElementType() != ELEMENT_TYPE::BLOCK) {
+        ++statement_num;
+        return;
+    }
+    ++block_num;
+    const auto* block = static_cast<const ASTBlock*>(component);
+    for (size_t i = block->GetReleasedChildComponentNum();
+         i < block->GetChildComponentNum();
+         ++i) {
+        CountComponents(block->GetChildComponent(i), block_num, statement_num);
+    }
+}
+
+// Reads a buffer in place, which std::stringbuf would copy.
+class ViewStreamBuf : public std::streambuf
+{
+  public:
+    explicit ViewStreamBuf(std::string_view buffer)
+    {
+        // The get area is never written through.
+        char* begin = const_cast<char*>(buffer.data());
+        setg(begin, begin, begin + buffer.size());
+    }
+};
+
+// Joins the lexer thread of the pipeline when the parsing ends, also by an
+// exception. The lexer may be blocked by the full queue then, so that the
+// tokens not received yet are cancelled. An exception of the lexer, which
+// closes the queue, is rethrown by Join() after the parsing.
+class LexerThreadJoiner
+{
+  public:
+    LexerThreadJoiner(std::thread& lexer_thread,
+                      const std::shared_ptr<TokenQueue>& token_queue,
+                      const std::exception_ptr& lexer_exception)
+      : lexer_thread_(lexer_thread)
+      , token_queue_(token_queue)
+      , lexer_exception_(lexer_exception)
+    {}
+    ~LexerThreadJoiner()
+    {
+        if (lexer_thread_.joinable()) {
+            token_queue_->Cancel();
+            lexer_thread_.join();
+        }
+    }
+
+    void Join()
+    {
+        if (lexer_thread_.joinable()) {
+            lexer_thread_.join();
+        }
+        if (lexer_exception_) {
+            std::rethrow_exception(lexer_exception_);
+        }
+    }
+
+    LexerThreadJoiner(const LexerThreadJoiner&) = delete;
+    LexerThreadJoiner(LexerThreadJoiner&&) = delete;
+    LexerThreadJoiner& operator=(const LexerThreadJoiner&) = delete;
+    LexerThreadJoiner& operator=(LexerThreadJoiner&&) = delete;
+
+  private:
+    std::thread& lexer_thread_;
+    const std::shared_ptr<TokenQueue>& token_queue_;
+    const std::exception_ptr& lexer_exception_;
+};
+
+} // namespace
+
+std::shared_ptr<SymbolTable>
+MizController::LoadVocabulary(const char* vctpath)
 {
+    auto image = std::make_shared<VocabularyImage>();
+    if (vctpath != nullptr && image->Open(vctpath)) {
+        return std::make_shared<SymbolTable>(std::move(image));
+    }
     std::ifstream ifs_vct(vctpath);
     if (!ifs_vct) {
         spdlog::error("Failed to open vct file. The specified path: \"{}\"",
@@ -30,17 +143,164 @@ MizController::ExecImpl(std::istream& ifs_miz, const char* vctpath)
     }
     VctLexerHandler vct_handler(&ifs_vct);
     vct_handler.yylex();
-    symbol_table_ = vct_handler.GetSymbolTable();
+    return vct_handler.GetSymbolTable();
+}
+
+void
+MizController::SetProfilingMode(bool is_profiling_mode)
+{
+    if (!is_profiling_mode) {
+        phase_profiler_.reset();
+    } else if (!phase_profiler_) {
+        phase_profiler_ = std::make_shared<PhaseProfiler>();
+    }
+}
+
+void
+MizController::ExecImpl(std::istream& ifs_miz, const char* vctpath)
+{
+    if (phase_profiler_) {
+        phase_profiler_->Clear();
+    }
+    PhaseProfiler::Scope scope(phase_profiler_.get(), "exec");
+    is_restored_from_cache_ = false;
+    incremental_lexer_.reset();
+    incremental_parser_.reset();
+    if (!result_cache_ || item_callback_ || IsIncrementalMode()) {
+        Parse(ifs_miz, vctpath);
+        scope.SetTokenNum(token_table_->GetTokenNum());
+        return;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(ifs_miz)),
+                     std::istreambuf_iterator<char>());
+    uint64_t key = result_cache_->ComputeKey(text, IsABSMode());
+    {
+        PhaseProfiler::Scope load_scope(phase_profiler_.get(), "load_cache");
+        is_restored_from_cache_ = result_cache_->Load(
+          key, symbol_table_, token_table_, ast_root_, error_table_);
+    }
+    if (is_restored_from_cache_) {
+        symbol_table_->SetUseSymbolAutomaton(IsSymbolAutomatonMode());
+        scope.SetTokenNum(token_table_->GetTokenNum());
+        return;
+    }
+    std::istringstream iss(std::move(text));
+    Parse(iss, vctpath);
+    scope.SetTokenNum(token_table_->GetTokenNum());
+    PhaseProfiler::Scope store_scope(phase_profiler_.get(), "store_cache");
+    result_cache_->Store(
+      key, *symbol_table_, token_table_, ast_root_, error_table_);
+}
+
+void
+MizController::Parse(std::istream& ifs_miz, const char* vctpath)
+{
+    PhaseProfiler::Scope vocabulary_scope(phase_profiler_.get(),
+                                          "load_vocabulary");
+    const auto& vocabulary =
+      result_cache_ ? result_cache_->GetVocabulary() : vocabulary_;
+    if (vocabulary) {
+        symbol_table_ = std::make_shared<SymbolTable>(vocabulary);
+    } else {
+        symbol_table_ = LoadVocabulary(vctpath);
+    }
+    symbol_table_->SetUseSymbolAutomaton(IsSymbolAutomatonMode());
+    vocabulary_scope.End();
+
     MizLexerHandler miz_handler(&ifs_miz, symbol_table_);
-    miz_handler.yylex();
-    token_table_ = miz_handler.GetTokenTable();
+    miz_handler.SetPhaseProfiler(phase_profiler_);
+    std::thread lexer_thread;
+    std::shared_ptr<TokenQueue> token_queue;
+    std::exception_ptr lexer_exception;
+    LexerThreadJoiner lexer_thread_joiner(
+      lexer_thread, token_queue, lexer_exception);
+    if (IsIncrementalMode() && !item_callback_) {
+        // The pipeline mode is ignored, so that ExecEdit() has the lexer.
+        PhaseProfiler::Scope scope(phase_profiler_.get(), "lex");
+        std::string text((std::istreambuf_iterator<char>(ifs_miz)),
+                         std::istreambuf_iterator<char>());
+        incremental_lexer_ =
+          std::make_shared<MizIncrementalLexer>(symbol_table_);
+        incremental_lexer_->Lex(text);
+        token_table_ = incremental_lexer_->GetTokenTable();
+        scope.SetTokenNum(token_table_->GetTokenNum());
+    } else if (IsPipelineMode() || item_callback_) {
+        // The parser adopts the tokens into its own token table. The lexing
+        // overlaps the parsing, and the tokens are counted by the latter.
+        token_queue = std::make_shared<TokenQueue>();
+        miz_handler.SetTokenQueue(token_queue);
+        lexer_thread = std::thread(
+          [this, &miz_handler, &token_queue, &lexer_exception] {
+              PhaseProfiler::Scope scope(phase_profiler_.get(), "lex");
+              try {
+                  miz_handler.yylex();
+              } catch (...) {
+                  // The parser ends with the tokens received so far.
+                  lexer_exception = std::current_exception();
+                  token_queue->Close();
+              }
+          });
+        token_table_ = std::make_shared<TokenTable>();
+    } else if (IsParallelLexMode()) {
+        PhaseProfiler::Scope scope(phase_profiler_.get(), "lex");
+        MizParallelLexerHandler parallel_handler(
+          &ifs_miz, symbol_table_, GetThreadPool());
+        parallel_handler.yylex();
+        token_table_ = parallel_handler.GetTokenTable();
+        scope.SetTokenNum(token_table_->GetTokenNum());
+    } else {
+        PhaseProfiler::Scope scope(phase_profiler_.get(), "lex");
+        miz_handler.yylex();
+        token_table_ = miz_handler.GetTokenTable();
+        scope.SetTokenNum(token_table_->GetTokenNum());
+    }
+
+    ParseTokens(token_queue);
+    lexer_thread_joiner.Join();
+}
+
+void
+MizController::ParseTokens(std::shared_ptr<TokenQueue> token_queue)
+{
+    PhaseProfiler::Scope parse_scope(phase_profiler_.get(), "parse");
     error_table_ = std::make_shared<ErrorTable>();
-    MizBlockParser miz_block_parser(token_table_, error_table_);
+    auto miz_block_parser =
+      std::make_shared<MizBlockParser>(token_table_, error_table_);
     if(IsABSMode()){
-        miz_block_parser.SetABSMode(true);
+        miz_block_parser->SetABSMode(true);
+    }
+    miz_block_parser->SetTokenQueue(std::move(token_queue));
+    miz_block_parser->SetItemCallback(item_callback_);
+    if (IsParallelResolveMode()) {
+        miz_block_parser->SetThreadPool(GetThreadPool());
+    }
+    miz_block_parser->SetPhaseProfiler(phase_profiler_);
+    // The parser is kept for the edits of the tokens.
+    miz_block_parser->SetIncrementalMode(incremental_lexer_ != nullptr);
+    miz_block_parser->Parse();
+    ast_root_ = miz_block_parser->GetASTRoot();
+    incremental_parser_ =
+      incremental_lexer_ ? std::move(miz_block_parser) : nullptr;
+
+    if (phase_profiler_) {
+        // In the streaming mode, only the retained components are counted.
+        size_t block_num = 0;
+        size_t statement_num = 0;
+        CountComponents(ast_root_.get(), block_num, statement_num);
+        parse_scope.SetTokenNum(token_table_->GetTokenNum());
+        parse_scope.SetBlockNum(block_num);
+        parse_scope.SetStatementNum(statement_num);
+    }
+}
+
+std::shared_ptr<ThreadPool>
+MizController::GetThreadPool()
+{
+    if (!thread_pool_) {
+        thread_pool_ = std::make_shared<ThreadPool>();
     }
-    miz_block_parser.Parse();
-    ast_root_ = miz_block_parser.GetASTRoot();
+    return thread_pool_;
 }
 
 void
@@ -63,12 +323,165 @@ MizController::ExecFile(const char* mizpath, const char* vctpath)
 void
 MizController::ExecBuffer(const char* buffer, const char* vctpath)
 {
-    std::string str_text = std::string(buffer);
-    std::stringbuf str_buf(str_text);
-    std::istream ifs_miz(&str_buf);
+    ExecBuffer(std::string_view(buffer), vctpath);
+}
+
+void
+MizController::ExecBuffer(std::string_view buffer, const char* vctpath)
+{
+    ViewStreamBuf view_buf(buffer);
+    std::istream ifs_miz(&view_buf);
     MizController::ExecImpl(ifs_miz, vctpath);
 }
 
+bool
+MizController::ExecEdit(size_t offset,
+                        size_t length,
+                        std::string_view replacement,
+                        const char* vctpath)
+{
+    if (!incremental_lexer_) {
+        return false;
+    }
+    const std::string& text = incremental_lexer_->GetText();
+    if (offset > text.size() || length > text.size() - offset) {
+        return false;
+    }
+
+    if (phase_profiler_) {
+        phase_profiler_->Clear();
+    }
+    bool is_edited = false;
+    {
+        PhaseProfiler::Scope scope(phase_profiler_.get(), "exec");
+        PhaseProfiler::Scope lex_scope(phase_profiler_.get(), "lex");
+        is_edited = incremental_lexer_->Edit(offset, length, replacement);
+        lex_scope.SetTokenNum(incremental_lexer_->GetInsertedTokenNum());
+        lex_scope.End();
+        if (is_edited) {
+            PhaseProfiler::Scope parse_scope(phase_profiler_.get(), "parse");
+            if (incremental_parser_->Reparse(
+                  incremental_lexer_->GetEditedTokenId(),
+                  incremental_lexer_->GetRemovedTokenNum(),
+                  incremental_lexer_->GetInsertedTokenNum())) {
+                parse_scope.SetTokenNum(token_table_->GetTokenNum());
+                scope.SetTokenNum(token_table_->GetTokenNum());
+                return true;
+            }
+        }
+    }
+
+    // The vocabularies may change, or the parser cannot tell the identifiers
+    // typed by the lexer from those it has typed, so that the edited text is
+    // executed again.
+    std::string edited_text = text;
+    if (!is_edited) {
+        edited_text.replace(offset, length, replacement);
+    }
+    ExecBuffer(std::string_view(edited_text), vctpath);
+    return true;
+}
+
+std::vector<std::shared_ptr<MizController>>
+MizController::ExecFiles(const std::vector<std::string>& mizpaths,
+                         const char* vctpath,
+                         size_t thread_num)
+{
+    std::shared_ptr<const SymbolTable> vocabulary = LoadVocabulary(vctpath);
+    std::vector<std::shared_ptr<MizController>> miz_controllers(
+      mizpaths.size());
+    ThreadPool thread_pool(thread_num);
+    thread_pool.ParallelFor(mizpaths.size(), [&](size_t i) {
+        auto miz_controller = std::make_shared<MizController>();
+        miz_controller->SetVocabulary(vocabulary);
+        miz_controller->ExecFile(mizpaths[i].c_str(), vctpath);
+        miz_controllers[i] = std::move(miz_controller);
+    });
+    return miz_controllers;
+}
+
+bool
+MizController::WriteResult(std::string& data) const
+{
+    if (!token_table_ || !ast_root_ || token_table_->GetFirstTokenId() != 0 ||
+        ast_root_->GetReleasedChildComponentNum() != 0) {
+        return false;
+    }
+    ParseResultWriter writer(token_table_, ast_root_, error_table_);
+    writer.SetFileNames(symbol_table_->GetValidFileNames());
+    writer.Write(data);
+    return true;
+}
+
+bool
+MizController::ReadResult(std::string_view data)
+{
+    ParseResultReader reader(data);
+    if (!reader.IsValid()) {
+        return false;
+    }
+
+    std::shared_ptr<SymbolTable> symbol_table;
+    ParseResultReader::SymbolResolver resolver;
+    std::map<std::tuple<std::string, SYMBOL_TYPE, uint8_t>, Symbol*>
+      key2symbol;
+    if (vocabulary_) {
+        // As in ParseResultCache::Load, the query map of the article
+        // reproduces the symbol table at the end of the lexing.
+        symbol_table = std::make_shared<SymbolTable>(vocabulary_);
+        for (auto filename : reader.GetFileNames()) {
+            symbol_table->AddValidFileName(filename);
+        }
+        symbol_table->BuildQueryMap();
+        resolver = [&symbol_table](std::string_view text,
+                                   SYMBOL_TYPE type,
+                                   uint8_t priority) -> Symbol* {
+            Symbol* symbol = symbol_table->QueryLongestMatchSymbol(text);
+            if (symbol == nullptr || symbol->GetText() != text ||
+                symbol->GetType() != type ||
+                symbol->GetPriority() != priority) {
+                return nullptr;
+            }
+            return symbol;
+        };
+    } else {
+        // The special symbols are those of the new table, and the tokens of
+        // any other symbol share one recreated symbol.
+        symbol_table = std::make_shared<SymbolTable>();
+        resolver = [&symbol_table, &key2symbol](std::string_view text,
+                                                SYMBOL_TYPE type,
+                                                uint8_t priority) -> Symbol* {
+            Symbol* special_symbol =
+              symbol_table->QueryLongestMatchSymbol(text);
+            if (special_symbol != nullptr &&
+                special_symbol->GetText() == text &&
+                special_symbol->GetType() == type &&
+                special_symbol->GetPriority() == priority) {
+                return special_symbol;
+            }
+            Symbol*& symbol =
+              key2symbol[std::make_tuple(std::string(text), type, priority)];
+            if (symbol == nullptr) {
+                symbol =
+                  symbol_table->AddSymbol("RESTORED_", text, type, priority);
+            }
+            return symbol;
+        };
+    }
+    if (!reader.Restore(resolver)) {
+        return false;
+    }
+    if (!vocabulary_) {
+        symbol_table->BuildQueryMap();
+    }
+
+    symbol_table_ = symbol_table;
+    token_table_ = reader.GetTokenTable();
+    ast_root_ = reader.GetASTRoot();
+    error_table_ = reader.GetErrorTable();
+    return true;
+}
+
 bool MizController::CheckIsSeparableTokens(const std::vector<ASTToken*>& tokens) const
 {
     std::stringstream ss;
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace mizcore {
 
 class ASTBlock;
+class ASTComponent;
 class ASTToken;
 class SymbolTable;
+class ThreadPool;
+class TokenQueue;
 class TokenTable;
 class ErrorTable;
+class MizBlockParser;
+class MizIncrementalLexer;
+class ParseResultCache;
+class PhaseProfiler;
 
 class MizController
 {
@@ -21,23 +31,153 @@ class MizController
     MizController& operator=(MizController const&) = delete;
     MizController& operator=(MizController&&) = delete;
 
+    // vctpath may also be a vocabulary image written by miz_vocabulary, which
+    // is mapped and shared with the other processes instead of being loaded.
+    // The image is accepted wherever a vct path is.
+    static std::shared_ptr<SymbolTable> LoadVocabulary(const char* vctpath);
+    // Use a fork of the preloaded vocabulary instead of reading vctpath, so
+    // that one vocabulary can be shared by the controllers on many threads.
+    void SetVocabulary(std::shared_ptr<const SymbolTable> vocabulary)
+    {
+        vocabulary_ = std::move(vocabulary);
+    }
+
+    // Restore the results from the cache when the article has been parsed
+    // before, and store them otherwise. The vocabulary of the cache is used
+    // instead of SetVocabulary() and vctpath. Ignored in the streaming mode.
+    void SetResultCache(std::shared_ptr<ParseResultCache> result_cache)
+    {
+        result_cache_ = std::move(result_cache);
+    }
+    bool IsRestoredFromCache() const { return is_restored_from_cache_; }
+
     void ExecImpl(std::istream& ifs_miz, const char* vctpath);
     void ExecFile(const char* mizpath, const char* vctpath);
     void ExecBuffer(const char* buffer, const char* vctpath);
+    // Scans buffer in place without copying it. The tokens own their texts,
+    // so that buffer may be released after the call.
+    void ExecBuffer(std::string_view buffer, const char* vctpath);
+    // Replaces [offset, offset + length) of the text of the last ExecFile()
+    // or ExecBuffer() in the incremental mode with replacement, and parses the
+    // edited text. Only the lines around the edit are lexed again, and only
+    // the top-level items around it are parsed again (see
+    // MizBlockParser::Reparse), unless the edit may change the vocabularies.
+    // Returns false if there is no such text, as in the streaming mode, or the
+    // range is out of it.
+    bool ExecEdit(size_t offset,
+                  size_t length,
+                  std::string_view replacement,
+                  const char* vctpath);
+    // Executes the articles on a ThreadPool of thread_num threads, sharing the
+    // vocabulary loaded from vctpath once. The controllers of the results are
+    // in the order of mizpaths.
+    static std::vector<std::shared_ptr<MizController>> ExecFiles(
+      const std::vector<std::string>& mizpaths,
+      const char* vctpath,
+      size_t thread_num = 0);
+    // Write the results in the format of ParseResultWriter, e.g. to pass them
+    // to another process. Returns false if there are no results, or if they
+    // have been released in the streaming mode.
+    bool WriteResult(std::string& data) const;
+    // Restore the results written by WriteResult(). The symbols are resolved
+    // in a fork of the vocabulary of SetVocabulary(), or without it, are
+    // recreated in a symbol table of their own. Returns false if the data is
+    // invalid or a symbol cannot be resolved.
+    bool ReadResult(std::string_view data);
     std::shared_ptr<TokenTable> GetTokenTable() const { return token_table_; }
     std::shared_ptr<ASTBlock> GetASTRoot() const { return ast_root_; }
     std::shared_ptr<ErrorTable> GetErrorTable() const { return error_table_; }
     bool IsABSMode() const { return is_abs_mode_; }
     void SetABSMode(bool is_abs_mode) { is_abs_mode_ = is_abs_mode; }
+    bool IsSymbolAutomatonMode() const { return is_symbol_automaton_mode_; }
+    void SetSymbolAutomatonMode(bool is_symbol_automaton_mode)
+    {
+        is_symbol_automaton_mode_ = is_symbol_automaton_mode;
+    }
+    // Run the lexer on another thread and parse the tokens as they arrive.
+    // Ignored in the incremental mode.
+    bool IsPipelineMode() const { return is_pipeline_mode_; }
+    void SetPipelineMode(bool is_pipeline_mode)
+    {
+        is_pipeline_mode_ = is_pipeline_mode;
+    }
+    // Lex the text after "begin" in parallel chunks (see
+    // MizParallelLexerHandler). Ignored in the pipeline and streaming modes.
+    bool IsParallelLexMode() const { return is_parallel_lex_mode_; }
+    void SetParallelLexMode(bool is_parallel_lex_mode)
+    {
+        is_parallel_lex_mode_ = is_parallel_lex_mode;
+    }
+    // Resolve the identifiers of the top-level items in parallel (see
+    // MizBlockParser::SetThreadPool).
+    bool IsParallelResolveMode() const { return is_parallel_resolve_mode_; }
+    void SetParallelResolveMode(bool is_parallel_resolve_mode)
+    {
+        is_parallel_resolve_mode_ = is_parallel_resolve_mode;
+    }
+    // Incremental mode: keep the text and the lexer states of the article for
+    // ExecEdit() (see MizIncrementalLexer). Ignored in the streaming mode, and
+    // the result cache, the pipeline mode and the parallel lex mode are
+    // ignored in this mode.
+    bool IsIncrementalMode() const { return is_incremental_mode_; }
+    void SetIncrementalMode(bool is_incremental_mode)
+    {
+        is_incremental_mode_ = is_incremental_mode;
+    }
+    // The pool is created on first use if not set.
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool)
+    {
+        thread_pool_ = std::move(thread_pool);
+    }
+    std::shared_ptr<ThreadPool> GetThreadPool();
+
+    // Record the phases of each Exec*() call (see PhaseProfiler), which are
+    // cleared at its start. The profiler is nullptr unless in this mode.
+    bool IsProfilingMode() const { return phase_profiler_ != nullptr; }
+    void SetProfilingMode(bool is_profiling_mode);
+    std::shared_ptr<PhaseProfiler> GetPhaseProfiler() const
+    {
+        return phase_profiler_;
+    }
+
+    // Streaming mode: each completed top-level item is passed to
+    // item_callback and released afterwards (see
+    // MizBlockParser::SetItemCallback). The lexer runs in the pipeline mode so
+    // that the whole token table never exists in memory.
+    using ItemCallback =
+      std::function<void(const std::vector<ASTComponent*>& components,
+                         const std::vector<ASTToken*>& tokens)>;
+    void SetItemCallback(ItemCallback item_callback)
+    {
+        item_callback_ = std::move(item_callback);
+    }
 
     bool CheckIsSeparableTokens(const std::vector<ASTToken*>& tokens) const;
 
   private:
+    void Parse(std::istream& ifs_miz, const char* vctpath);
+    // Parses token_table_, whose tokens may still be arriving from
+    // token_queue.
+    void ParseTokens(std::shared_ptr<TokenQueue> token_queue);
+
+    std::shared_ptr<const SymbolTable> vocabulary_;
+    std::shared_ptr<ParseResultCache> result_cache_;
+    bool is_restored_from_cache_ = false;
     std::shared_ptr<SymbolTable> symbol_table_;
     std::shared_ptr<TokenTable> token_table_;
     std::shared_ptr<ASTBlock> ast_root_;
     std::shared_ptr<ErrorTable> error_table_;
     bool is_abs_mode_ = false;
+    bool is_symbol_automaton_mode_ = false;
+    bool is_pipeline_mode_ = false;
+    bool is_parallel_lex_mode_ = false;
+    bool is_parallel_resolve_mode_ = false;
+    bool is_incremental_mode_ = false;
+    std::shared_ptr<MizIncrementalLexer> incremental_lexer_;
+    std::shared_ptr<MizBlockParser> incremental_parser_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+    std::shared_ptr<PhaseProfiler> phase_profiler_;
+    ItemCallback item_callback_;
 };
 
 } // namespace mizcore
@@ -0,0 +1,285 @@
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "ast_block.hpp"
+#include "error_table.hpp"
+#include "json_writer.hpp"
+#include "miz_controller.hpp"
+#include "miz_server.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+
+using mizcore::JsonWriter;
+using mizcore::MizController;
+using mizcore::MizServer;
+using mizcore::SymbolTable;
+
+namespace {
+
+// JSON-RPC 2.0 error codes
+constexpr int PARSE_ERROR = -32700;
+constexpr int INVALID_REQUEST = -32600;
+constexpr int METHOD_NOT_FOUND = -32601;
+constexpr int INVALID_PARAMS = -32602;
+constexpr int INTERNAL_ERROR = -32603;
+
+struct RpcError
+{
+    int code_;
+    std::string message_;
+};
+
+const std::string&
+GetStringParam(const nlohmann::json& params, const char* name)
+{
+    if (!params.is_object() || !params.contains(name) ||
+        !params[name].is_string()) {
+        throw RpcError{ INVALID_PARAMS,
+                        std::string("Missing string parameter: ") + name };
+    }
+    return params[name].get_ref<const std::string&>();
+}
+
+bool
+IsABSPath(std::string_view uri)
+{
+    std::string_view extension = ".abs";
+    return uri.size() >= extension.size() &&
+           uri.substr(uri.size() - extension.size()) == extension;
+}
+
+// Returns false unless value is a decimal number up to MAX_CONTENT_LENGTH.
+bool
+ParseContentLength(std::string_view value, size_t& length)
+{
+    size_t begin = value.find_first_not_of(" \t");
+    size_t end = value.find_last_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return false;
+    }
+    length = 0;
+    for (char c : value.substr(begin, end + 1 - begin)) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        length = length * 10 + static_cast<size_t>(c - '0');
+        if (length > MizServer::MAX_CONTENT_LENGTH) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+MizServer::MizServer(std::shared_ptr<const SymbolTable> vocabulary)
+  : vocabulary_(std::move(vocabulary))
+{}
+
+MizServer::~MizServer() = default;
+
+std::string
+MizServer::HandleMessage(std::string_view message)
+{
+    nlohmann::json request;
+    try {
+        request = nlohmann::json::parse(message);
+    } catch (const nlohmann::json::parse_error& e) {
+        return MakeErrorResponse(nullptr, PARSE_ERROR, e.what());
+    }
+    if (!request.is_object() || !request.contains("method") ||
+        !request["method"].is_string()) {
+        nlohmann::json id = request.is_object()
+                              ? request.value("id", nlohmann::json())
+                              : nlohmann::json();
+        return MakeErrorResponse(id, INVALID_REQUEST, "Invalid request");
+    }
+
+    bool is_notification = !request.contains("id");
+    nlohmann::json id = request.value("id", nlohmann::json());
+    const auto& method = request["method"].get_ref<const std::string&>();
+    nlohmann::json params = request.value("params", nlohmann::json::object());
+
+    std::string response;
+    try {
+        if (method == "open" || method == "update") {
+            response = MakeResponse(id, Update(params).dump());
+        } else if (method == "close") {
+            documents_.erase(GetStringParam(params, "uri"));
+            response = MakeResponse(id, "null");
+        } else if (method == "tokens" || method == "blocks" ||
+                   method == "errors") {
+            response = MakeResponse(id, Query(method, params));
+        } else if (method == "shutdown") {
+            is_shutdown_ = true;
+            response = MakeResponse(id, "null");
+        } else {
+            throw RpcError{ METHOD_NOT_FOUND, "Method not found: " + method };
+        }
+    } catch (const RpcError& e) {
+        response = MakeErrorResponse(id, e.code_, e.message_);
+    } catch (const std::exception& e) {
+        response = MakeErrorResponse(id, INTERNAL_ERROR, e.what());
+    }
+    return is_notification ? std::string() : response;
+}
+
+bool
+MizServer::ReadMessage(std::istream& in, std::string& message, bool& has_header)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        std::string_view content_length = "Content-Length:";
+        if (line.compare(0, content_length.size(), content_length) != 0) {
+            message = line;
+            has_header = false;
+            return true;
+        }
+
+        has_header = true;
+        size_t length = 0;
+        if (!ParseContentLength(
+              std::string_view(line).substr(content_length.size()), length)) {
+            // The body can not be delimited.
+            message.clear();
+            in.setstate(std::ios::failbit);
+            return true;
+        }
+        // Skip the other headers.
+        while (std::getline(in, line) && line != "\r" && !line.empty()) {
+        }
+        message.resize(length);
+        in.read(message.data(), static_cast<std::streamsize>(length));
+        if (static_cast<size_t>(in.gcount()) != length) {
+            message.clear();
+        }
+        return true;
+    }
+    return false;
+}
+
+void
+MizServer::WriteMessage(std::ostream& out,
+                        std::string_view message,
+                        bool has_header)
+{
+    if (has_header) {
+        out << "Content-Length: " << message.size() << "\r\n\r\n" << message;
+    } else {
+        out << message << '\n';
+    }
+    out.flush();
+}
+
+nlohmann::json
+MizServer::Update(const nlohmann::json& params)
+{
+    const auto& uri = GetStringParam(params, "uri");
+    const auto& text = GetStringParam(params, "text");
+    bool is_abs_mode = params.value("abs", IsABSPath(uri));
+
+    auto it = documents_.find(uri);
+    bool is_reparsed = it == documents_.end() || it->second.text_ != text ||
+                       it->second.is_abs_mode_ != is_abs_mode;
+    if (is_reparsed) {
+        auto controller = std::make_shared<MizController>();
+        controller->SetVocabulary(vocabulary_);
+        controller->SetABSMode(is_abs_mode);
+        controller->ExecBuffer(std::string_view(text), nullptr);
+        ++parse_num_;
+
+        // The document is stored only after it is parsed successfully, so a
+        // failed open leaves no document and a failed update keeps the old
+        // one.
+        it = documents_.try_emplace(uri).first;
+        auto& document = it->second;
+        document.text_ = text;
+        document.is_abs_mode_ = is_abs_mode;
+        document.controller_ = std::move(controller);
+        document.tokens_json_.clear();
+        document.blocks_json_.clear();
+        document.errors_json_.clear();
+    }
+
+    const auto& controller = it->second.controller_;
+    return { { "token_num", controller->GetTokenTable()->GetTokenNum() },
+             { "error_num", controller->GetErrorTable()->GetErrorNum() },
+             { "is_reparsed", is_reparsed } };
+}
+
+const std::string&
+MizServer::Query(const std::string& method, const nlohmann::json& params)
+{
+    auto& document = GetDocument(params);
+    const auto& controller = document.controller_;
+    if (method == "tokens") {
+        if (document.tokens_json_.empty()) {
+            const auto& token_table = controller->GetTokenTable();
+            JsonWriter writer(document.tokens_json_);
+            if (token_table->GetTokenNum() == 0) {
+                writer.BeginArray();
+                writer.EndArray();
+            } else {
+                token_table->WriteJson(writer);
+            }
+        }
+        return document.tokens_json_;
+    }
+    if (method == "blocks") {
+        if (document.blocks_json_.empty()) {
+            JsonWriter writer(document.blocks_json_);
+            controller->GetASTRoot()->WriteJson(writer);
+        }
+        return document.blocks_json_;
+    }
+    if (document.errors_json_.empty()) {
+        JsonWriter writer(document.errors_json_);
+        controller->GetErrorTable()->WriteJson(writer);
+    }
+    return document.errors_json_;
+}
+
+MizServer::Document&
+MizServer::GetDocument(const nlohmann::json& params)
+{
+    const auto& uri = GetStringParam(params, "uri");
+    auto it = documents_.find(uri);
+    if (it == documents_.end()) {
+        throw RpcError{ INVALID_PARAMS, "Unknown document: " + uri };
+    }
+    return it->second;
+}
+
+std::string
+MizServer::MakeResponse(const nlohmann::json& id, std::string_view result)
+{
+    // The cached result is spliced into the response without parsing it.
+    std::string response = R"({"id":)";
+    response += id.dump();
+    response += R"(,"jsonrpc":"2.0","result":)";
+    response += result;
+    response += "}";
+    return response;
+}
+
+std::string
+MizServer::MakeErrorResponse(const nlohmann::json& id,
+                             int code,
+                             std::string_view message)
+{
+    nlohmann::json response = {
+        { "jsonrpc", "2.0" },
+        { "id", id },
+        { "error", { { "code", code }, { "message", std::string(message) } } }
+    };
+    return response.dump();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "nlohmann/json.hpp"
+
+namespace mizcore {
+
+class MizController;
+class SymbolTable;
+
+// JSON-RPC 2.0 server which keeps the vocabulary and the parsed documents in
+// memory. A document is parsed only when its text changes, and the results of
+// the queries are cached until then.
+//
+// Methods:
+//   open/update {uri, text, [abs]} -> {token_num, error_num, is_reparsed}
+//   close {uri} -> null
+//   tokens/blocks/errors {uri} -> the JSON of the token table, the AST or the
+//                                 error table
+//   shutdown -> null
+//
+// A message is either one line of JSON, or a JSON body preceded by a
+// "Content-Length: N" header and an empty line as in the Language Server
+// Protocol.
+class MizServer
+{
+  public:
+    // ctor, dtor
+    explicit MizServer(std::shared_ptr<const SymbolTable> vocabulary);
+    virtual ~MizServer();
+    MizServer(MizServer const&) = delete;
+    MizServer(MizServer&&) = delete;
+    MizServer& operator=(MizServer const&) = delete;
+    MizServer& operator=(MizServer&&) = delete;
+
+    // attributes
+    bool IsShutdown() const { return is_shutdown_; }
+    size_t GetDocumentNum() const { return documents_.size(); }
+    size_t GetParseNum() const { return parse_num_; }
+
+    // operations
+    // Returns the response, or an empty string for a notification.
+    std::string HandleMessage(std::string_view message);
+
+    // Returns false at the end of the input. A body which can not be read is
+    // returned as an empty message, which is answered with a parse error, and
+    // the input ends after it.
+    static bool ReadMessage(std::istream& in,
+                            std::string& message,
+                            bool& has_header);
+    // Frames the response in the same way as the request.
+    static void WriteMessage(std::ostream& out,
+                             std::string_view message,
+                             bool has_header);
+
+    static constexpr size_t MAX_CONTENT_LENGTH = 256 * 1024 * 1024;
+
+  private:
+    struct Document
+    {
+        std::string text_;
+        bool is_abs_mode_ = false;
+        std::shared_ptr<MizController> controller_;
+        std::string tokens_json_;
+        std::string blocks_json_;
+        std::string errors_json_;
+    };
+
+    nlohmann::json Update(const nlohmann::json& params);
+    const std::string& Query(const std::string& method,
+                             const nlohmann::json& params);
+    Document& GetDocument(const nlohmann::json& params);
+
+    static std::string MakeResponse(const nlohmann::json& id,
+                                    std::string_view result);
+    static std::string MakeErrorResponse(const nlohmann::json& id,
+                                         int code,
+                                         std::string_view message);
+
+    std::shared_ptr<const SymbolTable> vocabulary_;
+    std::map<std::string, Document> documents_;
+    size_t parse_num_ = 0;
+    bool is_shutdown_ = false;
+};
+
+} // namespace mizcore
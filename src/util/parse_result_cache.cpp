@@ -0,0 +1,124 @@
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include "fnv_hash.hpp"
+#include "mapped_parse_result.hpp"
+#include "parse_result_cache.hpp"
+#include "parse_result_reader.hpp"
+#include "parse_result_writer.hpp"
+#include "spdlog/spdlog.h"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+
+#ifndef MIZCORE_VERSION
+#define MIZCORE_VERSION "unknown"
+#endif
+
+using mizcore::MappedParseResult;
+using mizcore::ParseResultCache;
+using mizcore::ParseResultReader;
+using mizcore::ParseResultWriter;
+using mizcore::Symbol;
+using mizcore::SYMBOL_TYPE;
+using mizcore::SymbolTable;
+namespace fs = std::filesystem;
+
+ParseResultCache::ParseResultCache(
+  std::string directory,
+  std::shared_ptr<const SymbolTable> vocabulary)
+  : directory_(std::move(directory))
+  , vocabulary_(std::move(vocabulary))
+  , vocabulary_fingerprint_(vocabulary_->ComputeFingerprint())
+{
+    std::error_code error_code;
+    fs::create_directories(directory_, error_code);
+    if (error_code) {
+        spdlog::error("Failed to create cache directory. The specified path: "
+                      "\"{}\"",
+                      directory_);
+    }
+}
+
+std::string
+ParseResultCache::GetPath(uint64_t key) const
+{
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << key << ".mzr";
+    return (fs::path(directory_) / oss.str()).string();
+}
+
+uint64_t
+ParseResultCache::ComputeKey(std::string_view text, bool is_abs_mode) const
+{
+    uint64_t hash = mizcore::Fnv1aHash(MIZCORE_VERSION);
+    hash = mizcore::Fnv1aHash(mizcore::PARSE_RESULT_FORMAT_VERSION, hash);
+    hash = mizcore::Fnv1aHash(vocabulary_fingerprint_, hash);
+    hash = mizcore::Fnv1aHash(is_abs_mode, hash);
+    hash = mizcore::Fnv1aHash(text.size(), hash);
+    return mizcore::Fnv1aHash(text, hash);
+}
+
+bool
+ParseResultCache::Load(uint64_t key,
+                       std::shared_ptr<SymbolTable>& symbol_table,
+                       std::shared_ptr<TokenTable>& token_table,
+                       std::shared_ptr<ASTBlock>& ast_root,
+                       std::shared_ptr<ErrorTable>& error_table)
+{
+    MappedParseResult mapped_result;
+    if (!mapped_result.Open(GetPath(key)) || mapped_result.GetKey() != key) {
+        ++miss_num_;
+        return false;
+    }
+
+    // The symbols are looked up in the query map of the article, which
+    // reproduces the symbol table at the end of the lexing.
+    auto fork = std::make_shared<SymbolTable>(vocabulary_);
+    for (auto filename : mapped_result.GetFileNames()) {
+        fork->AddValidFileName(filename);
+    }
+    fork->BuildQueryMap();
+    auto resolver = [&fork](std::string_view text,
+                            SYMBOL_TYPE type,
+                            uint8_t priority) -> Symbol* {
+        Symbol* symbol = fork->QueryLongestMatchSymbol(text);
+        if (symbol == nullptr || symbol->GetText() != text ||
+            symbol->GetType() != type || symbol->GetPriority() != priority) {
+            return nullptr;
+        }
+        return symbol;
+    };
+    ParseResultReader reader(mapped_result.GetData());
+    if (!reader.Restore(resolver)) {
+        spdlog::warn("Ignored cache file of unknown symbols. The path: \"{}\"",
+                     GetPath(key));
+        ++miss_num_;
+        return false;
+    }
+
+    symbol_table = fork;
+    token_table = reader.GetTokenTable();
+    ast_root = reader.GetASTRoot();
+    error_table = reader.GetErrorTable();
+    ++hit_num_;
+    return true;
+}
+
+bool
+ParseResultCache::Store(uint64_t key,
+                        const SymbolTable& symbol_table,
+                        const std::shared_ptr<TokenTable>& token_table,
+                        const std::shared_ptr<ASTBlock>& ast_root,
+                        const std::shared_ptr<ErrorTable>& error_table) const
+{
+    ParseResultWriter writer(token_table, ast_root, error_table);
+    writer.SetKey(key);
+    writer.SetFileNames(symbol_table.GetValidFileNames());
+    if (!writer.WriteFile(GetPath(key))) {
+        spdlog::warn("Failed to write cache file. The path: \"{}\"",
+                     GetPath(key));
+        return false;
+    }
+    return true;
+}
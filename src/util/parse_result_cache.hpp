@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace mizcore {
+
+class ASTBlock;
+class ErrorTable;
+class SymbolTable;
+class TokenTable;
+
+// On-disk cache of the parse results, keyed by a hash of the article text,
+// the vocabulary, the library version and the format version. Each entry is a
+// file written by ParseResultWriter, so that an unchanged article is restored
+// without lexing and parsing it again. The cache may be shared by the
+// controllers on many threads and by many processes.
+class ParseResultCache
+{
+  public:
+    // ctor, dtor
+    ParseResultCache(std::string directory,
+                     std::shared_ptr<const SymbolTable> vocabulary);
+    virtual ~ParseResultCache() = default;
+    ParseResultCache(ParseResultCache const&) = delete;
+    ParseResultCache(ParseResultCache&&) = delete;
+    ParseResultCache& operator=(ParseResultCache const&) = delete;
+    ParseResultCache& operator=(ParseResultCache&&) = delete;
+
+    // attributes
+    const std::string& GetDirectory() const { return directory_; }
+    const std::shared_ptr<const SymbolTable>& GetVocabulary() const
+    {
+        return vocabulary_;
+    }
+    std::string GetPath(uint64_t key) const;
+    size_t GetHitNum() const { return hit_num_; }
+    size_t GetMissNum() const { return miss_num_; }
+
+    // operations
+    uint64_t ComputeKey(std::string_view text, bool is_abs_mode) const;
+    // Returns false on a miss. symbol_table receives a fork of the vocabulary
+    // which owns nothing but the query map of the article.
+    bool Load(uint64_t key,
+              std::shared_ptr<SymbolTable>& symbol_table,
+              std::shared_ptr<TokenTable>& token_table,
+              std::shared_ptr<ASTBlock>& ast_root,
+              std::shared_ptr<ErrorTable>& error_table);
+    bool Store(uint64_t key,
+               const SymbolTable& symbol_table,
+               const std::shared_ptr<TokenTable>& token_table,
+               const std::shared_ptr<ASTBlock>& ast_root,
+               const std::shared_ptr<ErrorTable>& error_table) const;
+
+  private:
+    std::string directory_;
+    std::shared_ptr<const SymbolTable> vocabulary_;
+    uint64_t vocabulary_fingerprint_;
+    std::atomic<size_t> hit_num_ = 0;
+    std::atomic<size_t> miss_num_ = 0;
+};
+
+} // namespace mizcore
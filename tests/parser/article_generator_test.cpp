@@ -0,0 +1,86 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include "article_generator.hpp"
+#include "ast_block.hpp"
+#include "doctest/doctest.h"
+#include "error_table.hpp"
+#include "miz_block_parser.hpp"
+#include "miz_lexer_handler.hpp"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+#include "vct_lexer_handler.hpp"
+
+using mizcore::ARTICLE_SHAPE;
+using mizcore::ErrorTable;
+using mizcore::MizBlockParser;
+using mizcore::MizLexerHandler;
+using mizcore::SymbolTable;
+using mizcore::VctLexerHandler;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Returns the number of the tokens, and checks that the article is parsed
+// without errors.
+size_t
+check_generated_article(ARTICLE_SHAPE shape,
+                        size_t size,
+                        const std::shared_ptr<SymbolTable>& vocabulary)
+{
+    std::string text = mizcore::GenerateArticle(shape, size);
+    INFO(text);
+
+    auto symbol_table = std::make_shared<SymbolTable>(vocabulary);
+    std::istringstream iss(text);
+    MizLexerHandler miz_handler(&iss, symbol_table);
+    miz_handler.yylex();
+    auto token_table = miz_handler.GetTokenTable();
+    auto error_table = std::make_shared<ErrorTable>();
+
+    MizBlockParser miz_block_parser(token_table, error_table);
+    miz_block_parser.Parse();
+    CHECK(error_table->GetErrorNum() == 0);
+    CHECK(miz_block_parser.GetASTRoot()->GetChildComponentNum() > 0);
+    return token_table->GetTokenNum();
+}
+
+} // namespace
+
+TEST_CASE("generate synthetic articles")
+{
+    std::shared_ptr<SymbolTable> vocabulary;
+    {
+        fs::path mml_vct_path =
+          fs::path(__FILE__).parent_path() / "data" / "mml.vct";
+        std::ifstream ifs(mml_vct_path);
+        CHECK(ifs.good());
+
+        VctLexerHandler vct_handler(&ifs);
+        vct_handler.yylex();
+        vocabulary = vct_handler.GetSymbolTable();
+    }
+
+    for (auto shape : { ARTICLE_SHAPE::MIXED,
+                        ARTICLE_SHAPE::LABELS,
+                        ARTICLE_SHAPE::NESTED_PROOFS,
+                        ARTICLE_SHAPE::SYMBOL_RUNS,
+                        ARTICLE_SHAPE::COMMENTS,
+                        ARTICLE_SHAPE::WHERE_CLAUSES }) {
+        auto shape_text = mizcore::QueryArticleShapeText(shape);
+        INFO(shape_text);
+        CHECK(mizcore::QueryArticleShape(shape_text) == shape);
+
+        size_t small_token_num = check_generated_article(shape, 1, vocabulary);
+        size_t token_num = check_generated_article(shape, 10, vocabulary);
+        size_t large_token_num =
+          check_generated_article(shape, 100, vocabulary);
+        CHECK(small_token_num < token_num);
+        CHECK(token_num < large_token_num);
+    }
+    CHECK(mizcore::QueryArticleShape("no_such_shape") ==
+          ARTICLE_SHAPE::UNKNOWN);
+}
@@ -0,0 +1,157 @@
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "ast_block.hpp"
+#include "ast_query.hpp"
+#include "ast_statement.hpp"
+#include "ast_token.hpp"
+#include "doctest/doctest.h"
+#include "error_table.hpp"
+#include "miz_block_parser.hpp"
+#include "miz_lexer_handler.hpp"
+#include "symbol.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+#include "vct_lexer_handler.hpp"
+
+using mizcore::ASTBlock;
+using mizcore::ASTComponent;
+using mizcore::ASTStatement;
+using mizcore::BLOCK_TYPE;
+using mizcore::ComponentQuery;
+using mizcore::ELEMENT_TYPE;
+using mizcore::ErrorTable;
+using mizcore::IDENTIFIER_TYPE;
+using mizcore::IdentifierToken;
+using mizcore::KEYWORD_TYPE;
+using mizcore::MizBlockParser;
+using mizcore::MizLexerHandler;
+using mizcore::STATEMENT_TYPE;
+using mizcore::SymbolTable;
+using mizcore::TOKEN_TYPE;
+using mizcore::TokenQuery;
+using mizcore::VctLexerHandler;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Collects all the components of the subtree in pre-order.
+void
+collect_all_components(ASTComponent* component,
+                       std::vector<ASTComponent*>& components)
+{
+    components.push_back(component);
+    if (component->GetElementType() == ELEMENT_TYPE::BLOCK) {
+        auto* block = static_cast<ASTBlock*>(component);
+        for (size_t i = 0; i < block->GetChildComponentNum(); ++i) {
+            collect_all_components(block->GetChildComponent(i), components);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("query components and tokens")
+{
+    fs::path data_dir = fs::path(__FILE__).parent_path() / "data";
+    std::shared_ptr<SymbolTable> symbol_table;
+    {
+        std::ifstream ifs(data_dir / "mml.vct");
+        REQUIRE(ifs.good());
+        VctLexerHandler vct_handler(&ifs);
+        vct_handler.yylex();
+        symbol_table = vct_handler.GetSymbolTable();
+    }
+
+    std::ifstream ifs(data_dir / "axioms_mod_ng.miz");
+    REQUIRE(ifs.good());
+    MizLexerHandler miz_handler(&ifs, symbol_table);
+    miz_handler.yylex();
+    auto token_table = miz_handler.GetTokenTable();
+    MizBlockParser miz_block_parser(token_table,
+                                    std::make_shared<ErrorTable>());
+    miz_block_parser.Parse();
+    auto ast_root = miz_block_parser.GetASTRoot();
+
+    std::vector<ASTComponent*> all_components;
+    collect_all_components(ast_root.get(), all_components);
+
+    SUBCASE("all components")
+    {
+        CHECK(mizcore::QueryComponents(ast_root.get(), ComponentQuery()) ==
+              all_components);
+    }
+
+    SUBCASE("theorem statements")
+    {
+        ComponentQuery query;
+        query.element_type_ = ELEMENT_TYPE::STATEMENT;
+        query.statement_type_ = STATEMENT_TYPE::THEOREM;
+        auto components = mizcore::QueryComponents(ast_root.get(), query);
+        std::vector<ASTComponent*> expected_components;
+        for (auto* component : all_components) {
+            if (component->GetElementType() == ELEMENT_TYPE::STATEMENT &&
+                static_cast<ASTStatement*>(component)->GetStatementType() ==
+                  STATEMENT_TYPE::THEOREM) {
+                expected_components.push_back(component);
+            }
+        }
+        CHECK(!components.empty());
+        CHECK(components == expected_components);
+    }
+
+    SUBCASE("proof blocks in a line range")
+    {
+        ComponentQuery query;
+        query.block_type_ = BLOCK_TYPE::PROOF;
+        query.element_type_ = ELEMENT_TYPE::BLOCK;
+        query.first_line_number_ = 50;
+        query.last_line_number_ = 100;
+        auto components = mizcore::QueryComponents(ast_root.get(), query);
+        for (auto* component : components) {
+            auto* block = static_cast<ASTBlock*>(component);
+            CHECK(block->GetBlockType() == BLOCK_TYPE::PROOF);
+            CHECK(block->GetRangeFirstToken()->GetLineNumber() <= 100);
+            CHECK(block->GetRangeLastToken()->GetLineNumber() >= 50);
+        }
+    }
+
+    SUBCASE("label identifiers")
+    {
+        TokenQuery query;
+        query.identifier_type_ = IDENTIFIER_TYPE::LABEL;
+        auto ids = mizcore::QueryTokenIds(*token_table, query);
+        std::vector<uint32_t> expected_ids;
+        for (size_t i = 0; i < token_table->GetTokenNum(); ++i) {
+            auto* token = token_table->GetToken(i);
+            if (token->GetTokenType() == TOKEN_TYPE::IDENTIFIER &&
+                static_cast<IdentifierToken*>(token)->GetIdentifierType() ==
+                  IDENTIFIER_TYPE::LABEL) {
+                expected_ids.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        CHECK(!ids.empty());
+        CHECK(ids == expected_ids);
+    }
+
+    SUBCASE("keywords in a line range")
+    {
+        TokenQuery query;
+        query.keyword_type_ = KEYWORD_TYPE::PROOF;
+        query.first_line_number_ = 50;
+        query.last_line_number_ = 100;
+        auto ids = mizcore::QueryTokenIds(*token_table, query);
+        std::vector<uint32_t> expected_ids;
+        for (size_t i = 0; i < token_table->GetTokenNum(); ++i) {
+            auto* token = token_table->GetToken(i);
+            if (token->GetTokenType() == TOKEN_TYPE::KEYWORD &&
+                token->GetText() == "proof" && token->GetLineNumber() >= 50 &&
+                token->GetLineNumber() <= 100) {
+                expected_ids.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        CHECK(ids == expected_ids);
+    }
+}
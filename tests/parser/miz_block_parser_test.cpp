@@ -2,23 +2,35 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
 
+#include "article_generator.hpp"
 #include "ast_block.hpp"
 #include "ast_token.hpp"
 #include "doctest/doctest.h"
 #include "error_table.hpp"
 #include "file_handling_tools.hpp"
+#include "json_writer.hpp"
 #include "miz_block_parser.hpp"
+#include "miz_incremental_lexer.hpp"
 #include "miz_lexer_handler.hpp"
 #include "symbol.hpp"
 #include "symbol_table.hpp"
+#include "thread_pool.hpp"
 #include "token_table.hpp"
 #include "vct_lexer_handler.hpp"
 
+using mizcore::ARTICLE_SHAPE;
+using mizcore::ASTBlock;
 using mizcore::ErrorTable;
+using mizcore::JsonWriter;
 using mizcore::MizBlockParser;
+using mizcore::MizIncrementalLexer;
 using mizcore::MizLexerHandler;
 using mizcore::SymbolTable;
+using mizcore::ThreadPool;
+using mizcore::TokenColumns;
+using mizcore::TokenTable;
 using mizcore::VctLexerHandler;
 using std::string;
 namespace fs = std::filesystem;
@@ -32,38 +44,58 @@ TEST_DIR()
     return test_dir;
 }
 
+// The streamed JSON must be the same bytes as the dump of the DOM.
+template<class T>
 void
-check_parser_one(const char* article_name,
-                 std::shared_ptr<SymbolTable>& symbol_table,
-                 bool is_abs_mode = false)
+check_streamed_json(const T& object, const nlohmann::json& json)
 {
-    fs::path miz_file_path =
-      TEST_DIR() / "data" / (std::string(article_name) + ".miz");
+    for (int indent : { -1, 4 }) {
+        std::string streamed_json;
+        {
+            JsonWriter writer(streamed_json, indent);
+            object.WriteJson(writer);
+        }
+        CHECK(streamed_json == json.dump(indent));
+    }
+}
 
+// The columns must hold the same values as the tokens.
+void
+check_token_columns(const TokenTable& token_table)
+{
+    TokenColumns columns;
+    token_table.ToColumns(columns);
+    size_t token_num = token_table.GetTokenNum();
+    REQUIRE(columns.ids_.size() == token_num);
+    REQUIRE(columns.ref_ids_.size() == token_num);
+    for (size_t i = 0; i < token_num; ++i) {
+        const auto* token = token_table.GetToken(i);
+        CHECK(columns.ids_[i] == i);
+        CHECK(columns.token_types_[i] ==
+              static_cast<uint8_t>(token->GetTokenType()));
+        CHECK(columns.sub_types_[i] == token->GetSubType());
+        CHECK(static_cast<int>(columns.line_numbers_[i]) ==
+              token->GetLineNumber());
+        CHECK(static_cast<int>(columns.column_numbers_[i]) ==
+              token->GetColumnNumber());
+        CHECK(std::string_view(columns.text_)
+                .substr(columns.offsets_[i], columns.lengths_[i]) ==
+              token->GetText());
+        const auto* ref_token = token->GetRefToken();
+        CHECK(columns.ref_ids_[i] ==
+              (ref_token ? static_cast<int32_t>(ref_token->GetId()) : -1));
+    }
+}
+
+// Compares the tokens and the blocks with the expected ones of the article.
+void
+check_parser_result(const char* article_name,
+                    const std::shared_ptr<TokenTable>& token_table,
+                    const std::shared_ptr<ASTBlock>& ast_root)
+{
     fs::path result_dir = TEST_DIR() / "result";
     fs::path expected_dir = TEST_DIR() / "expected";
 
-    std::ifstream ifs(miz_file_path);
-    MizLexerHandler miz_handler(&ifs, symbol_table);
-    miz_handler.yylex();
-    auto token_table = miz_handler.GetTokenTable();
-    auto error_table = std::make_shared<ErrorTable>();
-
-    MizBlockParser miz_block_parser(token_table, error_table);
-    miz_block_parser.SetABSMode(is_abs_mode);
-
-    // Erapsed time: 0.000168 [s]
-    clock_t start = clock();
-    miz_block_parser.Parse();
-    clock_t duration = clock() - start;
-
-    std::ostringstream oss;
-    oss << "The elapsed time [s] of MizBlockParser for " << article_name
-        << " is: " << static_cast<double>(duration) / CLOCKS_PER_SEC
-        << std::endl;
-    INFO(oss.str());
-    std::cerr << oss.str();
-
     if (!fs::exists(result_dir)) {
         fs::create_directory(result_dir);
     }
@@ -75,6 +107,8 @@ check_parser_one(const char* article_name,
         nlohmann::json json;
         token_table->ToJson(json);
         mizcore::write_json_file(json, result_token_path);
+        check_streamed_json(*token_table, json);
+        check_token_columns(*token_table);
     }
 
     fs::path expected_token_path =
@@ -93,14 +127,13 @@ check_parser_one(const char* article_name,
     }
 
     // block diff
-    auto ast_root = miz_block_parser.GetASTRoot();
-
     fs::path result_block_path =
       result_dir / (std::string(article_name) + "_blocks.json");
     {
         nlohmann::json json;
         ast_root->ToJson(json);
         mizcore::write_json_file(json, result_block_path);
+        check_streamed_json(*ast_root, json);
     }
 
     fs::path expected_block_path =
@@ -119,6 +152,70 @@ check_parser_one(const char* article_name,
     }
 }
 
+// Parses the text with a copy of the vocabulary, and returns the tokens, the
+// blocks and the errors as JSON.
+nlohmann::json
+parse_article_to_json(const std::string& text,
+                      const std::shared_ptr<SymbolTable>& vocabulary,
+                      std::shared_ptr<ThreadPool> thread_pool = nullptr,
+                      size_t* item_num = nullptr)
+{
+    auto symbol_table = std::make_shared<SymbolTable>(vocabulary);
+    std::istringstream iss(text);
+    MizLexerHandler miz_handler(&iss, symbol_table);
+    miz_handler.yylex();
+    auto token_table = miz_handler.GetTokenTable();
+    auto error_table = std::make_shared<ErrorTable>();
+
+    MizBlockParser miz_block_parser(token_table, error_table);
+    miz_block_parser.SetThreadPool(std::move(thread_pool));
+    miz_block_parser.Parse();
+    if (item_num != nullptr) {
+        *item_num = miz_block_parser.GetASTRoot()->GetChildComponentNum();
+    }
+
+    nlohmann::json json;
+    token_table->ToJson(json["tokens"]);
+    miz_block_parser.GetASTRoot()->ToJson(json["blocks"]);
+    error_table->ToJson(json["errors"]);
+    return json;
+}
+
+void
+check_parser_one(const char* article_name,
+                 std::shared_ptr<SymbolTable>& symbol_table,
+                 bool is_abs_mode = false,
+                 std::shared_ptr<ThreadPool> thread_pool = nullptr)
+{
+    fs::path miz_file_path =
+      TEST_DIR() / "data" / (std::string(article_name) + ".miz");
+
+    std::ifstream ifs(miz_file_path);
+    MizLexerHandler miz_handler(&ifs, symbol_table);
+    miz_handler.yylex();
+    auto token_table = miz_handler.GetTokenTable();
+    auto error_table = std::make_shared<ErrorTable>();
+
+    MizBlockParser miz_block_parser(token_table, error_table);
+    miz_block_parser.SetABSMode(is_abs_mode);
+    miz_block_parser.SetThreadPool(thread_pool);
+
+    // Erapsed time: 0.000168 [s]
+    clock_t start = clock();
+    miz_block_parser.Parse();
+    clock_t duration = clock() - start;
+
+    std::ostringstream oss;
+    oss << "The elapsed time [s] of MizBlockParser for " << article_name
+        << " is: " << static_cast<double>(duration) / CLOCKS_PER_SEC
+        << std::endl;
+    INFO(oss.str());
+    std::cerr << oss.str();
+
+    check_parser_result(
+      article_name, token_table, miz_block_parser.GetASTRoot());
+}
+
 } // namespace
 
 TEST_CASE("execute miz file handler")
@@ -154,4 +251,120 @@ TEST_CASE("execute miz file handler")
     SUBCASE("JGRAPH_4.miz") { check_parser_one("jgraph_4", symbol_table); }
 
     SUBCASE("TARSKI_0.miz") { check_parser_one("tarski_0", symbol_table); }
+
+    SUBCASE("JGRAPH_4.miz incrementally")
+    {
+        fs::path miz_file_path = TEST_DIR() / "data" / "jgraph_4.miz";
+        std::ifstream ifs(miz_file_path);
+        std::string text((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+        MizIncrementalLexer miz_lexer(symbol_table);
+        miz_lexer.Lex(text);
+        auto token_table = miz_lexer.GetTokenTable();
+        auto error_table = std::make_shared<ErrorTable>();
+        MizBlockParser miz_block_parser(token_table, error_table);
+        miz_block_parser.SetIncrementalMode(true);
+        miz_block_parser.Parse();
+        size_t item_num = miz_block_parser.GetBuiltItemNum();
+        CHECK(item_num == miz_block_parser.GetResolvedItemNum());
+        size_t error_num = error_table->GetErrorNum();
+
+        // Only the theorem and its proof are built, and the next item is
+        // resolved as well.
+        size_t offset = text.find("\nproof", text.size() / 2) + 1;
+        offset = text.find('\n', offset) + 1;
+        std::string statement = "A0: 1 = 1;\r\n";
+        auto reparse = [&miz_lexer, &miz_block_parser] {
+            return miz_block_parser.Reparse(miz_lexer.GetEditedTokenId(),
+                                            miz_lexer.GetRemovedTokenNum(),
+                                            miz_lexer.GetInsertedTokenNum());
+        };
+        REQUIRE(miz_lexer.Edit(offset, 0, statement));
+        REQUIRE(reparse());
+        CHECK(2 == miz_block_parser.GetBuiltItemNum());
+        CHECK(3 == miz_block_parser.GetResolvedItemNum());
+        REQUIRE(miz_lexer.Edit(offset, statement.size(), ""));
+        REQUIRE(reparse());
+
+        auto ast_root = miz_block_parser.GetASTRoot();
+        CHECK(item_num == ast_root->GetChildComponentNum());
+        CHECK(error_num == error_table->GetErrorNum());
+        check_parser_result("jgraph_4", token_table, ast_root);
+
+        // The results after each edit are the same as those of the edited
+        // text, including the identifier types, the references and the
+        // errors.
+        std::string edited_text = text;
+        auto check_edit = [&](size_t edit_offset,
+                              size_t edit_length,
+                              const std::string& replacement) {
+            INFO(replacement);
+            edited_text.replace(edit_offset, edit_length, replacement);
+            REQUIRE(miz_lexer.Edit(edit_offset, edit_length, replacement));
+            REQUIRE(reparse());
+            nlohmann::json json;
+            token_table->ToJson(json["tokens"]);
+            miz_block_parser.GetASTRoot()->ToJson(json["blocks"]);
+            error_table->ToJson(json["errors"]);
+            CHECK(json == parse_article_to_json(edited_text, symbol_table));
+        };
+
+        // Th1 is referred to by the later theorems.
+        size_t label_offset = text.find("theorem Th1:") + 8;
+        REQUIRE(text.find("A4,A5,Th1;") != std::string::npos);
+        check_edit(label_offset, 3, "Th0");
+        check_edit(label_offset, 3, "Th1");
+        check_edit(label_offset, 4, "");
+        check_edit(label_offset, 0, "Th1:");
+
+        // A root label of the same name between the theorem and the
+        // references shadows it.
+        size_t shadow_offset =
+          text.rfind("\ntheorem", text.find("A4,A5,Th1;")) + 1;
+        std::string shadow = "theorem Th1: 1 = 1;\n";
+        check_edit(shadow_offset, 0, shadow);
+        check_edit(shadow_offset, shadow.size(), "");
+
+        // An unclosed proof nests all the following items, so that the
+        // parser cannot synchronize with the old items.
+        size_t proof_offset = text.find("theorem Th2:");
+        std::string proof = "Lm0: 1 = 1\nproof\n";
+        check_edit(proof_offset, 0, proof);
+        check_edit(proof_offset, proof.size(), "");
+        CHECK(edited_text == text);
+        check_parser_result(
+          "jgraph_4", token_table, miz_block_parser.GetASTRoot());
+    }
+
+    SUBCASE("parallel identifier resolution")
+    {
+        auto thread_pool = std::make_shared<ThreadPool>(4);
+        check_parser_one("abcmiz_0", symbol_table, false, thread_pool);
+        check_parser_one("jgraph_4", symbol_table, false, thread_pool);
+    }
+
+    SUBCASE("parallel identifier resolution of many items")
+    {
+        // The same as the serial resolution, also for the "where" clauses and
+        // the root labels referred to by the following items.
+        std::vector<std::string> texts;
+        {
+            std::ifstream ifs(TEST_DIR() / "data" / "aofa_a00.miz");
+            texts.emplace_back(std::istreambuf_iterator<char>(ifs),
+                               std::istreambuf_iterator<char>());
+        }
+        texts.push_back(mizcore::GenerateArticle(ARTICLE_SHAPE::MIXED, 3000));
+        texts.push_back(
+          mizcore::GenerateArticle(ARTICLE_SHAPE::WHERE_CLAUSES, 200));
+
+        auto thread_pool = std::make_shared<ThreadPool>(4);
+        for (const auto& text : texts) {
+            size_t item_num = 0;
+            auto json =
+              parse_article_to_json(text, symbol_table, nullptr, &item_num);
+            CHECK(item_num > 1);
+            CHECK(json ==
+                  parse_article_to_json(text, symbol_table, thread_pool));
+        }
+    }
 }
@@ -9,6 +9,7 @@
 #include "doctest/doctest.h"
 #include "error_table.hpp"
 #include "file_handling_tools.hpp"
+#include "json_writer.hpp"
 #include "miz_block_parser.hpp"
 #include "miz_lexer_handler.hpp"
 #include "miz_pattern_parser.hpp"
@@ -19,6 +20,7 @@
 #include "vct_lexer_handler.hpp"
 
 using mizcore::ErrorTable;
+using mizcore::JsonWriter;
 using mizcore::MizBlockParser;
 using mizcore::MizLexerHandler;
 using mizcore::MizPatternParser;
@@ -84,6 +86,13 @@ TestPatternParser(const std::string& name,
         nlohmann::json json;
         pattern_table->ToJson(json);
         mizcore::write_json_file(json, result_file_path);
+
+        std::string streamed_json;
+        {
+            JsonWriter writer(streamed_json, 4);
+            pattern_table->WriteJson(writer);
+        }
+        CHECK(streamed_json == json.dump(4));
     }
 
     fs::path expected_file_path =
@@ -1,18 +1,25 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include "ast_token.hpp"
 #include "doctest/doctest.h"
 #include "file_handling_tools.hpp"
+#include "miz_incremental_lexer.hpp"
 #include "miz_lexer_handler.hpp"
+#include "miz_parallel_lexer_handler.hpp"
 #include "symbol.hpp"
 #include "symbol_table.hpp"
+#include "thread_pool.hpp"
 #include "token_table.hpp"
 #include "vct_lexer_handler.hpp"
 
+using mizcore::MizIncrementalLexer;
 using mizcore::MizLexerHandler;
+using mizcore::MizParallelLexerHandler;
 using mizcore::SymbolTable;
+using mizcore::ThreadPool;
 using mizcore::VctLexerHandler;
 using std::string;
 namespace fs = std::filesystem;
@@ -138,4 +145,134 @@ TEST_CASE("execute miz file handler")
             remove(result_file_path.string().c_str());
         }
     }
+
+    SUBCASE("jgraph_4.miz in parallel")
+    {
+        fs::path miz_file_path = TEST_DIR() / "data" / "jgraph_4.miz";
+        std::ifstream ifs(miz_file_path);
+        auto thread_pool = std::make_shared<ThreadPool>(4);
+        MizParallelLexerHandler miz_handler(&ifs, symbol_table, thread_pool);
+
+        clock_t start = clock();
+        miz_handler.yylex();
+        clock_t duration = clock() - start;
+        std::cout << "The elapsed time [s] of MizParallelLexerHandler for "
+                     "jgraph_4.miz is: "
+                  << static_cast<double>(duration) / CLOCKS_PER_SEC
+                  << std::endl;
+
+        CHECK(miz_handler.GetChunkNum() > 1);
+        auto token_table = miz_handler.GetTokenTable();
+        CHECK(186748 == token_table->GetTokenNum());
+
+        if (!fs::exists(TEST_DIR() / "result")) {
+            fs::create_directory(TEST_DIR() / "result");
+        }
+
+        fs::path result_file_path =
+          TEST_DIR() / "result" / "jgraph_4_parallel_tokens.json";
+        {
+            nlohmann::json json;
+            token_table->ToJson(json);
+            mizcore::write_json_file(json, result_file_path);
+        }
+
+        fs::path expected_file_path =
+          TEST_DIR() / "expected" / "jgraph_4_tokens.json";
+
+        auto json_diff =
+          mizcore::json_file_diff(result_file_path, expected_file_path);
+        CHECK(json_diff.empty());
+
+        if (!json_diff.empty()) {
+            fs::path diff_file_path =
+              TEST_DIR() / "result" / "jgraph_4_parallel_tokens_diff.json";
+            mizcore::write_json_file(json_diff, diff_file_path);
+        } else {
+            remove(result_file_path.string().c_str());
+        }
+    }
+
+    SUBCASE("jgraph_4.miz in parallel with environ after begin")
+    {
+        fs::path miz_file_path = TEST_DIR() / "data" / "jgraph_4.miz";
+        std::ifstream ifs(miz_file_path);
+        std::string text((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+        size_t offset = text.find("\ntheorem") + 1;
+        auto thread_pool = std::make_shared<ThreadPool>(4);
+
+        // "environ" in an identifier or a comment is not the keyword.
+        for (std::string_view line :
+             { "reserve environs for set;\n", ":: the environ\n" }) {
+            std::string edited_text = text;
+            edited_text.insert(offset, line);
+            std::istringstream iss(edited_text);
+            MizParallelLexerHandler miz_handler(
+              &iss, symbol_table, thread_pool);
+            miz_handler.yylex();
+            CHECK(miz_handler.GetChunkNum() > 1);
+        }
+
+        // The keyword changes the lexer state, so the text is lexed serially.
+        std::string edited_text = text;
+        edited_text.insert(offset, "environ\n");
+        std::istringstream iss(edited_text);
+        MizParallelLexerHandler miz_handler(&iss, symbol_table, thread_pool);
+        miz_handler.yylex();
+        CHECK(1 == miz_handler.GetChunkNum());
+    }
+
+    SUBCASE("jgraph_4.miz incrementally")
+    {
+        fs::path miz_file_path = TEST_DIR() / "data" / "jgraph_4.miz";
+        std::ifstream ifs(miz_file_path);
+        std::string text((std::istreambuf_iterator<char>(ifs)),
+                         std::istreambuf_iterator<char>());
+        MizIncrementalLexer miz_lexer(symbol_table);
+        miz_lexer.Lex(text);
+
+        // Only the line before the edit and the edited lines are lexed.
+        size_t offset = text.find("\ntheorem", text.size() / 2) + 1;
+        std::string comment = ":: edited\r\n";
+        REQUIRE(miz_lexer.Edit(offset, 0, comment));
+        CHECK(3 == miz_lexer.GetLexedLineNum());
+        CHECK(miz_lexer.GetRemovedTokenNum() + 1 ==
+              miz_lexer.GetInsertedTokenNum());
+        REQUIRE(miz_lexer.Edit(offset, comment.size(), ""));
+        CHECK(miz_lexer.GetText() == text);
+
+        // An edit before "begin" may change the vocabularies.
+        CHECK(!miz_lexer.Edit(0, 0, comment));
+
+        auto token_table = miz_lexer.GetTokenTable();
+        CHECK(186748 == token_table->GetTokenNum());
+
+        if (!fs::exists(TEST_DIR() / "result")) {
+            fs::create_directory(TEST_DIR() / "result");
+        }
+
+        fs::path result_file_path =
+          TEST_DIR() / "result" / "jgraph_4_incremental_tokens.json";
+        {
+            nlohmann::json json;
+            token_table->ToJson(json);
+            mizcore::write_json_file(json, result_file_path);
+        }
+
+        fs::path expected_file_path =
+          TEST_DIR() / "expected" / "jgraph_4_tokens.json";
+
+        auto json_diff =
+          mizcore::json_file_diff(result_file_path, expected_file_path);
+        CHECK(json_diff.empty());
+
+        if (!json_diff.empty()) {
+            fs::path diff_file_path =
+              TEST_DIR() / "result" / "jgraph_4_incremental_tokens_diff.json";
+            mizcore::write_json_file(json_diff, diff_file_path);
+        } else {
+            remove(result_file_path.string().c_str());
+        }
+    }
 }
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -9,19 +10,23 @@
 #include <FlexLexer.h>
 #undef yyFlexLexer
 
+#include "char_class.hpp"
 #include "doctest/doctest.h"
 #include "symbol.hpp"
 #include "symbol_table.hpp"
 #include "vct_lexer_handler.hpp"
+#include "vocabulary_image.hpp"
 
 using std::ifstream;
 using std::string;
 namespace fs = std::filesystem;
 
+using mizcore::CHAR_CLASS;
 using mizcore::Symbol;
 using mizcore::SYMBOL_TYPE;
 using mizcore::SymbolTable;
 using mizcore::VctLexerHandler;
+using mizcore::VocabularyImage;
 
 const fs::path&
 TEST_DATA_DIR()
@@ -110,6 +115,14 @@ TEST_CASE("symbol table test")
         CHECK(symbol);
         CHECK(symbol->GetText() == "lim");
         CHECK(symbol->GetType() == SYMBOL_TYPE('O'));
+
+        // rejected by the filters in front of the query map
+        symbol = table->QueryLongestMatchSymbol("\x80\x81 def");
+        CHECK(!symbol);
+
+        symbol = table->QueryLongestMatchSymbol(
+          "a_very_long_identifier_which_is_longer_than_any_symbol");
+        CHECK(!symbol);
     }
 
     SUBCASE("build query map for a few vocabulary files")
@@ -172,4 +185,175 @@ TEST_CASE("symbol table test")
         CHECK(symbol->GetText() == "&");
         CHECK(symbol->GetType() == SYMBOL_TYPE('S'));
     }
+
+    SUBCASE("build symbol automaton for all symbols")
+    {
+        table->SetUseSymbolAutomaton(true);
+        table->BuildQueryMap();
+        CHECK(table->GetSymbolAutomaton().IsBuilt());
+
+        Symbol* symbol = table->QueryLongestMatchSymbol("||..abc def ghi");
+        CHECK(symbol);
+        CHECK(symbol->GetText() == "||..");
+        CHECK(symbol->GetType() == SYMBOL_TYPE('K'));
+
+        symbol = table->QueryLongestMatchSymbol("lim-infinity");
+        CHECK(symbol);
+        CHECK(symbol->GetText() == "lim");
+
+        // The automaton must agree with the query map.
+        std::vector<string> queries = {
+            "",         ".abc def ghi", "..abc def ghi", "abss def ghi",
+            ",;:abc",   ",||;:abcdef",  "$1,abcdef",     "$10,abcdef",
+            "...||abc", "||abcdef",     "= a",           "& sup I in I;",
+            "(#x#)",    "a_b",          "\x80\x81",      "NATURAL",
+        };
+        std::vector<Symbol*> results;
+        for (const auto& query : queries) {
+            results.push_back(table->QueryLongestMatchSymbol(query));
+        }
+
+        table->SetUseSymbolAutomaton(false);
+        CHECK(!table->GetSymbolAutomaton().IsBuilt());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            CHECK(results[i] == table->QueryLongestMatchSymbol(queries[i]));
+        }
+    }
+
+    SUBCASE("fork a symbol table")
+    {
+        auto fork = std::make_shared<SymbolTable>(table);
+        fork->AddValidFileName("FINSEQ_4");
+        fork->BuildQueryMap();
+
+        // The fork shares the symbols but not the query map.
+        Symbol* symbol = fork->QueryLongestMatchSymbol("||..abc def ghi");
+        CHECK(symbol);
+        CHECK(symbol->GetText() == "||..");
+        CHECK(fork->CollectFileSymbols("FINSEQ_4") ==
+              table->CollectFileSymbols("FINSEQ_4"));
+        CHECK(!fork->QueryLongestMatchSymbol("||abcdef"));
+        CHECK(!table->QueryLongestMatchSymbol("||abcdef"));
+
+        table->BuildQueryMap();
+        symbol = table->QueryLongestMatchSymbol("||abcdef");
+        CHECK(symbol);
+        CHECK(symbol->GetText() == "||");
+    }
+}
+
+TEST_CASE("vocabulary image test")
+{
+    fs::path mml_vct_path = TEST_DATA_DIR() / "mml.vct";
+    ifstream ifs(mml_vct_path.c_str());
+    CHECK(ifs.good());
+    VctLexerHandler handler(&ifs);
+    handler.yylex();
+    std::shared_ptr<SymbolTable> table = handler.GetSymbolTable();
+
+    fs::path image_path = TEST_DATA_DIR().parent_path() / "result" / "mml.mvi";
+    fs::create_directories(image_path.parent_path());
+    REQUIRE(VocabularyImage::WriteFile(*table, image_path.string()));
+    auto image = std::make_shared<VocabularyImage>();
+    REQUIRE(image->Open(image_path.string()));
+    auto image_table = std::make_shared<SymbolTable>(image);
+    CHECK(image->GetFingerprint() == table->ComputeFingerprint());
+    CHECK(image_table->ComputeFingerprint() == table->ComputeFingerprint());
+    CHECK(image_table->CollectSynonyms().size() ==
+          table->CollectSynonyms().size());
+    CHECK(image_table->CollectFileNames() == table->CollectFileNames());
+
+    // The symbols of the image are created once.
+    auto image_symbols = image_table->CollectFileSymbols("FINSEQ_4");
+    auto symbols = table->CollectFileSymbols("FINSEQ_4");
+    REQUIRE(image_symbols.size() == symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        CHECK(image_symbols[i]->GetText() == symbols[i]->GetText());
+        CHECK(image_symbols[i]->GetType() == symbols[i]->GetType());
+    }
+    CHECK(image_symbols == image_table->CollectFileSymbols("FINSEQ_4"));
+
+    // The forks of the image must agree with those of the loaded vocabulary.
+    std::vector<string> queries = {
+        "",         ".abc def ghi", "..abc def ghi", "||..abc def ghi",
+        ",;:abc",   ",||;:abcdef",  "$1,abcdef",     "$10,abcdef",
+        "...||abc", "||abcdef",     "= a",           "& sup I in I;",
+        "(#x#)",    "a_b",          "\x80\x81",      "lim-infinity",
+    };
+    std::vector<std::vector<string>> valid_filenames = {
+        {},
+        { "FINSEQ_4", "COMPLEX1", "INTEGRA9" },
+        { "INTEGRA9", "COMPLEX1", "FINSEQ_4", "NO_SUCH" },
+    };
+    for (const auto& filenames : valid_filenames) {
+        auto fork = std::make_shared<SymbolTable>(table);
+        auto image_fork = std::make_shared<SymbolTable>(image_table);
+        for (const auto& filename : filenames) {
+            fork->AddValidFileName(filename);
+            image_fork->AddValidFileName(filename);
+        }
+        fork->BuildQueryMap();
+        image_fork->BuildQueryMap();
+        for (const auto& query : queries) {
+            INFO(query);
+            Symbol* symbol = fork->QueryLongestMatchSymbol(query);
+            Symbol* image_symbol = image_fork->QueryLongestMatchSymbol(query);
+            REQUIRE((symbol == nullptr) == (image_symbol == nullptr));
+            if (symbol != nullptr) {
+                CHECK(symbol->GetText() == image_symbol->GetText());
+                CHECK(symbol->GetType() == image_symbol->GetType());
+                CHECK(symbol->GetPriority() == image_symbol->GetPriority());
+            }
+        }
+    }
+
+    // Not an image.
+    VocabularyImage invalid_image;
+    CHECK(!invalid_image.Open(mml_vct_path.string()));
+
+    // A symbol of a broken type.
+    string data;
+    VocabularyImage::Write(*table, data);
+    const auto* header =
+      reinterpret_cast<const mizcore::VocabularyImageHeader*>(data.data());
+    size_t type_offset =
+      sizeof(mizcore::VocabularyImageHeader) +
+      header->filename_num_ * sizeof(mizcore::VocabularyFileRecord) +
+      offsetof(mizcore::VocabularySymbolRecord, type_);
+    fs::path broken_path = image_path.parent_path() / "broken.mvi";
+    for (char type : { '-', 'X', '\0' }) {
+        data[type_offset] = type;
+        std::ofstream(broken_path, std::ios::binary) << data;
+        VocabularyImage broken_image;
+        CHECK(!broken_image.Open(broken_path.string()));
+    }
+    fs::remove(broken_path);
+    fs::remove(image_path);
+}
+
+TEST_CASE("character class table test")
+{
+    for (int c = 0; c < 256; ++c) {
+        char x = static_cast<char>(c);
+        bool is_ascii = c < 0x80;
+        CHECK(mizcore::IsAlphaChar(x) == (is_ascii && isalpha(c) != 0));
+        CHECK(mizcore::IsAlnumChar(x) == (is_ascii && isalnum(c) != 0));
+        CHECK(mizcore::IsGraphChar(x) == (is_ascii && isgraph(c) != 0));
+        CHECK(mizcore::IsSpaceChar(x) == (is_ascii && isspace(c) != 0));
+        CHECK(mizcore::IsWordChar(x) ==
+              (is_ascii && (isalnum(c) != 0 || c == '_')));
+        CHECK(mizcore::IsIdentifierChar(x) ==
+              (is_ascii && (isalnum(c) != 0 || c == '_' || c == '\'')));
+    }
+
+    CHECK(mizcore::ScanCharClassRun("", 0, CHAR_CLASS::WORD) == 0);
+    CHECK(mizcore::ScanCharClassRun("abc-def", 0, CHAR_CLASS::WORD) == 3);
+    CHECK(mizcore::ScanCharClassRun("abc-def", 3, CHAR_CLASS::WORD) == 3);
+    CHECK(mizcore::ScanCharClassRun("abc-def", 4, CHAR_CLASS::WORD) == 7);
+    CHECK(mizcore::ScanCharClassRun("a_very_long_identifier1'", 0,
+                                    CHAR_CLASS::WORD) == 23);
+    CHECK(mizcore::ScanCharClassRun("a_very_long_identifier1'", 0,
+                                    CHAR_CLASS::IDENTIFIER) == 24);
+    CHECK(mizcore::ScanCharClassRun("0123456789abcdef ghi", 0,
+                                    CHAR_CLASS::ALNUM) == 16);
 }
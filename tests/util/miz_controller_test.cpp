@@ -1,16 +1,28 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
 
 #include "ast_block.hpp"
+#include "ast_component.hpp"
 #include "ast_token.hpp"
 #include "doctest/doctest.h"
 #include "file_handling_tools.hpp"
+#include "error_table.hpp"
+#include "json_writer.hpp"
 #include "miz_controller.hpp"
+#include "parse_result_cache.hpp"
+#include "phase_profiler.hpp"
+#include "symbol_table.hpp"
+#include "token_queue.hpp"
 #include "token_table.hpp"
 
 
 using mizcore::MizController;
+using mizcore::ASTComponent;
 using mizcore::ASTToken;
 namespace fs = std::filesystem;
 
@@ -23,17 +35,34 @@ TEST_DIR()
     return test_dir;
 }
 
+// Reads text, and then throws as a failing device would.
+class ThrowingStreamBuf : public std::streambuf
+{
+  public:
+    explicit ThrowingStreamBuf(std::string text)
+      : text_(std::move(text))
+    {
+        setg(text_.data(), text_.data(), text_.data() + text_.size());
+    }
+
+  protected:
+    int_type underflow() override
+    {
+        throw std::runtime_error("read error");
+    }
+
+  private:
+    std::string text_;
+};
+
 } // namespace
 
-void test_miz_controller(MizController& miz_controller)
+void test_blocks_json(const nlohmann::json& json)
 {
   if (!fs::exists(TEST_DIR() / "result")) {
         fs::create_directory(TEST_DIR() / "result");
     }
     fs::path result_file_path = TEST_DIR() / "result" / "numerals_blocks.json";
-    nlohmann::json json;
-    auto ast_root = miz_controller.GetASTRoot();
-    ast_root->ToJson(json);
     mizcore::write_json_file(json, result_file_path);
     fs::path expected_file_path =
       TEST_DIR() / "expected" / "numerals_blocks.json";
@@ -52,6 +81,14 @@ void test_miz_controller(MizController& miz_controller)
 
 }
 
+void test_miz_controller(MizController& miz_controller)
+{
+    nlohmann::json json;
+    auto ast_root = miz_controller.GetASTRoot();
+    ast_root->ToJson(json);
+    test_blocks_json(json);
+}
+
 TEST_CASE("test miz_controller ExecFile")
 {
     mizcore::MizController miz_controller;
@@ -75,6 +112,439 @@ TEST_CASE("test miz_controller ExecBuffer")
     test_miz_controller(miz_controller);
 }
 
+TEST_CASE("test miz_controller shared vocabulary")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    std::shared_ptr<const mizcore::SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.string().c_str());
+    for (int i = 0; i < 2; ++i) {
+        mizcore::MizController miz_controller;
+        miz_controller.SetVocabulary(vocabulary);
+        miz_controller.ExecFile(mizpath.string().c_str(), nullptr);
+        test_miz_controller(miz_controller);
+    }
+}
+
+TEST_CASE("test miz_controller ExecFiles")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    std::vector<std::string> mizpaths(5, mizpath.string());
+    auto miz_controllers =
+      MizController::ExecFiles(mizpaths, vctpath.string().c_str(), 3);
+    REQUIRE(miz_controllers.size() == mizpaths.size());
+    for (const auto& miz_controller : miz_controllers) {
+        REQUIRE(miz_controller != nullptr);
+        test_miz_controller(*miz_controller);
+    }
+}
+
+TEST_CASE("test miz_controller result cache")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    auto cache_dir = TEST_DIR() / "result" / "cache";
+    fs::remove_all(cache_dir);
+    auto cache = std::make_shared<mizcore::ParseResultCache>(
+      cache_dir.string(),
+      MizController::LoadVocabulary(vctpath.string().c_str()));
+
+    nlohmann::json tokens_json[2];
+    nlohmann::json errors_json[2];
+    for (int i = 0; i < 2; ++i) {
+        mizcore::MizController miz_controller;
+        miz_controller.SetResultCache(cache);
+        miz_controller.ExecFile(mizpath.string().c_str(), nullptr);
+        CHECK(miz_controller.IsRestoredFromCache() == (i == 1));
+        test_miz_controller(miz_controller);
+        miz_controller.GetTokenTable()->ToJson(tokens_json[i]);
+        miz_controller.GetErrorTable()->ToJson(errors_json[i]);
+    }
+    CHECK(cache->GetMissNum() == 1);
+    CHECK(cache->GetHitNum() == 1);
+    CHECK(tokens_json[0] == tokens_json[1]);
+    CHECK(errors_json[0] == errors_json[1]);
+
+    // A different mode is another entry.
+    mizcore::MizController miz_controller;
+    miz_controller.SetResultCache(cache);
+    miz_controller.SetABSMode(true);
+    miz_controller.ExecFile(mizpath.string().c_str(), nullptr);
+    CHECK(!miz_controller.IsRestoredFromCache());
+    CHECK(cache->GetMissNum() == 2);
+    fs::remove_all(cache_dir);
+}
+
+TEST_CASE("test miz_controller WriteResult and ReadResult")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    std::shared_ptr<const mizcore::SymbolTable> vocabulary =
+      MizController::LoadVocabulary(vctpath.string().c_str());
+    mizcore::MizController miz_controller;
+    CHECK(!miz_controller.ReadResult("no parse result"));
+    std::string data;
+    CHECK(!miz_controller.WriteResult(data));
+    miz_controller.SetVocabulary(vocabulary);
+    miz_controller.ExecFile(mizpath.string().c_str(), nullptr);
+    REQUIRE(miz_controller.WriteResult(data));
+    nlohmann::json tokens_json;
+    nlohmann::json errors_json;
+    miz_controller.GetTokenTable()->ToJson(tokens_json);
+    miz_controller.GetErrorTable()->ToJson(errors_json);
+
+    // With the vocabulary, and with the symbols recreated without it.
+    for (int i = 0; i < 2; ++i) {
+        mizcore::MizController restored_controller;
+        if (i == 0) {
+            restored_controller.SetVocabulary(vocabulary);
+        }
+        REQUIRE(restored_controller.ReadResult(data));
+        test_miz_controller(restored_controller);
+        nlohmann::json restored_tokens_json;
+        nlohmann::json restored_errors_json;
+        restored_controller.GetTokenTable()->ToJson(restored_tokens_json);
+        restored_controller.GetErrorTable()->ToJson(restored_errors_json);
+        CHECK(restored_tokens_json == tokens_json);
+        CHECK(restored_errors_json == errors_json);
+    }
+}
+
+// Checks that the results of the controller are those of a fresh parse of
+// text.
+void check_same_results(MizController& miz_controller,
+                        const std::string& text,
+                        const std::string& vctpath)
+{
+    mizcore::MizController expected_controller;
+    expected_controller.ExecBuffer(std::string_view(text), vctpath.c_str());
+    nlohmann::json tokens;
+    nlohmann::json expected_tokens;
+    miz_controller.GetTokenTable()->ToJson(tokens);
+    expected_controller.GetTokenTable()->ToJson(expected_tokens);
+    CHECK(tokens == expected_tokens);
+    nlohmann::json blocks;
+    nlohmann::json expected_blocks;
+    miz_controller.GetASTRoot()->ToJson(blocks);
+    expected_controller.GetASTRoot()->ToJson(expected_blocks);
+    CHECK(blocks == expected_blocks);
+    nlohmann::json errors;
+    nlohmann::json expected_errors;
+    miz_controller.GetErrorTable()->ToJson(errors);
+    expected_controller.GetErrorTable()->ToJson(expected_errors);
+    CHECK(errors == expected_errors);
+}
+
+TEST_CASE("test miz_controller incremental mode")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath =
+      (TEST_DIR().parent_path() / "parser" / "data" / "mml.vct").string();
+    std::ifstream ifs_miz(mizpath);
+    REQUIRE(ifs_miz.good());
+    std::string text((std::istreambuf_iterator<char>(ifs_miz)),
+                     std::istreambuf_iterator<char>());
+    mizcore::MizController miz_controller;
+    CHECK(!miz_controller.ExecEdit(0, 0, "", vctpath.c_str()));
+    miz_controller.SetIncrementalMode(true);
+    miz_controller.ExecBuffer(std::string_view(text), vctpath.c_str());
+    CHECK(!miz_controller.ExecEdit(text.size(), 1, "", vctpath.c_str()));
+
+    // The results of the edits are the same as those of the edited text.
+    size_t offset = text.find("theorem", text.find("begin"));
+    REQUIRE(offset != std::string::npos);
+    std::string edited_text = text;
+    for (std::string_view replacement : { "A1: 1 = 1;\n", "\n:: edited\n" }) {
+        REQUIRE(
+          miz_controller.ExecEdit(offset, 0, replacement, vctpath.c_str()));
+        edited_text.insert(offset, replacement);
+    }
+    check_same_results(miz_controller, edited_text, vctpath);
+
+    // The edit of the environ executes the edited text again.
+    size_t length = edited_text.size() - text.size();
+    REQUIRE(miz_controller.ExecEdit(offset, length, "", vctpath.c_str()));
+    REQUIRE(miz_controller.ExecEdit(0, 0, ":: edited\n", vctpath.c_str()));
+    REQUIRE(miz_controller.ExecEdit(0, 10, "", vctpath.c_str()));
+    test_miz_controller(miz_controller);
+
+    // The pipeline mode is ignored, so that the text is kept for the edits.
+    mizcore::MizController pipeline_controller;
+    pipeline_controller.SetIncrementalMode(true);
+    pipeline_controller.SetPipelineMode(true);
+    pipeline_controller.ExecBuffer(std::string_view(text), vctpath.c_str());
+    REQUIRE(
+      pipeline_controller.ExecEdit(offset, 0, "A1: 1 = 1;\n", vctpath.c_str()));
+    edited_text = text;
+    edited_text.insert(offset, "A1: 1 = 1;\n");
+    check_same_results(pipeline_controller, edited_text, vctpath);
+
+    // The streaming mode keeps no text.
+    mizcore::MizController streaming_controller;
+    streaming_controller.SetIncrementalMode(true);
+    streaming_controller.SetItemCallback(
+      [](const std::vector<ASTComponent*>&, const std::vector<ASTToken*>&) {});
+    streaming_controller.ExecBuffer(std::string_view(text), vctpath.c_str());
+    CHECK(!streaming_controller.ExecEdit(offset, 0, "", vctpath.c_str()));
+}
+
+TEST_CASE("test miz_controller pipeline mode")
+{
+    mizcore::MizController miz_controller;
+    miz_controller.SetPipelineMode(true);
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    miz_controller.ExecFile(mizpath.string().c_str(), vctpath.string().c_str());
+    test_miz_controller(miz_controller);
+
+    // The results are the same as those of the sequential mode, also for the
+    // articles with errors.
+    for (const char* article_name : { "abcmiz_0", "jgraph_4" }) {
+        auto article_path = TEST_DIR().parent_path() / "parser" / "data" /
+                            (std::string(article_name) + ".miz");
+        mizcore::MizController expected_controller;
+        expected_controller.ExecFile(article_path.string().c_str(),
+                                     vctpath.string().c_str());
+        miz_controller.ExecFile(article_path.string().c_str(),
+                                vctpath.string().c_str());
+
+        nlohmann::json json;
+        nlohmann::json expected_json;
+        miz_controller.GetTokenTable()->ToJson(json);
+        expected_controller.GetTokenTable()->ToJson(expected_json);
+        CHECK(json == expected_json);
+        json = nlohmann::json();
+        expected_json = nlohmann::json();
+        miz_controller.GetASTRoot()->ToJson(json);
+        expected_controller.GetASTRoot()->ToJson(expected_json);
+        CHECK(json == expected_json);
+        json = nlohmann::json();
+        expected_json = nlohmann::json();
+        miz_controller.GetErrorTable()->ToJson(json);
+        expected_controller.GetErrorTable()->ToJson(expected_json);
+        CHECK(json == expected_json);
+    }
+    CHECK(miz_controller.GetErrorTable()->GetErrorNum() > 0);
+}
+
+TEST_CASE("test miz_controller lexer exception")
+{
+    // The exception of the lexer reaches the caller in the pipeline mode as in
+    // the sequential mode.
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    for (bool is_pipeline_mode : { false, true }) {
+        ThrowingStreamBuf buf("environ\nbegin\nreserve x for set;\n");
+        std::istream is(&buf);
+        is.exceptions(std::ios::badbit);
+        mizcore::MizController miz_controller;
+        miz_controller.SetPipelineMode(is_pipeline_mode);
+        CHECK_THROWS_AS(miz_controller.ExecImpl(is, vctpath.string().c_str()),
+                        std::runtime_error);
+    }
+}
+
+TEST_CASE("test token queue cancellation")
+{
+    // The lexer blocked by the full queue is released when the parser stops
+    // receiving, and the tokens left are deleted.
+    auto token_queue = std::make_shared<mizcore::TokenQueue>(1);
+    std::thread pusher([&token_queue] {
+        for (int i = 0; i < 3; ++i) {
+            std::vector<ASTToken*> tokens = { new mizcore::UnknownToken(
+              1, 1, "x") };
+            token_queue->Push(tokens);
+        }
+        token_queue->Close();
+    });
+    std::vector<ASTToken*> tokens;
+    CHECK(token_queue->Pop(tokens));
+    REQUIRE(tokens.size() == 1);
+    delete tokens[0];
+    token_queue->Cancel();
+    pusher.join();
+}
+
+TEST_CASE("test miz_controller parallel mode")
+{
+    mizcore::MizController miz_controller;
+    miz_controller.SetParallelLexMode(true);
+    miz_controller.SetParallelResolveMode(true);
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    miz_controller.ExecFile(mizpath.string().c_str(), vctpath.string().c_str());
+    test_miz_controller(miz_controller);
+}
+
+TEST_CASE("test miz_controller streaming mode")
+{
+    mizcore::MizController miz_controller;
+    nlohmann::json children;
+    size_t token_num = 0;
+    miz_controller.SetItemCallback(
+      [&children, &token_num](const std::vector<ASTComponent*>& components,
+                              const std::vector<ASTToken*>& tokens) {
+          for (auto* component : components) {
+              nlohmann::json child_json;
+              component->ToJson(child_json);
+              children.push_back(child_json);
+          }
+          token_num += tokens.size();
+      });
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    miz_controller.ExecFile(mizpath.string().c_str(), vctpath.string().c_str());
+
+    // Every item has been emitted and released.
+    auto token_table = miz_controller.GetTokenTable();
+    CHECK(token_num == token_table->GetTokenNum());
+    CHECK(token_table->GetFirstTokenId() == token_table->GetTokenNum());
+    REQUIRE(token_table->GetTokenNum() > 0);
+    CHECK(token_table->GetToken(0) == nullptr);
+    CHECK(token_table->GetToken(token_table->GetTokenNum() - 1) == nullptr);
+    CHECK(token_table->GetToken(token_table->GetTokenNum()) == nullptr);
+
+    nlohmann::json json;
+    miz_controller.GetASTRoot()->ToJson(json);
+    json["children"] = children;
+    test_blocks_json(json);
+}
+
+// Collects the error flags of component and its descendants in pre-order.
+void collect_error_flags(const ASTComponent* component,
+                         std::vector<bool>& error_flags)
+{
+    error_flags.push_back(component->IsError());
+    if (component->GetElementType() != mizcore::ELEMENT_TYPE::BLOCK) {
+        return;
+    }
+    const auto* block = static_cast<const mizcore::ASTBlock*>(component);
+    for (size_t i = 0; i < block->GetChildComponentNum(); ++i) {
+        collect_error_flags(block->GetChildComponent(i), error_flags);
+    }
+}
+
+TEST_CASE("test miz_controller streaming mode with errors")
+{
+    // The emitted items are the same as those of the normal mode, also for the
+    // articles with errors.
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    for (const char* article_name : { "abcmiz_0", "jgraph_4" }) {
+        auto article_path = TEST_DIR().parent_path() / "parser" / "data" /
+                            (std::string(article_name) + ".miz");
+        mizcore::MizController expected_controller;
+        expected_controller.ExecFile(article_path.string().c_str(),
+                                     vctpath.string().c_str());
+
+        mizcore::MizController miz_controller;
+        nlohmann::json children;
+        nlohmann::json tokens;
+        std::vector<bool> error_flags;
+        miz_controller.SetItemCallback(
+          [&children, &tokens, &error_flags](
+            const std::vector<ASTComponent*>& components,
+            const std::vector<ASTToken*>& emitted_tokens) {
+              for (auto* component : components) {
+                  nlohmann::json child_json;
+                  component->ToJson(child_json);
+                  children.push_back(child_json);
+                  collect_error_flags(component, error_flags);
+              }
+              for (auto* token : emitted_tokens) {
+                  nlohmann::json token_json;
+                  token->ToJson(token_json);
+                  tokens.push_back(token_json);
+              }
+          });
+        miz_controller.ExecFile(article_path.string().c_str(),
+                                vctpath.string().c_str());
+
+        auto expected_token_table = expected_controller.GetTokenTable();
+        nlohmann::json expected_tokens;
+        for (size_t i = 0; i < expected_token_table->GetTokenNum(); ++i) {
+            nlohmann::json token_json;
+            expected_token_table->GetToken(i)->ToJson(token_json);
+            expected_tokens.push_back(token_json);
+        }
+        CHECK(tokens == expected_tokens);
+
+        auto expected_root = expected_controller.GetASTRoot();
+        nlohmann::json expected_children;
+        std::vector<bool> expected_error_flags;
+        for (size_t i = 0; i < expected_root->GetChildComponentNum(); ++i) {
+            const auto* component = expected_root->GetChildComponent(i);
+            nlohmann::json child_json;
+            component->ToJson(child_json);
+            expected_children.push_back(child_json);
+            collect_error_flags(component, expected_error_flags);
+        }
+        CHECK(children == expected_children);
+        CHECK(error_flags == expected_error_flags);
+        CHECK(miz_controller.GetASTRoot()->IsError() ==
+              expected_root->IsError());
+
+        nlohmann::json errors;
+        nlohmann::json expected_errors;
+        miz_controller.GetErrorTable()->ToJson(errors);
+        expected_controller.GetErrorTable()->ToJson(expected_errors);
+        CHECK(errors == expected_errors);
+        CHECK(expected_controller.GetErrorTable()->GetErrorNum() > 0);
+    }
+}
+
+TEST_CASE("test miz_controller profiling mode")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    mizcore::MizController miz_controller;
+    CHECK(miz_controller.GetPhaseProfiler() == nullptr);
+    miz_controller.SetProfilingMode(true);
+    for (int i = 0; i < 2; ++i) {
+        miz_controller.ExecFile(mizpath.string().c_str(),
+                                vctpath.string().c_str());
+    }
+    test_miz_controller(miz_controller);
+
+    // The records of the last call only.
+    auto phase_profiler = miz_controller.GetPhaseProfiler();
+    auto phase_records = phase_profiler->GetPhaseRecords();
+    std::map<std::string, mizcore::PhaseRecord> name2record;
+    for (const auto& record : phase_records) {
+        CHECK(name2record.count(record.name_) == 0);
+        name2record[record.name_] = record;
+    }
+    CHECK(name2record.size() == 7);
+    CHECK(phase_records.front().name_ == "exec");
+    auto token_num = miz_controller.GetTokenTable()->GetTokenNum();
+    CHECK(name2record["exec"].token_num_ == token_num);
+    CHECK(name2record["lex"].token_num_ == token_num);
+    CHECK(name2record["parse"].token_num_ == token_num);
+    CHECK(name2record["parse"].block_num_ > 0);
+    CHECK(name2record["parse"].statement_num_ > 0);
+    CHECK(name2record.count("load_vocabulary") == 1);
+    CHECK(name2record.count("build_query_map") == 1);
+    CHECK(name2record.count("build_ast") == 1);
+    CHECK(name2record.count("resolve_identifier") == 1);
+    for (const auto& record : phase_records) {
+        CHECK(record.start_ns_ >= name2record["exec"].start_ns_);
+        CHECK(record.duration_ns_ <= name2record["exec"].duration_ns_);
+    }
+    // The allocation hook is linked to this test.
+    CHECK(name2record["lex"].allocation_num_ > 0);
+    CHECK(name2record["lex"].allocated_bytes_ > 0);
+
+    std::string trace;
+    {
+        mizcore::JsonWriter writer(trace);
+        phase_profiler->WriteChromeTrace(writer);
+    }
+    auto trace_json = nlohmann::json::parse(trace);
+    CHECK(trace_json["traceEvents"].size() == phase_records.size());
+
+    miz_controller.SetProfilingMode(false);
+    CHECK(miz_controller.GetPhaseProfiler() == nullptr);
+}
+
 TEST_CASE("test miz_controller CheckIsSeparableTokens")
 {
     auto mizpath = TEST_DIR() / "data" / "numerals.miz";
@@ -0,0 +1,132 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "doctest/doctest.h"
+#include "file_handling_tools.hpp"
+#include "miz_controller.hpp"
+#include "miz_server.hpp"
+#include "symbol_table.hpp"
+
+using mizcore::MizController;
+using mizcore::MizServer;
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path&
+TEST_DIR()
+{
+    static fs::path test_dir = fs::path(__FILE__).parent_path();
+    return test_dir;
+}
+
+nlohmann::json
+Call(MizServer& server, int id, const char* method, nlohmann::json params)
+{
+    nlohmann::json request = { { "jsonrpc", "2.0" },
+                               { "id", id },
+                               { "method", method },
+                               { "params", std::move(params) } };
+    auto response = nlohmann::json::parse(server.HandleMessage(request.dump()));
+    CHECK(response["id"] == id);
+    return response;
+}
+
+} // namespace
+
+TEST_CASE("test miz_server")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    std::ifstream ifs_miz(mizpath);
+    CHECK(ifs_miz.good());
+    std::string text((std::istreambuf_iterator<char>(ifs_miz)),
+                     std::istreambuf_iterator<char>());
+
+    MizServer server(MizController::LoadVocabulary(vctpath.string().c_str()));
+    nlohmann::json params = { { "uri", "numerals.miz" }, { "text", text } };
+
+    auto response = Call(server, 1, "open", params);
+    CHECK(response["result"]["is_reparsed"] == true);
+    CHECK(response["result"]["token_num"] > 0);
+
+    // An unchanged document is not parsed again.
+    response = Call(server, 2, "update", params);
+    CHECK(response["result"]["is_reparsed"] == false);
+    CHECK(server.GetParseNum() == 1);
+
+    nlohmann::json expected;
+    mizcore::read_json_file(expected,
+                            TEST_DIR() / "expected" / "numerals_blocks.json");
+    for (int i = 0; i < 2; ++i) {
+        response = Call(server, 3, "blocks", { { "uri", "numerals.miz" } });
+        CHECK(response["result"] == expected);
+    }
+    response = Call(server, 4, "errors", { { "uri", "numerals.miz" } });
+    CHECK(response["result"].empty());
+
+    response = Call(server, 5, "tokens", { { "uri", "unknown.miz" } });
+    CHECK(response["error"]["code"] == -32602);
+    response = Call(server, 6, "unknown", params);
+    CHECK(response["error"]["code"] == -32601);
+    response = nlohmann::json::parse(server.HandleMessage("{"));
+    CHECK(response["error"]["code"] == -32700);
+
+    // A failed open leaves no document.
+    nlohmann::json failed_params = { { "uri", "failed.miz" },
+                                     { "text", text },
+                                     { "abs", 1 } };
+    response = Call(server, 8, "open", failed_params);
+    CHECK(response["error"]["code"] == -32603);
+    CHECK(server.GetDocumentNum() == 1);
+    response = Call(server, 9, "tokens", { { "uri", "failed.miz" } });
+    CHECK(response["error"]["code"] == -32602);
+
+    // Notifications have no response.
+    CHECK(server
+            .HandleMessage(
+              R"({"jsonrpc":"2.0","method":"close","params":{"uri":"numerals.miz"}})")
+            .empty());
+    CHECK(server.GetDocumentNum() == 0);
+
+    Call(server, 7, "shutdown", nlohmann::json::object());
+    CHECK(server.IsShutdown());
+}
+
+TEST_CASE("test miz_server framing")
+{
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    MizServer server(MizController::LoadVocabulary(vctpath.string().c_str()));
+    std::string message;
+    bool has_header = false;
+
+    std::istringstream iss("{\"id\":1}\nContent-Length: 8\r\n\r\n{\"id\":2}");
+    REQUIRE(MizServer::ReadMessage(iss, message, has_header));
+    CHECK(message == "{\"id\":1}");
+    CHECK(!has_header);
+    REQUIRE(MizServer::ReadMessage(iss, message, has_header));
+    CHECK(message == "{\"id\":2}");
+    CHECK(has_header);
+    CHECK(!MizServer::ReadMessage(iss, message, has_header));
+
+    std::ostringstream oss;
+    MizServer::WriteMessage(oss, "{}", true);
+    CHECK(oss.str() == "Content-Length: 2\r\n\r\n{}");
+
+    // A body which can not be read is answered with a parse error, and the
+    // input ends after it.
+    for (const char* input : { "Content-Length: -1\r\n\r\n{}",
+                               "Content-Length: 99999999999999999999\r\n\r\n",
+                               "Content-Length: 1e3\r\n\r\n{}",
+                               "Content-Length: 100\r\n\r\n{\"id\":1}" }) {
+        std::istringstream bad_iss(input);
+        REQUIRE(MizServer::ReadMessage(bad_iss, message, has_header));
+        CHECK(message.empty());
+        CHECK(has_header);
+        auto response = nlohmann::json::parse(server.HandleMessage(message));
+        CHECK(response["error"]["code"] == -32700);
+        CHECK(!MizServer::ReadMessage(bad_iss, message, has_header));
+    }
+}
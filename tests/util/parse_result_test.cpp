@@ -0,0 +1,190 @@
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "ast_block.hpp"
+#include "ast_token.hpp"
+#include "doctest/doctest.h"
+#include "error_object.hpp"
+#include "error_table.hpp"
+#include "mapped_parse_result.hpp"
+#include "miz_controller.hpp"
+#include "parse_result_format.hpp"
+#include "parse_result_reader.hpp"
+#include "parse_result_writer.hpp"
+#include "symbol_table.hpp"
+#include "token_table.hpp"
+
+using mizcore::ErrorRecord;
+using mizcore::MappedParseResult;
+using mizcore::MizController;
+using mizcore::ParseResultReader;
+using mizcore::ParseResultWriter;
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path&
+TEST_DIR()
+{
+    static fs::path test_dir = fs::path(__FILE__).parent_path();
+    return test_dir;
+}
+
+} // namespace
+
+TEST_CASE("test parse result writer and readers")
+{
+    auto mizpath = TEST_DIR() / "data" / "numerals.miz";
+    auto vctpath = TEST_DIR().parent_path() / "parser" / "data" / "mml.vct";
+    MizController miz_controller;
+    miz_controller.ExecFile(mizpath.string().c_str(), vctpath.string().c_str());
+    auto token_table = miz_controller.GetTokenTable();
+    auto ast_root = miz_controller.GetASTRoot();
+    auto error_table = miz_controller.GetErrorTable();
+
+    ParseResultWriter writer(token_table, ast_root, error_table);
+    writer.SetKey(1234);
+    writer.SetFileNames({ "NUMERALS", "ORDINAL1" });
+    std::string data;
+    writer.Write(data);
+
+    SUBCASE("restore from the data")
+    {
+        ParseResultReader reader(data);
+        CHECK(reader.IsValid());
+        CHECK(reader.GetKey() == 1234);
+        CHECK(reader.GetFileNames().size() == 2);
+        // The symbols cannot be restored without the vocabulary.
+        CHECK(!reader.Restore(
+          [](std::string_view, mizcore::SYMBOL_TYPE, uint8_t) {
+              return static_cast<mizcore::Symbol*>(nullptr);
+          }));
+
+        std::map<std::pair<std::string_view, mizcore::SYMBOL_TYPE>,
+                 mizcore::Symbol*>
+          symbols;
+        for (size_t i = 0; i < token_table->GetTokenNum(); ++i) {
+            auto* token = token_table->GetToken(i);
+            if (token->GetTokenType() == mizcore::TOKEN_TYPE::SYMBOL) {
+                auto* symbol_token = static_cast<mizcore::SymbolToken*>(token);
+                symbols[{ token->GetText(), symbol_token->GetSymbolType() }] =
+                  symbol_token->GetSymbol();
+            }
+        }
+        auto resolver = [&symbols](std::string_view text,
+                                   mizcore::SYMBOL_TYPE type,
+                                   uint8_t) -> mizcore::Symbol* {
+            auto it = symbols.find({ text, type });
+            return it == symbols.end() ? nullptr : it->second;
+        };
+        CHECK(reader.Restore(resolver));
+        nlohmann::json expected_tokens;
+        nlohmann::json tokens;
+        token_table->ToJson(expected_tokens);
+        reader.GetTokenTable()->ToJson(tokens);
+        CHECK(tokens == expected_tokens);
+        nlohmann::json expected_blocks;
+        nlohmann::json blocks;
+        ast_root->ToJson(expected_blocks);
+        reader.GetASTRoot()->ToJson(blocks);
+        CHECK(blocks == expected_blocks);
+        nlohmann::json expected_errors;
+        nlohmann::json errors;
+        error_table->ToJson(expected_errors);
+        reader.GetErrorTable()->ToJson(errors);
+        CHECK(errors == expected_errors);
+    }
+
+    SUBCASE("reject broken data")
+    {
+        for (size_t n : { size_t(0), size_t(47), data.size() / 2,
+                          data.size() - 1 }) {
+            ParseResultReader reader(std::string_view(data.data(), n));
+            CHECK(!reader.IsValid());
+        }
+        std::string broken_data = data;
+        broken_data[4] = 0x7f; // format version
+        CHECK(!ParseResultReader(broken_data).IsValid());
+    }
+
+    SUBCASE("reject broken error records")
+    {
+        auto errors = std::make_shared<mizcore::ErrorTable>();
+        errors->AddError(new mizcore::ErrorObject(
+          mizcore::ERROR_TYPE::TOKEN_IS_UNKNOWN, token_table->GetToken(0)));
+        ParseResultWriter error_writer(token_table, ast_root, errors);
+        std::string error_data;
+        error_writer.Write(error_data);
+        CHECK(ParseResultReader(error_data).IsValid());
+
+        mizcore::ParseResultSections sections;
+        REQUIRE(mizcore::LocateParseResultSections(error_data, sections));
+        size_t offset = reinterpret_cast<const char*>(sections.error_records_) -
+                        error_data.data();
+        auto last_type =
+          static_cast<uint32_t>(mizcore::ERROR_TYPE::TOKEN_IS_UNKNOWN);
+        for (auto record : { ErrorRecord{ 0, 0 },
+                             ErrorRecord{ 998, 0 },
+                             ErrorRecord{ last_type + 1, 0 },
+                             ErrorRecord{ last_type,
+                                          mizcore::PARSE_RESULT_NO_ID } }) {
+            std::string broken_data = error_data;
+            std::memcpy(&broken_data[offset], &record, sizeof(record));
+            CHECK(!ParseResultReader(broken_data).IsValid());
+        }
+    }
+
+    SUBCASE("query the mapped file")
+    {
+        if (!fs::exists(TEST_DIR() / "result")) {
+            fs::create_directory(TEST_DIR() / "result");
+        }
+        auto path = TEST_DIR() / "result" / "numerals.mzr";
+        CHECK(writer.WriteFile(path.string()));
+
+        MappedParseResult mapped_result;
+        CHECK(mapped_result.Open(path.string()));
+        CHECK(mapped_result.GetKey() == 1234);
+        CHECK(mapped_result.GetTokenNum() == token_table->GetTokenNum());
+        CHECK(mapped_result.GetErrorNum() == error_table->GetErrorNum());
+        for (size_t i = 0; i < token_table->GetTokenNum(); ++i) {
+            auto* token = token_table->GetToken(i);
+            auto mapped_token = mapped_result.GetToken(i);
+            CHECK(mapped_token.GetText() == token->GetText());
+            CHECK(mapped_token.GetTokenType() == token->GetTokenType());
+            CHECK(mapped_token.GetLineNumber() == token->GetLineNumber());
+            CHECK(mapped_token.GetColumnNumber() == token->GetColumnNumber());
+            auto* ref_token = token->GetRefToken();
+            auto mapped_ref_token = mapped_token.GetRefToken();
+            CHECK(mapped_ref_token.has_value() == (ref_token != nullptr));
+            if (ref_token != nullptr && mapped_ref_token) {
+                CHECK(mapped_ref_token->GetId() == ref_token->GetId());
+            }
+        }
+
+        auto mapped_root = mapped_result.GetASTRoot();
+        CHECK(!mapped_root.GetParent());
+        CHECK(mapped_root.GetBlockType() == ast_root->GetBlockType());
+        size_t n = ast_root->GetChildComponentNum();
+        CHECK(mapped_root.GetChildComponentNum() == n);
+        auto mapped_child = mapped_root.GetFirstChildComponent();
+        for (size_t i = 0; i < n && mapped_child; ++i) {
+            auto* child = ast_root->GetChildComponent(i);
+            CHECK(mapped_child->GetElementType() == child->GetElementType());
+            CHECK(mapped_child->GetRangeFirstToken()->GetId() ==
+                  child->GetRangeFirstToken()->GetId());
+            CHECK(mapped_child->GetRangeLastToken()->GetId() ==
+                  child->GetRangeLastToken()->GetId());
+            CHECK(mapped_child->GetParent()->GetId() == 0);
+            mapped_child = mapped_child->GetNextSiblingComponent();
+        }
+        CHECK(!mapped_child);
+
+        mapped_result.Close();
+        CHECK(!mapped_result.IsOpen());
+        fs::remove(path);
+    }
+}